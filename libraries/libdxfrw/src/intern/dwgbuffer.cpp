@@ -12,6 +12,22 @@
 
 
 #include "dwgbuffer.h"
+#include <cstdint>
+#include <cstring>
+#ifdef DRW_WIN
+#  ifndef WIN32_LEAN_AND_MEAN
+#    define WIN32_LEAN_AND_MEAN
+#  endif
+#  ifndef NOMINMAX
+#    define NOMINMAX
+#  endif
+#  include <windows.h>
+#else
+#  include <fcntl.h>
+#  include <sys/mman.h>
+#  include <sys/stat.h>
+#  include <unistd.h>
+#endif
 #include "../libdwgr.h"
 #include "drw_textcodec.h"
 #include "drw_dbg.h"
@@ -123,6 +139,104 @@ bool dwgFileStream::read(duint8* s, duint64 n){
     return stream->good();
 }
 
+/** Read-only memory map of a file, unmapped when the last stream is gone */
+class dwgFileMap {
+public:
+    explicit dwgFileMap(const std::string &fileName);
+    ~dwgFileMap();
+    dwgFileMap(const dwgFileMap&) = delete;
+    dwgFileMap& operator=(const dwgFileMap&) = delete;
+
+    const duint8 *data{nullptr};
+    duint64 size{0};
+#ifdef DRW_WIN
+private:
+    HANDLE file{INVALID_HANDLE_VALUE};
+    HANDLE mapping{nullptr};
+#endif
+};
+
+#ifdef DRW_WIN
+dwgFileMap::dwgFileMap(const std::string &fileName){
+    file = CreateFileA(fileName.c_str(), GENERIC_READ, FILE_SHARE_READ, nullptr,
+                       OPEN_EXISTING, FILE_FLAG_RANDOM_ACCESS, nullptr);
+    if (file == INVALID_HANDLE_VALUE)
+        return;
+    LARGE_INTEGER fileSize;
+    if (!GetFileSizeEx(file, &fileSize) || fileSize.QuadPart <= 0
+            || static_cast<unsigned long long>(fileSize.QuadPart) > SIZE_MAX)
+        return;
+    mapping = CreateFileMappingA(file, nullptr, PAGE_READONLY, 0, 0, nullptr);
+    if (!mapping)
+        return;
+    data = static_cast<const duint8*>(MapViewOfFile(mapping, FILE_MAP_READ, 0, 0, 0));
+    if (data)
+        size = fileSize.QuadPart;
+}
+
+dwgFileMap::~dwgFileMap(){
+    if (data)
+        UnmapViewOfFile(data);
+    if (mapping)
+        CloseHandle(mapping);
+    if (file != INVALID_HANDLE_VALUE)
+        CloseHandle(file);
+}
+#else
+dwgFileMap::dwgFileMap(const std::string &fileName){
+    int fd = open(fileName.c_str(), O_RDONLY);
+    if (fd < 0)
+        return;
+    struct stat st;
+    if (fstat(fd, &st) == 0 && st.st_size > 0
+            && static_cast<unsigned long long>(st.st_size) <= SIZE_MAX) {
+        void *m = mmap(nullptr, st.st_size, PROT_READ, MAP_PRIVATE, fd, 0);
+        if (m != MAP_FAILED) {
+            data = static_cast<const duint8*>(m);
+            size = st.st_size;
+        }
+    }
+    //the mapping stays valid after closing the file
+    close(fd);
+}
+
+dwgFileMap::~dwgFileMap(){
+    if (data)
+        munmap(const_cast<duint8*>(data), size);
+}
+#endif
+
+dwgMappedStream *dwgMappedStream::create(const std::string &fileName){
+    std::shared_ptr<dwgFileMap> m = std::make_shared<dwgFileMap>(fileName);
+    if (!m->data)
+        return nullptr;
+    return new dwgMappedStream(m);
+}
+
+dwgMappedStream::dwgMappedStream(const std::shared_ptr<dwgFileMap> &m)
+    :fileMap{m}
+    ,stream{m->data}
+    ,sz{m->size}
+{}
+
+bool dwgMappedStream::setPos(duint64 p){
+    if (p >= sz)
+        return false;
+
+    pos = p;
+    return true;
+}
+
+bool dwgMappedStream::read(duint8* s, duint64 n){
+    if ( n > (sz - pos) ) {
+        isOk = false;
+        return false;
+    }
+    memcpy(s, stream + pos, n);
+    pos += n;
+    return true;
+}
+
 bool dwgCharStream::setPos(duint64 p){
     if (p > size()) {
         isOk = false;
@@ -138,9 +252,8 @@ bool dwgCharStream::read(duint8* s, duint64 n){
         isOk = false;
         return false;
     }
-    for (duint64 i=0; i<n; i++){
-        s[i]= stream[pos++];
-    }
+    memcpy(s, stream + pos, n);
+    pos += n;
     return true;
 }
 
@@ -156,6 +269,17 @@ dwgBuffer::dwgBuffer(std::ifstream *stream, DRW_TextCodec *dc)
     ,maxSize{filestr->size()}
 {}
 
+dwgBuffer::dwgBuffer(std::ifstream *stream, const std::string &fileName, DRW_TextCodec *dc)
+    :decoder{dc}
+    ,filestr{dwgMappedStream::create(fileName)}
+{
+    if (!filestr) {
+        DRW_DBG("\ndwgBuffer: memory map failed, reading the file stream\n");
+        filestr.reset(new dwgFileStream(stream));
+    }
+    maxSize = filestr->size();
+}
+
 dwgBuffer::dwgBuffer( const dwgBuffer& org )
     :decoder{org.decoder}
     ,filestr{org.filestr->clone()}
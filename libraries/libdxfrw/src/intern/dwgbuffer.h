@@ -54,6 +54,31 @@ private:
     duint64 sz{0};
 };
 
+class dwgFileMap;
+
+/**
+ * Reads a read-only memory map of the whole file, shared with the clones.
+ * Random access is a plain copy from memory, without stream operations.
+ */
+class dwgMappedStream: public dwgBasicStream{
+public:
+    //returns nullptr if the file can not be mapped
+    static dwgMappedStream *create(const std::string &fileName);
+    bool read(duint8* s, duint64 n) override;
+    duint64 size() const override {return sz;}
+    duint64 getPos() const override {return pos;}
+    bool setPos(duint64 p) override;
+    bool good() const override {return isOk;}
+    dwgBasicStream* clone() const override {return new dwgMappedStream(fileMap);}
+private:
+    explicit dwgMappedStream(const std::shared_ptr<dwgFileMap> &m);
+    std::shared_ptr<dwgFileMap> fileMap;
+    const duint8 *stream{nullptr};
+    duint64 sz{0};
+    duint64 pos{0};
+    bool isOk{true};
+};
+
 class dwgCharStream: public dwgBasicStream{
 public:
     dwgCharStream(duint8 *buf, duint64 s)
@@ -76,6 +101,8 @@ private:
 class dwgBuffer {
 public:
     dwgBuffer(std::ifstream *stream, DRW_TextCodec *decoder = nullptr);
+    //maps fileName into memory, reads stream if the mapping fails
+    dwgBuffer(std::ifstream *stream, const std::string &fileName, DRW_TextCodec *decoder = nullptr);
     dwgBuffer(duint8 *buf, duint64 size, DRW_TextCodec *decoder= nullptr);
     dwgBuffer( const dwgBuffer& org );
     dwgBuffer& operator=( const dwgBuffer& org );
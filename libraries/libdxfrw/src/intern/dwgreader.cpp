@@ -10,11 +10,14 @@
 **  along with this program.  If not, see <http://www.gnu.org/licenses/>.    **
 ******************************************************************************/
 
+#include <algorithm>
+#include <atomic>
 #include <cstdlib>
 #include <iostream>
 #include <fstream>
 #include <string>
 #include <sstream>
+#include <thread>
 #include "dwgreader.h"
 #include "drw_textcodec.h"
 #include "drw_dbg.h"
@@ -913,6 +916,13 @@ bool dwgReader::readDwgEntities(DRW_Interface& intfa, dwgBuffer *dbuf){
     bool ret = true;
 
     DRW_DBG("\nobject map total size= "); DRW_DBG(ObjectMap.size());
+    unsigned int threads = decodeThreads;
+    if (threads == 0)
+        threads = std::max(1u, std::thread::hardware_concurrency());
+    //debug output of parallel decoding would be interleaved
+    if (threads > 1 && DRW_DBGGL == DRW_dbg::Level::None)
+        return readDwgEntitiesParallel(intfa, dbuf, threads);
+
     auto itB=ObjectMap.begin();
     auto itE=ObjectMap.end();
     while (itB != itE) {
@@ -926,6 +936,260 @@ bool dwgReader::readDwgEntities(DRW_Interface& intfa, dwgBuffer *dbuf){
     return ret;
 }
 
+/**
+ * Reads the entities like readDwgEntities(), but decodes batches of them on
+ * threads before they are sent to the interface in the same order.
+ * Entities which fail to decode, polylines and objects take the serial path.
+ */
+bool dwgReader::readDwgEntitiesParallel(DRW_Interface& intfa, dwgBuffer *dbuf, unsigned int threads){
+    const size_t batchSize = 4096;
+    bool ret = true;
+    //prefetch with an own position and state, a failure is met by the serial path
+    dwgBuffer prefetchBuf(*dbuf);
+    std::vector<decodedEntity> batch;
+
+    while (!ObjectMap.empty()) {
+        batch.clear();
+        for (auto it = ObjectMap.begin(); it != ObjectMap.end() && batch.size() < batchSize; ++it)
+            batch.emplace_back(it->second);
+
+        if (ret) {
+            for (decodedEntity &d: batch) {
+                if (!readEntityData(&prefetchBuf, d))
+                    break;
+            }
+            std::atomic<size_t> next{0};
+            auto decode = [this, &batch, &next]() {
+                for (size_t i = next++; i < batch.size(); i = next++)
+                    decodeEntity(batch[i]);
+            };
+            std::vector<std::thread> workers;
+            for (unsigned int i = 1; i < threads && i < batch.size(); ++i)
+                workers.emplace_back(decode);
+            decode();
+            for (std::thread &t: workers)
+                t.join();
+        }
+
+        for (decodedEntity &d: batch) {
+            //vertices are removed by their polyline
+            auto it = ObjectMap.find(d.obj.handle);
+            if (it == ObjectMap.end())
+                continue;
+            if (ret) {
+                if (d.entity) {
+                    it->second.type = d.type;
+                    nextEntLink = d.entity->nextEntLink;
+                    prevEntLink = d.entity->prevEntLink;
+                    sendEntity(d.type, *d.entity, intfa);
+                } else
+                    ret = readDwgEntity(dbuf, it->second, intfa);
+            }
+            ObjectMap.erase(it);
+        }
+    }
+    return ret;
+}
+
+/**
+ * Reads the data of an entity for decodeEntity()
+ * @return false if the location or the size is bad
+ */
+bool dwgReader::readEntityData(dwgBuffer *dbuf, decodedEntity &d){
+    dbuf->setPosition(d.obj.loc);
+    if (!dbuf->isGood())
+        return false;
+    int size = dbuf->getModularShort();
+    if (version > DRW::AC1021) {//2010+
+        d.bs = dbuf->getUModularChar();
+    }
+    if (size <= 0)
+        return false;
+    d.data.resize(size);
+    dbuf->getBytes(d.data.data(), size);
+    if (!dbuf->isGood()) {
+        d.data.clear();
+        return false;
+    }
+    return true;
+}
+
+/**
+ * Decodes the data of an entity read by readEntityData(). Only reads the
+ * tables and is called concurrently for the entities of a batch.
+ */
+void dwgReader::decodeEntity(decodedEntity &d){
+    if (d.data.empty())
+        return;
+    dwgBuffer buff(d.data.data(), d.data.size(), &decoder);
+    dint16 oType = buff.getObjType(version);
+    buff.resetPosition();
+
+    if (oType > 499){
+        auto it = classesmap.find(oType);
+        if (it == classesmap.end())
+            return;
+        if (it->second->dwgType != 0)
+            oType = it->second->dwgType;
+    }
+    std::unique_ptr<DRW_Entity> e{newEntity(oType)};
+    if (e && e->parseDwg(version, &buff, d.bs)) {
+        parseAttribs(e.get());
+        d.type = oType;
+        d.entity = std::move(e);
+    }
+}
+
+/**
+ * Creates the entity for a dwg object type, nullptr for polylines, which
+ * read their vertices, and for objects or types not supported as entity.
+ */
+DRW_Entity *dwgReader::newEntity(dint16 oType){
+    switch (oType) {
+        case 17: return new DRW_Arc;
+        case 18: return new DRW_Circle;
+        case 19: return new DRW_Line;
+        case 27: return new DRW_Point;
+        case 35: return new DRW_Ellipse;
+        case 7:
+        case 8: return new DRW_Insert;//minsert = 8
+        case 77: return new DRW_LWPolyline;
+        case 1: return new DRW_Text;
+        case 44: return new DRW_MText;
+        case 28: return new DRW_3Dface;
+        case 20: return new DRW_DimOrdinate;
+        case 21: return new DRW_DimLinear;
+        case 22: return new DRW_DimAligned;
+        case 23: return new DRW_DimAngular3p;
+        case 24: return new DRW_DimAngular;
+        case 25: return new DRW_DimRadial;
+        case 26: return new DRW_DimDiametric;
+        case 45: return new DRW_Leader;
+        case 31: return new DRW_Solid;
+        case 78: return new DRW_Hatch;
+        case 32: return new DRW_Trace;
+        case 34: return new DRW_Viewport;
+        case 36: return new DRW_Spline;
+        case 40: return new DRW_Ray;
+//        case 30: MESH (not pline)
+        case 41: return new DRW_Xline;
+        case 101: return new DRW_Image;
+        default: return nullptr;
+    }
+}
+
+/**
+ * Sets the table names of an entity created by newEntity() and sends it to the interface
+ */
+void dwgReader::sendEntity(dint16 oType, DRW_Entity &ent, DRW_Interface& intfa){
+    switch (oType) {
+        case 17:
+            intfa.addArc(static_cast<DRW_Arc&>(ent));
+            break;
+        case 18:
+            intfa.addCircle(static_cast<DRW_Circle&>(ent));
+            break;
+        case 19:
+            intfa.addLine(static_cast<DRW_Line&>(ent));
+            break;
+        case 27:
+            intfa.addPoint(static_cast<DRW_Point&>(ent));
+            break;
+        case 35:
+            intfa.addEllipse(static_cast<DRW_Ellipse&>(ent));
+            break;
+        case 7:
+        case 8: {//minsert = 8
+            DRW_Insert &e = static_cast<DRW_Insert&>(ent);
+            e.name = findTableName(DRW::BLOCK_RECORD,
+                                   e.blockRecH.ref);//RLZ: find as block or blockrecord (ps & ps0)
+            intfa.addInsert(e);
+            break; }
+        case 77:
+            intfa.addLWPolyline(static_cast<DRW_LWPolyline&>(ent));
+            break;
+        case 1: {
+            DRW_Text &e = static_cast<DRW_Text&>(ent);
+            e.style = findTableName(DRW::STYLE, e.styleH.ref);
+            intfa.addText(e);
+            break; }
+        case 44: {
+            DRW_MText &e = static_cast<DRW_MText&>(ent);
+            e.style = findTableName(DRW::STYLE, e.styleH.ref);
+            intfa.addMText(e);
+            break; }
+        case 28:
+            intfa.add3dFace(static_cast<DRW_3Dface&>(ent));
+            break;
+        case 20: {
+            DRW_DimOrdinate &e = static_cast<DRW_DimOrdinate&>(ent);
+            e.style = findTableName(DRW::DIMSTYLE, e.dimStyleH.ref);
+            intfa.addDimOrdinate(&e);
+            break; }
+        case 21: {
+            DRW_DimLinear &e = static_cast<DRW_DimLinear&>(ent);
+            e.style = findTableName(DRW::DIMSTYLE, e.dimStyleH.ref);
+            intfa.addDimLinear(&e);
+            break; }
+        case 22: {
+            DRW_DimAligned &e = static_cast<DRW_DimAligned&>(ent);
+            e.style = findTableName(DRW::DIMSTYLE, e.dimStyleH.ref);
+            intfa.addDimAlign(&e);
+            break; }
+        case 23: {
+            DRW_DimAngular3p &e = static_cast<DRW_DimAngular3p&>(ent);
+            e.style = findTableName(DRW::DIMSTYLE, e.dimStyleH.ref);
+            intfa.addDimAngular3P(&e);
+            break; }
+        case 24: {
+            DRW_DimAngular &e = static_cast<DRW_DimAngular&>(ent);
+            e.style = findTableName(DRW::DIMSTYLE, e.dimStyleH.ref);
+            intfa.addDimAngular(&e);
+            break; }
+        case 25: {
+            DRW_DimRadial &e = static_cast<DRW_DimRadial&>(ent);
+            e.style = findTableName(DRW::DIMSTYLE, e.dimStyleH.ref);
+            intfa.addDimRadial(&e);
+            break; }
+        case 26: {
+            DRW_DimDiametric &e = static_cast<DRW_DimDiametric&>(ent);
+            e.style = findTableName(DRW::DIMSTYLE, e.dimStyleH.ref);
+            intfa.addDimDiametric(&e);
+            break; }
+        case 45: {
+            DRW_Leader &e = static_cast<DRW_Leader&>(ent);
+            e.style = findTableName(DRW::DIMSTYLE, e.dimStyleH.ref);
+            intfa.addLeader(&e);
+            break; }
+        case 31:
+            intfa.addSolid(static_cast<DRW_Solid&>(ent));
+            break;
+        case 78:
+            intfa.addHatch(static_cast<DRW_Hatch*>(&ent));
+            break;
+        case 32:
+            intfa.addTrace(static_cast<DRW_Trace&>(ent));
+            break;
+        case 34:
+            intfa.addViewport(static_cast<DRW_Viewport&>(ent));
+            break;
+        case 36:
+            intfa.addSpline(static_cast<DRW_Spline*>(&ent));
+            break;
+        case 40:
+            intfa.addRay(static_cast<DRW_Ray&>(ent));
+            break;
+        case 41:
+            intfa.addXline(static_cast<DRW_Xline&>(ent));
+            break;
+        case 101:
+            intfa.addImage(static_cast<DRW_Image*>(&ent));
+            break;
+        default:
+            break;
+    }
+}
+
 /**
  * Reads a dwg drawing entity (dwg object entity) given its offset in the file
  */
@@ -969,163 +1233,6 @@ bool dwgReader::readDwgEntity(dwgBuffer *dbuf, objHandle& obj, DRW_Interface& in
 
     obj.type = oType;
     switch (oType) {
-        case 17: {
-            DRW_Arc e;
-            if (entryParse( e, buff, bs, ret)) {
-                intfa.addArc(e);
-            }
-            break; }
-        case 18: {
-            DRW_Circle e;
-            if (entryParse( e, buff, bs, ret)) {
-                intfa.addCircle(e);
-            }
-            break; }
-        case 19:{
-            DRW_Line e;
-            if (entryParse( e, buff, bs, ret)) {
-                intfa.addLine(e);
-            }
-            break;}
-        case 27: {
-            DRW_Point e;
-            if (entryParse( e, buff, bs, ret)) {
-                intfa.addPoint(e);
-            }
-            break; }
-        case 35: {
-            DRW_Ellipse e;
-            if (entryParse( e, buff, bs, ret)) {
-                intfa.addEllipse(e);
-            }
-            break; }
-        case 7:
-        case 8: {//minsert = 8
-            DRW_Insert e;
-            if (entryParse( e, buff, bs, ret)) {
-                e.name = findTableName(DRW::BLOCK_RECORD,
-                                       e.blockRecH.ref);//RLZ: find as block or blockrecord (ps & ps0)
-                intfa.addInsert(e);
-            }
-            break; }
-        case 77: {
-            DRW_LWPolyline e;
-            if (entryParse( e, buff, bs, ret)) {
-                intfa.addLWPolyline(e);
-            }
-            break; }
-        case 1: {
-            DRW_Text e;
-            if (entryParse( e, buff, bs, ret)) {
-                e.style = findTableName(DRW::STYLE, e.styleH.ref);
-                intfa.addText(e);
-            }
-            break; }
-        case 44: {
-            DRW_MText e;
-            if (entryParse( e, buff, bs, ret)) {
-                e.style = findTableName(DRW::STYLE, e.styleH.ref);
-                intfa.addMText(e);
-            }
-            break; }
-        case 28: {
-            DRW_3Dface e;
-            if (entryParse( e, buff, bs, ret)) {
-                intfa.add3dFace(e);
-            }
-            break; }
-        case 20: {
-            DRW_DimOrdinate e;
-            if (entryParse( e, buff, bs, ret)) {
-                e.style = findTableName(DRW::DIMSTYLE, e.dimStyleH.ref);
-                intfa.addDimOrdinate(&e);
-            }
-            break; }
-        case 21: {
-            DRW_DimLinear e;
-            if (entryParse( e, buff, bs, ret)) {
-                e.style = findTableName(DRW::DIMSTYLE, e.dimStyleH.ref);
-                intfa.addDimLinear(&e);
-            }
-            break; }
-        case 22: {
-            DRW_DimAligned e;
-            if (entryParse( e, buff, bs, ret)) {
-                e.style = findTableName(DRW::DIMSTYLE, e.dimStyleH.ref);
-                intfa.addDimAlign(&e);
-            }
-            break; }
-        case 23: {
-            DRW_DimAngular3p e;
-            if (entryParse( e, buff, bs, ret)) {
-                e.style = findTableName(DRW::DIMSTYLE, e.dimStyleH.ref);
-                intfa.addDimAngular3P(&e);
-            }
-            break; }
-        case 24: {
-            DRW_DimAngular e;
-            if (entryParse( e, buff, bs, ret)) {
-                e.style = findTableName(DRW::DIMSTYLE, e.dimStyleH.ref);
-                intfa.addDimAngular(&e);
-            }
-            break; }
-        case 25: {
-            DRW_DimRadial e;
-            if (entryParse( e, buff, bs, ret)) {
-                e.style = findTableName(DRW::DIMSTYLE, e.dimStyleH.ref);
-                intfa.addDimRadial(&e);
-            }
-            break; }
-        case 26: {
-            DRW_DimDiametric e;
-            if (entryParse( e, buff, bs, ret)) {
-                e.style = findTableName(DRW::DIMSTYLE, e.dimStyleH.ref);
-                intfa.addDimDiametric(&e);
-            }
-            break; }
-        case 45: {
-            DRW_Leader e;
-            if (entryParse( e, buff, bs, ret)) {
-                e.style = findTableName(DRW::DIMSTYLE, e.dimStyleH.ref);
-                intfa.addLeader(&e);
-            }
-            break; }
-        case 31: {
-            DRW_Solid e;
-            if (entryParse( e, buff, bs, ret)) {
-                intfa.addSolid(e);
-            }
-            break; }
-        case 78: {
-            DRW_Hatch e;
-            if (entryParse( e, buff, bs, ret)) {
-                intfa.addHatch(&e);
-            }
-            break; }
-        case 32: {
-            DRW_Trace e;
-            if (entryParse( e, buff, bs, ret)) {
-                intfa.addTrace(e);
-            }
-            break; }
-        case 34: {
-            DRW_Viewport e;
-            if (entryParse( e, buff, bs, ret)) {
-                intfa.addViewport(e);
-            }
-            break; }
-        case 36: {
-            DRW_Spline e;
-            if (entryParse( e, buff, bs, ret)) {
-                intfa.addSpline(&e);
-            }
-            break; }
-        case 40: {
-            DRW_Ray e;
-            if (entryParse( e, buff, bs, ret)) {
-                intfa.addRay(e);
-            }
-            break; }
         case 15:    // pline 2D
         case 16:    // pline 3D
         case 29: {  // pline PFACE
@@ -1135,28 +1242,15 @@ bool dwgReader::readDwgEntity(dwgBuffer *dbuf, objHandle& obj, DRW_Interface& in
                 intfa.addPolyline(e);
             }
             break; }
-//        case 30: {
-//            DRW_Polyline e;// MESH (not pline)
-//            ENTRY_PARSE(e)
-//            intfa.addRay(e);
-//            break; }
-        case 41: {
-            DRW_Xline e;
-            if (entryParse( e, buff, bs, ret)) {
-                intfa.addXline(e);
+        default: {
+            std::unique_ptr<DRW_Entity> e{newEntity(oType)};
+            if (!e) {
+                //not supported or are object add to remaining map
+                objObjectMap[obj.handle]= obj;
+            } else if (entryParse( *e, buff, bs, ret)) {
+                sendEntity(oType, *e, intfa);
             }
             break; }
-        case 101: {
-            DRW_Image e;
-            if (entryParse( e, buff, bs, ret)) {
-                intfa.addImage(&e);
-            }
-            break; }
-
-        default:
-            //not supported or are object add to remaining map
-            objObjectMap[obj.handle]= obj;
-            break;
     }
     if (!ret){
         DRW_DBG("Warning: Entity type "); DRW_DBG(oType);DRW_DBG("has failed, handle: "); DRW_DBG(obj.handle); DRW_DBG("\n");
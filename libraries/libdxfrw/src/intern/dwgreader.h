@@ -16,6 +16,7 @@
 #include <unordered_map>
 #include <list>
 #include <memory>
+#include <vector>
 #include "drw_textcodec.h"
 #include "dwgutil.h"
 #include "dwgbuffer.h"
@@ -116,7 +117,7 @@ class dwgReader {
     friend class dwgR;
 public:
     dwgReader(std::ifstream *stream, dwgR *p)
-       :fileBuf{ new dwgBuffer(stream) }
+       :fileBuf{ new dwgBuffer(stream, p->getFileName()) }
        ,parent{p}
     {
         decoder.setVersion(DRW::AC1021, false);//default 2007 in utf8(no convert)
@@ -140,6 +141,8 @@ protected:
     virtual bool readDwgObjects(DRW_Interface& intfa) = 0;
 
     virtual bool readDwgEntity(dwgBuffer *dbuf, objHandle& obj, DRW_Interface& intfa);
+    DRW_Entity *newEntity(dint16 oType);
+    void sendEntity(dint16 oType, DRW_Entity &ent, DRW_Interface& intfa);
     bool readDwgObject(dwgBuffer *dbuf, objHandle& obj, DRW_Interface& intfa);
     void parseAttribs(DRW_Entity* e);
     std::string findTableName(DRW::TTYPE table, dint32 handle);
@@ -153,6 +156,7 @@ protected:
 
     bool readDwgBlocks(DRW_Interface& intfa, dwgBuffer *dbuf);
     bool readDwgEntities(DRW_Interface& intfa, dwgBuffer *dbuf);
+    bool readDwgEntitiesParallel(DRW_Interface& intfa, dwgBuffer *dbuf, unsigned int threads);
     bool readDwgObjects(DRW_Interface& intfa, dwgBuffer *dbuf);
     bool readPlineVertex(DRW_Polyline& pline, dwgBuffer *dbuf);
 
@@ -186,12 +190,27 @@ protected:
 protected:
     DRW_TextCodec decoder;
 
+    //threads decoding the entities, 0 for all cores
+    unsigned int decodeThreads{1};
+
 protected:
 //    duint32 blockCtrl;
     duint32 nextEntLink{0};
     duint32 prevEntLink{0};
 
 private:
+    //entity data read ahead for parallel decoding
+    struct decodedEntity {
+        explicit decodedEntity(const objHandle &o):obj{o} {}
+        objHandle obj;
+        std::vector<duint8> data;
+        duint32 bs{0};
+        dint16 type{0};
+        std::unique_ptr<DRW_Entity> entity;
+    };
+    bool readEntityData(dwgBuffer *dbuf, decodedEntity &d);
+    void decodeEntity(decodedEntity &d);
+
     template <class T>
     bool entryParse(T &e, dwgBuffer &buff, duint32 bs, bool &ret) {
         ret = e.parseDwg( version, &buff, bs);
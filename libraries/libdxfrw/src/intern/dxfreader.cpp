@@ -10,7 +10,9 @@
 **  along with this program.  If not, see <http://www.gnu.org/licenses/>.    **
 ******************************************************************************/
 
+#include <algorithm>
 #include <cstdlib>
+#include <cstring>
 #include <fstream>
 #include <string>
 #include <sstream>
@@ -18,6 +20,10 @@
 #include "drw_textcodec.h"
 #include "drw_dbg.h"
 
+bool dxfReader::good() const {
+    return filestr->good();
+}
+
 bool dxfReader::readRec(int *codeData) {
 //    std::string text;
     int code;
@@ -95,7 +101,7 @@ bool dxfReader::readRec(int *codeData) {
         //break in binary files because the conduct is unpredictable
         return false;
 
-    return (filestr->good());
+    return good();
 }
 int dxfReader::getHandleString(){
     int res;
@@ -204,28 +210,173 @@ bool dxfReaderBinary::readBool() {
     return (filestr->good());
 }
 
+namespace {
+//powers of ten which are exact doubles
+const double exactPowers[] = {1e0, 1e1, 1e2, 1e3, 1e4, 1e5, 1e6, 1e7, 1e8, 1e9, 1e10,
+                              1e11, 1e12, 1e13, 1e14, 1e15, 1e16, 1e17, 1e18, 1e19,
+                              1e20, 1e21, 1e22};
+
+bool isBlank(char c) {
+    return c == ' ' || c == '\t' || c == '\r' || c == '\n' || c == '\v' || c == '\f';
+}
+
+//same result as atoi()
+int parseInt(const char *s, const char *end) {
+    while (s < end && isBlank(*s))
+        ++s;
+    bool negative = false;
+    if (s < end && (*s == '-' || *s == '+'))
+        negative = (*s++ == '-');
+    long long value = 0;
+    for (; s < end && *s >= '0' && *s <= '9'; ++s)
+        value = value * 10 + (*s - '0');
+    return static_cast<int>(negative ? -value : value);
+}
+
+/**
+ * Parses a plain decimal number of at most 15 significant digits and a
+ * small exponent. Mantissa and power of ten are exact doubles then, so the
+ * single multiplication or division is correctly rounded.
+ * @return false, if the text needs the general conversion
+ */
+bool parseDouble(const char *s, const char *end, double *value) {
+    while (s < end && isBlank(*s))
+        ++s;
+    bool negative = false;
+    if (s < end && (*s == '-' || *s == '+'))
+        negative = (*s++ == '-');
+    unsigned long long mantissa = 0;
+    int digits = 0;
+    int zeros = 0; //pending zeros, not yet added to the mantissa
+    int exponent = 0;
+    bool fraction = false;
+    bool any = false;
+    for (; s < end; ++s) {
+        if (*s >= '0' && *s <= '9') {
+            any = true;
+            if (*s == '0') {
+                ++zeros;
+                ++exponent;
+            } else {
+                exponent -= zeros;
+                if (mantissa != 0)
+                    digits += zeros;
+                if (++digits > 15)
+                    return false;
+                for (; mantissa != 0 && zeros > 0; --zeros)
+                    mantissa *= 10;
+                zeros = 0;
+                mantissa = mantissa * 10 + (*s - '0');
+            }
+            if (fraction)
+                --exponent;
+        } else if (*s == '.' && !fraction) {
+            fraction = true;
+        } else
+            break;
+    }
+    if (!any)
+        return false;
+    if (s < end && (*s == 'e' || *s == 'E')) {
+        ++s;
+        bool negativeExp = false;
+        if (s < end && (*s == '-' || *s == '+'))
+            negativeExp = (*s++ == '-');
+        if (s == end || *s < '0' || *s > '9')
+            return false;
+        int e = 0;
+        for (; s < end && *s >= '0' && *s <= '9'; ++s) {
+            if (e > 1000)
+                return false;
+            e = e * 10 + (*s - '0');
+        }
+        exponent += negativeExp ? -e : e;
+    }
+    while (s < end && isBlank(*s))
+        ++s;
+    if (s != end)
+        return false;
+
+    double result = static_cast<double>(mantissa);
+    if (mantissa == 0)
+        result = 0.0;
+    else if (exponent >= 0 && exponent <= 22)
+        result *= exactPowers[exponent];
+    else if (exponent < 0 && exponent >= -22)
+        result /= exactPowers[-exponent];
+    else
+        return false;
+    *value = negative ? -result : result;
+    return true;
+}
+}
+
+bool dxfReaderAscii::fillBuffer() {
+    if (bufPos > 0) {
+        std::copy(buffer.begin() + bufPos, buffer.begin() + bufEnd, buffer.begin());
+        bufEnd -= bufPos;
+        bufPos = 0;
+    }
+    if (bufEnd == buffer.size())
+        buffer.resize(2 * buffer.size()); //line longer than the buffer
+    if (!filestr->good())
+        return false;
+    filestr->read(buffer.data() + bufEnd, buffer.size() - bufEnd);
+    size_t count = static_cast<size_t>(filestr->gcount());
+    bufEnd += count;
+    return count > 0;
+}
+
+bool dxfReaderAscii::readLine(const char **line, size_t *length) {
+    size_t scanned = 0;
+    for (;;) {
+        const char *start = buffer.data() + bufPos;
+        const char *newline = static_cast<const char *>(
+                    memchr(start + scanned, '\n', bufEnd - bufPos - scanned));
+        if (newline) {
+            *line = start;
+            *length = newline - start;
+            bufPos += *length + 1;
+            lineGood = true;
+            break;
+        }
+        scanned = bufEnd - bufPos;
+        if (!fillBuffer()) {
+            //last line without newline, like std::getline() at the end of file
+            *line = buffer.data() + bufPos;
+            *length = bufEnd - bufPos;
+            bufPos = bufEnd;
+            lineGood = false;
+            break;
+        }
+    }
+    if (*length > 0 && (*line)[*length - 1] == '\r')
+        --*length;
+    return lineGood;
+}
+
 bool dxfReaderAscii::readCode(int *code) {
-    std::string text;
-    std::getline(*filestr, text);
-    *code = atoi(text.c_str());
+    const char *line;
+    size_t length;
+    readLine(&line, &length);
+    *code = parseInt(line, line + length);
     DRW_DBG(*code); DRW_DBG("\n");
-    return (filestr->good());
+    return lineGood;
 }
 bool dxfReaderAscii::readString(std::string *text) {
     type = STRING;
-    std::getline(*filestr, *text);
-    if (!text->empty() && text->at(text->size()-1) == '\r')
-        text->erase(text->size()-1);
-    return (filestr->good());
+    const char *line;
+    size_t length;
+    readLine(&line, &length);
+    text->assign(line, length);
+    return lineGood;
 }
 
 bool dxfReaderAscii::readString() {
     type = STRING;
-    std::getline(*filestr, strData);
-    if (!strData.empty() && strData.at(strData.size()-1) == '\r')
-        strData.erase(strData.size()-1);
+    readString(&strData);
     DRW_DBG(strData); DRW_DBG("\n");
-    return (filestr->good());
+    return lineGood;
 }
 
 bool dxfReaderAscii::readBinary() {
@@ -234,9 +385,10 @@ bool dxfReaderAscii::readBinary() {
 
 bool dxfReaderAscii::readInt16() {
     type = INT32;
-    std::string text;
-    if (readString(&text)){
-        intData = atoi(text.c_str());
+    const char *line;
+    size_t length;
+    if (readLine(&line, &length)){
+        intData = parseInt(line, line + length);
         DRW_DBG(intData); DRW_DBG("\n");
         return true;
     } else
@@ -255,8 +407,14 @@ bool dxfReaderAscii::readInt64() {
 
 bool dxfReaderAscii::readDouble() {
     type = DOUBLE;
-    std::string text;
-    if (readString(&text)){
+    const char *line;
+    size_t length;
+    if (readLine(&line, &length)){
+        if (parseDouble(line, line + length, &doubleData)) {
+            DRW_DBG(doubleData); DRW_DBG('\n');
+            return true;
+        }
+        std::string text(line, length);
 #if defined(__APPLE__)
         int succeeded=sscanf( & (text[0]), "%lg", &doubleData);
         if(succeeded != 1) {
@@ -277,12 +435,12 @@ bool dxfReaderAscii::readDouble() {
 //saved as int or add a bool member??
 bool dxfReaderAscii::readBool() {
     type = BOOL;
-    std::string text;
-    if (readString(&text)){
-        intData = atoi(text.c_str());
+    const char *line;
+    size_t length;
+    if (readLine(&line, &length)){
+        intData = parseInt(line, line + length);
         DRW_DBG(intData); DRW_DBG("\n");
         return true;
     } else
         return false;
 }
-
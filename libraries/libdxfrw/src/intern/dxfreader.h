@@ -13,6 +13,7 @@
 #ifndef DXFREADER_H
 #define DXFREADER_H
 
+#include <vector>
 #include "drw_textcodec.h"
 
 class dxfReader {
@@ -49,6 +50,7 @@ public:
     void setIgnoreComments(const bool bValue) {m_bIgnoreComments = bValue;}
 
 protected:
+    virtual bool good() const; //state of the last read
     virtual bool readCode(int *code) = 0; //return true if successful (not EOF)
     virtual bool readString(std::string *text) = 0;
     virtual bool readString() = 0;
@@ -86,10 +88,15 @@ public:
     virtual bool readBool();
 };
 
+/**
+ * Reads ascii dxf files in large blocks and parses the group codes and
+ * values in place, without a stream operation or string per line.
+ */
 class dxfReaderAscii : public dxfReader {
 public:
-    dxfReaderAscii(std::ifstream *stream):dxfReader(stream){skip = true; }
+    dxfReaderAscii(std::ifstream *stream):dxfReader(stream), buffer(BUFFER_SIZE){skip = true; }
     virtual ~dxfReaderAscii(){}
+    virtual bool good() const {return lineGood;}
     virtual bool readCode(int *code);
     virtual bool readString(std::string *text);
     virtual bool readString();
@@ -99,6 +106,17 @@ public:
     virtual bool readInt32();
     virtual bool readInt64();
     virtual bool readBool();
+
+private:
+    //sets line to the next line without line end, false if it is not terminated by a newline
+    bool readLine(const char **line, size_t *length);
+    bool fillBuffer();
+
+    static const size_t BUFFER_SIZE = 256 * 1024;
+    std::vector<char> buffer;
+    size_t bufPos {0}; //start of the unread data
+    size_t bufEnd {0}; //end of the data read from the file
+    bool lineGood {true};
 };
 
 #endif // DXFREADER_H
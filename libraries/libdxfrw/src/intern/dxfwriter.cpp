@@ -10,6 +10,7 @@
 **  along with this program.  If not, see <http://www.gnu.org/licenses/>.    **
 ******************************************************************************/
 
+#include <cstdio>
 #include <cstdlib>
 #include <fstream>
 #include <string>
@@ -91,6 +92,10 @@
     return (filestr->good());
 }*/
 
+bool dxfWriter::flush() {
+    return filestr->good();
+}
+
 bool dxfWriter::writeUtf8String(int code, std::string text) {
     std::string t = encoder.fromUtf8(text);
     return writeString(code, t);
@@ -214,57 +219,96 @@ bool dxfWriterBinary::writeBool(int code, bool data) {
     return (filestr->good());
 }
 
+namespace {
+/** the buffer of dxfWriterAscii is written in blocks of this size */
+const std::string::size_type asciiBlockSize = 1 << 20;
+}
+
 dxfWriterAscii::dxfWriterAscii(std::ofstream *stream):dxfWriter(stream){
-    filestr->precision(16);
+    buffer.reserve(asciiBlockSize + 4096);
 }
 
-bool dxfWriterAscii::writeString(int code, std::string text) {
-//    *filestr << code << std::endl << text << std::endl ;
-    filestr->width(3);
-    *filestr << std::right << code << std::endl;
-    filestr->width(0);
-    *filestr << std::left << text << std::endl;
-    /*    std::getline(*filestr, strData, '\0');
-    DBG(strData); DBG("\n");*/
+dxfWriterAscii::~dxfWriterAscii(){
+    flush();
+}
+
+bool dxfWriterAscii::flush() {
+    if (!buffer.empty()) {
+        filestr->write(buffer.data(), buffer.size());
+        buffer.clear();
+    }
     return (filestr->good());
 }
 
-bool dxfWriterAscii::writeInt16(int code, int data) {
-//    *filestr << std::right << code << std::endl << data << std::endl;
-    filestr->width(3);
-    *filestr << std::right << code << std::endl;
-    filestr->width(5);
-    *filestr << data << std::endl;
+bool dxfWriterAscii::endRecord() {
+    if (buffer.size() >= asciiBlockSize)
+        return flush();
     return (filestr->good());
 }
 
+void dxfWriterAscii::appendInt(long long data, int width) {
+    if (data < 0)
+        appendUnsigned(0ULL - static_cast<unsigned long long>(data), width, true);
+    else
+        appendUnsigned(static_cast<unsigned long long>(data), width);
+}
+
+void dxfWriterAscii::appendUnsigned(unsigned long long data, int width, bool negative) {
+    char digits[24];
+    char *end = digits + sizeof(digits);
+    char *p = end;
+    do {
+        *--p = static_cast<char>('0' + data % 10);
+        data /= 10;
+    } while (data != 0);
+    if (negative)
+        *--p = '-';
+    if (end - p < width)
+        buffer.append(width - (end - p), ' ');
+    buffer.append(p, end);
+    buffer += '\n';
+}
+
+bool dxfWriterAscii::writeString(int code, std::string text) {
+    appendInt(code, 3);
+    buffer += text;
+    buffer += '\n';
+    return endRecord();
+}
+
+bool dxfWriterAscii::writeInt16(int code, int data) {
+    appendInt(code, 3);
+    appendInt(data, 5);
+    return endRecord();
+}
+
 bool dxfWriterAscii::writeInt32(int code, int data) {
     return writeInt16(code, data);
 }
 
 bool dxfWriterAscii::writeInt64(int code, unsigned long long int data) {
-//    *filestr << code << std::endl << data << std::endl;
-    filestr->width(3);
-    *filestr << std::right << code << std::endl;
-    filestr->width(5);
-    *filestr << data << std::endl;
-    return (filestr->good());
+    appendInt(code, 3);
+    appendUnsigned(data, 5);
+    return endRecord();
 }
 
 bool dxfWriterAscii::writeDouble(int code, double data) {
-//    std::streamsize prec = filestr->precision();
-//    filestr->precision(12);
-//    *filestr << code << std::endl << data << std::endl;
-    filestr->width(3);
-    *filestr << std::right << code << std::endl;
-    *filestr << data << std::endl;
-//    filestr->precision(prec);
-    return (filestr->good());
+    appendInt(code, 3);
+    //same as the stream with precision 16
+    char text[32];
+    int size = std::snprintf(text, sizeof(text), "%.16g", data);
+    if (size < 0 || size >= static_cast<int>(sizeof(text)))
+        size = 0;
+    //the decimal point of the C locale may differ from the stream's
+    std::replace(text, text + size, ',', '.');
+    buffer.append(text, size);
+    buffer += '\n';
+    return endRecord();
 }
 
 //saved as int or add a bool member??
 bool dxfWriterAscii::writeBool(int code, bool data) {
-    *filestr << code << std::endl << data << std::endl;
-    return (filestr->good());
+    appendInt(code, 0);
+    appendInt(data, 0);
+    return endRecord();
 }
-
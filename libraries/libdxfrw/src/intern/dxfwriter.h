@@ -13,6 +13,7 @@
 #ifndef DXFWRITER_H
 #define DXFWRITER_H
 
+#include <string>
 #include "drw_textcodec.h"
 
 class dxfWriter {
@@ -28,6 +29,8 @@ public:
     virtual bool writeInt64(int code, unsigned long long int data) = 0;
     virtual bool writeDouble(int code, double data) = 0;
     virtual bool writeBool(int code, bool data) = 0;
+    /** writes pending output to the stream */
+    virtual bool flush();
     void setVersion(const std::string &v, bool dxfFormat){encoder.setVersion(v, dxfFormat);}
     void setCodePage(const std::string &c){encoder.setCodePage(c, true);}
     std::string getCodePage(){return encoder.getCodePage();}
@@ -49,16 +52,28 @@ public:
     virtual bool writeBool(int code, bool data);
 };
 
+/**
+ * Writes the records into a buffer, which is written to the stream in large
+ * blocks. The output is the same as formatting the records with the stream.
+ */
 class dxfWriterAscii : public dxfWriter {
 public:
     dxfWriterAscii(std::ofstream *stream);
-    virtual ~dxfWriterAscii(){}
+    virtual ~dxfWriterAscii();
     virtual bool writeString(int code, std::string text);
     virtual bool writeInt16(int code, int data);
     virtual bool writeInt32(int code, int data);
     virtual bool writeInt64(int code, unsigned long long int data);
     virtual bool writeDouble(int code, double data);
     virtual bool writeBool(int code, bool data);
+    virtual bool flush();
+private:
+    /** appends data right aligned to width and a line break */
+    void appendInt(long long data, int width);
+    void appendUnsigned(unsigned long long data, int width, bool negative = false);
+    /** writes the buffer once it is large enough */
+    bool endRecord();
+    std::string buffer;
 };
 
 #endif // DXFWRITER_H
@@ -142,6 +142,7 @@ bool dwgR::read(DRW_Interface *interface_, bool ext){
     if (!isOk)
         return false;
 
+    reader->decodeThreads = decodeThreads;
     isOk = reader->readMetaData();
     if (isOk) {
         isOk = reader->readFileHeader();
@@ -33,8 +33,14 @@ public:
     bool getPreview();
     DRW::Version getVersion(){return version;}
     DRW::error getError(){return error;}
+    const std::string &getFileName() const {return fileName;}
 bool testReader();
     void setDebug(DRW::DebugLevel lvl);
+    /**
+     * Sets the number of threads decoding the entities, 0 uses all cores.
+     * The entities are sent to the interface in the same order. Default 1.
+     */
+    void setDecodeThreads(unsigned int threads){decodeThreads = threads;}
 
 private:
     bool openFile(std::ifstream *filestr);
@@ -46,6 +52,7 @@ private:
     DRW::error error { DRW::BAD_NONE };
     std::string fileName;
     bool applyExt { false }; /*apply extrusion in entities to conv in 2D?*/
+    unsigned int decodeThreads { 1 };
     std::string codePage;
     DRW_Interface *iface { nullptr };
     std::unique_ptr< dwgReader > reader;
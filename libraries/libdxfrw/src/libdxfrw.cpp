@@ -156,6 +156,7 @@ bool dxfRW::write(DRW_Interface *interface_, DRW::Version ver, bool bin){
         writer->writeString(0, "ENDSEC");
     }
     writer->writeString(0, "EOF");
+    writer->flush();
     filestr.flush();
     filestr.close();
     isOk = true;
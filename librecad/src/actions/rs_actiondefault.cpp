@@ -313,9 +313,6 @@ void RS_ActionDefault::mouseReleaseEvent(QMouseEvent* e) {
                 RS_Selection s(*container, graphicView);
                 s.selectSingle(en);
 
-                RS_DIALOGFACTORY->updateSelectionWidget(
-                            container->countSelected(),container->totalSelectedLength());
-
                 e->accept();
 
                 setStatus(Neutral);
@@ -338,9 +335,6 @@ void RS_ActionDefault::mouseReleaseEvent(QMouseEvent* e) {
             bool select = (e->modifiers() & Qt::ShiftModifier) ? false : true;
 			s.selectWindow(pPoints->v1, pPoints->v2, select, cross);
 
-            RS_DIALOGFACTORY->updateSelectionWidget(
-                        container->countSelected(),container->totalSelectedLength());
-
             setStatus(Neutral);
             e->accept();
             //}
@@ -49,8 +49,6 @@ void RS_ActionSelectAll::init(int status) {
 void RS_ActionSelectAll::trigger() {
     RS_Selection s(*container, graphicView);
     s.selectAll(select);
-
-    RS_DIALOGFACTORY->updateSelectionWidget(container->countSelected(),container->totalSelectedLength());
 }
 
 // EOF
@@ -50,8 +50,6 @@ void RS_ActionSelectContour::trigger() {
         if (en->isAtomic()) {
             RS_Selection s(*container, graphicView);
             s.selectContour(en);
-
-			RS_DIALOGFACTORY->updateSelectionWidget(container->countSelected(),container->totalSelectedLength());
 		} else
 			RS_DIALOGFACTORY->commandMessage(
 						tr("Entity must be an Atomic Entity."));
@@ -77,8 +77,6 @@ void RS_ActionSelectIntersected::trigger() {
             RS_Selection s(*container, graphicView);
 			s.selectIntersected(pPoints->v1, pPoints->v2, select);
 
-			RS_DIALOGFACTORY->updateSelectionWidget(container->countSelected(),container->totalSelectedLength());
-
             init();
         }
     }
@@ -46,8 +46,6 @@ void RS_ActionSelectInvert::init(int status) {
 void RS_ActionSelectInvert::trigger() {
     RS_Selection s(*container, graphicView);
     s.invertSelection();
-
-    RS_DIALOGFACTORY->updateSelectionWidget(container->countSelected(),container->totalSelectedLength());
 }
 
 // EOF
@@ -55,8 +55,6 @@ void RS_ActionSelectSingle::trigger() {
 	if (en && typeMatch) {
         RS_Selection s(*container, graphicView);
         s.selectSingle(en);
-
-        RS_DIALOGFACTORY->updateSelectionWidget(container->countSelected(),container->totalSelectedLength());
     } else {
         RS_DEBUG->print("RS_ActionSelectSingle::trigger: Entity is NULL\n");
     }
@@ -80,8 +80,6 @@ void RS_ActionSelectWindow::trigger() {
             RS_Selection s(*container, graphicView);
 			s.selectWindow(pPoints->v1, pPoints->v2, select, cross);
 
-            RS_DIALOGFACTORY->updateSelectionWidget(container->countSelected(),container->totalSelectedLength());
-
             init();
         }
     }
@@ -41,6 +41,7 @@
 #include "rs_entitycontainer.h"
 #include "rs_pen.h"
 #include "rs_debug.h"
+#include "lc_trace.h"
 
 /**
   * Disable all snapping.
@@ -257,6 +258,7 @@ RS_Vector RS_Snapper::snapFree(QMouseEvent* e) {
  */
 RS_Vector RS_Snapper::snapPoint(QMouseEvent* e)
 {
+    LC_TRACE_SCOPE("snap", "RS_Snapper::snapPoint");
 	pImpData->snapSpot = RS_Vector(false);
     RS_Vector t(false);
 
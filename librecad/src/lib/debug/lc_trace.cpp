@@ -0,0 +1,123 @@
+/****************************************************************************
+**
+** This file is part of the LibreCAD project, a 2D CAD program
+**
+** Copyright (C) 2020 librecad.org (www.librecad.org)
+**
+**
+** This file may be distributed and/or modified under the terms of the
+** GNU General Public License version 2 as published by the Free Software
+** Foundation and appearing in the file gpl-2.0.txt included in the
+** packaging of this file.
+**
+** This program is distributed in the hope that it will be useful,
+** but WITHOUT ANY WARRANTY; without even the implied warranty of
+** MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+** GNU General Public License for more details.
+**
+** You should have received a copy of the GNU General Public License
+** along with this program; if not, write to the Free Software
+** Foundation, Inc., 51 Franklin Street, Fifth Floor, Boston, MA  02110-1301  USA
+**
+** This copyright notice MUST APPEAR in all copies of the script!
+**
+**********************************************************************/
+
+#include <atomic>
+#include <chrono>
+#include <cstdio>
+#include <mutex>
+#include <vector>
+
+#include <QFile>
+#include <QString>
+
+#include "lc_trace.h"
+#include "rs_debug.h"
+
+std::atomic<bool> LC_Trace::enabled{false};
+
+namespace {
+struct Event {
+    const char* name;
+    const char* category;
+    long long begin;
+    long long end;
+    int thread;
+};
+
+std::mutex eventMutex;
+std::vector<Event> events;
+QString traceFileName;
+std::chrono::steady_clock::time_point startTime;
+
+/** small ids of the threads in the order they recorded their first event */
+int threadId()
+{
+    static std::atomic<int> threads{0};
+    thread_local int id = ++threads;
+    return id;
+}
+}
+
+bool LC_Trace::start(const QString& fileName)
+{
+    QFile f(fileName);
+    if (!f.open(QIODevice::WriteOnly)) {
+        RS_DEBUG->print(RS_Debug::D_WARNING,
+                        "LC_Trace::start: cannot write %s", qPrintable(fileName));
+        return false;
+    }
+    f.close();
+
+    std::lock_guard<std::mutex> lock(eventMutex);
+    traceFileName = fileName;
+    events.clear();
+    events.reserve(1 << 16);
+    startTime = std::chrono::steady_clock::now();
+    enabled = true;
+    return true;
+}
+
+void LC_Trace::stop()
+{
+    if (!enabled.exchange(false)) {
+        return;
+    }
+
+    std::lock_guard<std::mutex> lock(eventMutex);
+    FILE* f = std::fopen(QFile::encodeName(traceFileName).constData(), "w");
+    if (!f) {
+        RS_DEBUG->print(RS_Debug::D_WARNING,
+                        "LC_Trace::stop: cannot write %s", qPrintable(traceFileName));
+        return;
+    }
+    std::fprintf(f, "{\"traceEvents\":[\n");
+    for (size_t i = 0; i < events.size(); ++i) {
+        const Event& e = events[i];
+        std::fprintf(f, "{\"name\":\"%s\",\"cat\":\"%s\",\"ph\":\"X\","
+                        "\"ts\":%lld,\"dur\":%lld,\"pid\":1,\"tid\":%d}%s\n",
+                     e.name, e.category, e.begin, e.end - e.begin, e.thread,
+                     i + 1 < events.size() ? "," : "");
+    }
+    std::fprintf(f, "],\"displayTimeUnit\":\"ms\"}\n");
+    std::fclose(f);
+    events.clear();
+    events.shrink_to_fit();
+}
+
+long long LC_Trace::now()
+{
+    return std::chrono::duration_cast<std::chrono::microseconds>(
+                std::chrono::steady_clock::now() - startTime).count();
+}
+
+void LC_Trace::complete(const char* name, const char* category,
+                        long long begin, long long end)
+{
+    const int thread = threadId();
+    std::lock_guard<std::mutex> lock(eventMutex);
+    if (enabled) {
+        events.push_back({name, category, begin, end, thread});
+    }
+}
@@ -0,0 +1,108 @@
+/****************************************************************************
+**
+** This file is part of the LibreCAD project, a 2D CAD program
+**
+** Copyright (C) 2020 librecad.org (www.librecad.org)
+**
+**
+** This file may be distributed and/or modified under the terms of the
+** GNU General Public License version 2 as published by the Free Software
+** Foundation and appearing in the file gpl-2.0.txt included in the
+** packaging of this file.
+**
+** This program is distributed in the hope that it will be useful,
+** but WITHOUT ANY WARRANTY; without even the implied warranty of
+** MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+** GNU General Public License for more details.
+**
+** You should have received a copy of the GNU General Public License
+** along with this program; if not, write to the Free Software
+** Foundation, Inc., 51 Franklin Street, Fifth Floor, Boston, MA  02110-1301  USA
+**
+** This copyright notice MUST APPEAR in all copies of the script!
+**
+**********************************************************************/
+
+#ifndef LC_TRACE_H
+#define LC_TRACE_H
+
+#include <atomic>
+
+class QString;
+
+/**
+ * Tracing of the phases of LibreCAD, e.g. loading, regeneration, drawing,
+ * snapping and modifications, into a trace event file in the JSON format
+ * of Chrome (chrome://tracing, Perfetto).
+ *
+ * Tracing is started by the command line option --trace <file> and the
+ * events are written when it is stopped. While tracing is off, a trace
+ * scope costs a single check. Builds configured with qmake CONFIG+=no_trace
+ * define LC_NO_TRACE and have no trace scopes at all.
+ *
+ * Trace scopes may be entered on any thread, e.g. by the regeneration
+ * workers, while tracing is started or stopped.
+ */
+class LC_Trace {
+public:
+    /** Starts recording events, which are written to fileName by stop(). */
+    static bool start(const QString& fileName);
+    static void stop();
+
+    static bool isEnabled() {
+        return enabled;
+    }
+
+    /** @return microseconds since tracing was started */
+    static long long now();
+    /**
+     * Records an event of the calling thread from begin to end,
+     * name and category must be string literals.
+     */
+    static void complete(const char* name, const char* category,
+                         long long begin, long long end);
+
+private:
+    static std::atomic<bool> enabled;
+};
+
+/**
+ * Records the time from its construction to its destruction as an event,
+ * if tracing is enabled. Use LC_TRACE_SCOPE() instead of creating it.
+ */
+class LC_TraceScope {
+public:
+    LC_TraceScope(const char* category, const char* name):
+        name(LC_Trace::isEnabled() ? name : nullptr),
+        category(category),
+        begin(this->name ? LC_Trace::now() : 0)
+    {
+    }
+
+    ~LC_TraceScope() {
+        if (name) {
+            LC_Trace::complete(name, category, begin, LC_Trace::now());
+        }
+    }
+
+    LC_TraceScope(const LC_TraceScope&) = delete;
+    LC_TraceScope& operator = (const LC_TraceScope&) = delete;
+
+private:
+    const char* name;
+    const char* category;
+    long long begin;
+};
+
+#define LC_TRACE_CONCAT2(a, b) a##b
+#define LC_TRACE_CONCAT(a, b) LC_TRACE_CONCAT2(a, b)
+
+#ifdef LC_NO_TRACE
+#define LC_TRACE_SCOPE(category, name)
+#else
+/** traces the rest of the enclosing scope as event name of category */
+#define LC_TRACE_SCOPE(category, name) \
+    LC_TraceScope LC_TRACE_CONCAT(lcTraceScope, __LINE__)(category, name)
+#endif
+
+#endif
@@ -42,6 +42,21 @@ void debugHeader(char const* file, char const* func, int line);
 #define RS_DEBUG_VERBOSE DEBUG_HEADER \
 	RS_Debug::instance()
 
+/**
+ * Prints a message of the debugging level. Unlike RS_DEBUG->print(), the
+ * arguments are only evaluated at that level, which matters in hot paths.
+ * Builds with LC_NO_TRACE defined (qmake CONFIG+=no_trace) drop these
+ * messages.
+ */
+#ifdef LC_NO_TRACE
+#define RS_DEBUG_PRINT(...) do {} while (false)
+#else
+#define RS_DEBUG_PRINT(...) do { \
+	if (RS_DEBUG->getLevel() >= RS_Debug::D_DEBUGGING) \
+		RS_DEBUG->print(__VA_ARGS__); \
+	} while (false)
+#endif
+
 /**
  * Debugging facilities.
  *
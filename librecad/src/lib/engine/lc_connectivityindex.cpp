@@ -0,0 +1,143 @@
+/****************************************************************************
+**
+** This file is part of the LibreCAD project, a 2D CAD program
+**
+** Copyright (C) 2020 librecad.org (www.librecad.org)
+**
+**
+** This file may be distributed and/or modified under the terms of the
+** GNU General Public License version 2 as published by the Free Software
+** Foundation and appearing in the file gpl-2.0.txt included in the
+** packaging of this file.
+**
+** This program is distributed in the hope that it will be useful,
+** but WITHOUT ANY WARRANTY; without even the implied warranty of
+** MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+** GNU General Public License for more details.
+**
+** You should have received a copy of the GNU General Public License
+** along with this program; if not, write to the Free Software
+** Foundation, Inc., 51 Franklin Street, Fifth Floor, Boston, MA  02110-1301  USA
+**
+** This copyright notice MUST APPEAR in all copies of the script!
+**
+**********************************************************************/
+
+#include <algorithm>
+#include <cmath>
+#include <functional>
+#include <utility>
+
+#include "lc_connectivityindex.h"
+#include "rs_entity.h"
+
+namespace {
+/** cells of coordinates beyond this are clamped to keep them in range */
+const double maxCell = 1.0e15;
+}
+
+size_t LC_ConnectivityIndex::CellHash::operator () (const Cell& cell) const
+{
+    const unsigned long long x = static_cast<unsigned long long>(cell.x);
+    const unsigned long long y = static_cast<unsigned long long>(cell.y);
+    return std::hash<unsigned long long>()(x * 73856093ULL ^ y * 19349663ULL);
+}
+
+LC_ConnectivityIndex::LC_ConnectivityIndex(double tolerance):
+    tolerance(tolerance)
+{
+}
+
+double LC_ConnectivityIndex::getTolerance() const
+{
+    return tolerance;
+}
+
+LC_ConnectivityIndex::Cell LC_ConnectivityIndex::cellOf(const RS_Vector& point) const
+{
+    const double x = std::max(-maxCell, std::min(maxCell, std::floor(point.x / tolerance)));
+    const double y = std::max(-maxCell, std::min(maxCell, std::floor(point.y / tolerance)));
+    return {static_cast<long long>(x), static_cast<long long>(y)};
+}
+
+void LC_ConnectivityIndex::insert(RS_Entity* entity)
+{
+    if (entity) {
+        insert(entity, entity->getStartpoint());
+        insert(entity, entity->getEndpoint());
+        ++count;
+    }
+}
+
+void LC_ConnectivityIndex::insert(RS_Entity* entity, const RS_Vector& point)
+{
+    if (point.valid) {
+        cells[cellOf(point)].push_back({entity, point, count});
+    }
+}
+
+void LC_ConnectivityIndex::remove(RS_Entity* entity)
+{
+    if (entity) {
+        remove(entity, entity->getStartpoint());
+        remove(entity, entity->getEndpoint());
+    }
+}
+
+void LC_ConnectivityIndex::remove(RS_Entity* entity, const RS_Vector& point)
+{
+    if (!point.valid) {
+        return;
+    }
+    auto it = cells.find(cellOf(point));
+    if (it == cells.end()) {
+        return;
+    }
+    std::vector<Endpoint>& endpoints = it->second;
+    endpoints.erase(std::remove_if(endpoints.begin(), endpoints.end(),
+                                   [entity](const Endpoint& endpoint) {
+                        return endpoint.entity == entity;
+                    }),
+                    endpoints.end());
+    if (endpoints.empty()) {
+        cells.erase(it);
+    }
+}
+
+void LC_ConnectivityIndex::clear()
+{
+    cells.clear();
+    count = 0;
+}
+
+std::vector<RS_Entity*> LC_ConnectivityIndex::getConnected(const RS_Vector& point) const
+{
+    std::vector<std::pair<size_t, RS_Entity*>> found;
+    if (!point.valid) {
+        return {};
+    }
+    const Cell center = cellOf(point);
+    for (long long x = center.x - 1; x <= center.x + 1; ++x) {
+        for (long long y = center.y - 1; y <= center.y + 1; ++y) {
+            auto it = cells.find({x, y});
+            if (it == cells.end()) {
+                continue;
+            }
+            for (const Endpoint& endpoint: it->second) {
+                if (endpoint.point.distanceTo(point) < tolerance) {
+                    found.emplace_back(endpoint.order, endpoint.entity);
+                }
+            }
+        }
+    }
+
+    // both endpoints of short entities may be close to point
+    std::sort(found.begin(), found.end());
+    found.erase(std::unique(found.begin(), found.end()), found.end());
+    std::vector<RS_Entity*> ret;
+    ret.reserve(found.size());
+    for (const auto& f: found) {
+        ret.push_back(f.second);
+    }
+    return ret;
+}
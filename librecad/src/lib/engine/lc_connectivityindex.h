@@ -0,0 +1,91 @@
+/****************************************************************************
+**
+** This file is part of the LibreCAD project, a 2D CAD program
+**
+** Copyright (C) 2020 librecad.org (www.librecad.org)
+**
+**
+** This file may be distributed and/or modified under the terms of the
+** GNU General Public License version 2 as published by the Free Software
+** Foundation and appearing in the file gpl-2.0.txt included in the
+** packaging of this file.
+**
+** This program is distributed in the hope that it will be useful,
+** but WITHOUT ANY WARRANTY; without even the implied warranty of
+** MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+** GNU General Public License for more details.
+**
+** You should have received a copy of the GNU General Public License
+** along with this program; if not, write to the Free Software
+** Foundation, Inc., 51 Franklin Street, Fifth Floor, Boston, MA  02110-1301  USA
+**
+** This copyright notice MUST APPEAR in all copies of the script!
+**
+**********************************************************************/
+
+#ifndef LC_CONNECTIVITYINDEX_H
+#define LC_CONNECTIVITYINDEX_H
+
+#include <cstddef>
+#include <unordered_map>
+#include <vector>
+
+#include "rs_vector.h"
+
+class RS_Entity;
+
+/** \brief Hash of the start and end points of entities
+ *
+ * Finds the entities connected to a point, i.e. with a start or end point
+ * closer than the tolerance to it, in constant time. The points are hashed
+ * by grid cells as large as the tolerance, a query looks into the cell of
+ * the point and its eight neighbours.
+ *
+ * Used to follow contours of connected entities, e.g. by
+ * RS_Selection::selectContour() and RS_EntityContainer::optimizeContours().
+ * The endpoints of the entities must not change while they are indexed.
+ */
+class LC_ConnectivityIndex
+{
+public:
+    explicit LC_ConnectivityIndex(double tolerance = 1.0e-4);
+
+    double getTolerance() const;
+    /** adds the start and end point of entity, if they are valid */
+    void insert(RS_Entity* entity);
+    void remove(RS_Entity* entity);
+    void clear();
+
+    /**
+     * @brief getConnected entities with a start or end point closer than
+     * the tolerance to point, in the order they were inserted
+     */
+    std::vector<RS_Entity*> getConnected(const RS_Vector& point) const;
+
+private:
+    struct Cell {
+        long long x;
+        long long y;
+        bool operator == (const Cell& other) const {
+            return x == other.x && y == other.y;
+        }
+    };
+    struct CellHash {
+        size_t operator () (const Cell& cell) const;
+    };
+    struct Endpoint {
+        RS_Entity* entity;
+        RS_Vector point;
+        size_t order;
+    };
+
+    Cell cellOf(const RS_Vector& point) const;
+    void insert(RS_Entity* entity, const RS_Vector& point);
+    void remove(RS_Entity* entity, const RS_Vector& point);
+
+    double tolerance;
+    size_t count = 0;
+    std::unordered_map<Cell, std::vector<Endpoint>, CellHash> cells;
+};
+
+#endif // LC_CONNECTIVITYINDEX_H
@@ -0,0 +1,297 @@
+/****************************************************************************
+**
+** This file is part of the LibreCAD project, a 2D CAD program
+**
+** Copyright (C) 2020 librecad.org (www.librecad.org)
+**
+**
+** This file may be distributed and/or modified under the terms of the
+** GNU General Public License version 2 as published by the Free Software
+** Foundation and appearing in the file gpl-2.0.txt included in the
+** packaging of this file.
+**
+** This program is distributed in the hope that it will be useful,
+** but WITHOUT ANY WARRANTY; without even the implied warranty of
+** MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+** GNU General Public License for more details.
+**
+** You should have received a copy of the GNU General Public License
+** along with this program; if not, write to the Free Software
+** Foundation, Inc., 51 Franklin Street, Fifth Floor, Boston, MA  02110-1301  USA
+**
+** This copyright notice MUST APPEAR in all copies of the script!
+**
+**********************************************************************/
+
+#include <algorithm>
+#include <cmath>
+#include <iterator>
+#include <unordered_map>
+#include <utility>
+
+#include <boost/geometry.hpp>
+#include <boost/geometry/geometries/box.hpp>
+#include <boost/geometry/geometries/point.hpp>
+#include <boost/geometry/index/rtree.hpp>
+
+#include "lc_entityindex.h"
+#include "rs_entity.h"
+#include "rs_vector.h"
+
+namespace bg = boost::geometry;
+namespace bgi = boost::geometry::index;
+
+namespace {
+typedef bg::model::point<double, 2, bg::cs::cartesian> Point;
+typedef bg::model::box<Point> Box;
+typedef std::pair<Box, RS_Entity*> Value;
+typedef bgi::rtree<Value, bgi::rstar<16>> Tree;
+
+/**
+ * @brief boundingBox bounding box of the entity as used by the index
+ * @return false, if the entity has no finite bounding box
+ */
+bool boundingBox(RS_Entity const* entity, Box& box)
+{
+    if (entity->rtti() == RS2::EntityConstructionLine) {
+        return false;
+    }
+    const RS_Vector vMin = entity->getMin();
+    const RS_Vector vMax = entity->getMax();
+    if (!(vMin.valid && vMax.valid)
+            || !(vMin.x <= vMax.x && vMin.y <= vMax.y)
+            || !(std::isfinite(vMin.x) && std::isfinite(vMin.y)
+                 && std::isfinite(vMax.x) && std::isfinite(vMax.y))
+            || vMin.x < RS_MINDOUBLE || vMin.y < RS_MINDOUBLE
+            || vMax.x > RS_MAXDOUBLE || vMax.y > RS_MAXDOUBLE) {
+        return false;
+    }
+    box = Box{Point{vMin.x, vMin.y}, Point{vMax.x, vMax.y}};
+    return true;
+}
+
+double distanceToBox(const Point& p, const Box& box)
+{
+    const double dx = std::max({box.min_corner().get<0>() - p.get<0>(),
+                                0., p.get<0>() - box.max_corner().get<0>()});
+    const double dy = std::max({box.min_corner().get<1>() - p.get<1>(),
+                                0., p.get<1>() - box.max_corner().get<1>()});
+    return std::hypot(dx, dy);
+}
+}
+
+struct LC_EntityIndex::Impl {
+    struct Entry {
+        //! bounding box as stored in the tree, needed for removal
+        Box box;
+        //! position in the container, relative to other entries only
+        long long order;
+        bool bounded;
+    };
+
+    Tree tree;
+    std::unordered_map<RS_Entity*, Entry> entries;
+    //! entities without finite bounding box, reported by every query
+    std::vector<RS_Entity*> unbounded;
+    long long firstOrder = 0;
+    long long lastOrder = -1;
+};
+
+LC_EntityIndex::LC_EntityIndex() = default;
+
+LC_EntityIndex::LC_EntityIndex(const LC_EntityIndex&)
+{
+}
+
+LC_EntityIndex& LC_EntityIndex::operator = (const LC_EntityIndex& other)
+{
+    if (this != &other) {
+        clear();
+    }
+    return *this;
+}
+
+LC_EntityIndex::~LC_EntityIndex() = default;
+
+bool LC_EntityIndex::isValid() const
+{
+    return pImpl != nullptr;
+}
+
+size_t LC_EntityIndex::size() const
+{
+    return pImpl ? pImpl->entries.size() : 0;
+}
+
+void LC_EntityIndex::clear()
+{
+    pImpl.reset();
+}
+
+void LC_EntityIndex::build(const std::vector<RS_Entity*>& entities)
+{
+    std::vector<Value> values;
+    values.reserve(entities.size());
+    pImpl.reset(new Impl);
+    pImpl->entries.reserve(entities.size());
+    for (RS_Entity* e: entities) {
+        Impl::Entry entry;
+        entry.order = ++pImpl->lastOrder;
+        entry.bounded = boundingBox(e, entry.box);
+        if (entry.bounded) {
+            values.emplace_back(entry.box, e);
+        } else {
+            pImpl->unbounded.push_back(e);
+        }
+        pImpl->entries.emplace(e, entry);
+    }
+    // bulk loading with the packing algorithm
+    pImpl->tree = Tree{values.begin(), values.end()};
+}
+
+void LC_EntityIndex::insert(RS_Entity* entity, long long order)
+{
+    remove(entity);
+    Impl::Entry entry;
+    entry.order = order;
+    entry.bounded = boundingBox(entity, entry.box);
+    if (entry.bounded) {
+        pImpl->tree.insert(Value{entry.box, entity});
+    } else {
+        pImpl->unbounded.push_back(entity);
+    }
+    pImpl->entries[entity] = entry;
+}
+
+void LC_EntityIndex::append(RS_Entity* entity)
+{
+    if (pImpl && entity) {
+        insert(entity, ++pImpl->lastOrder);
+    }
+}
+
+void LC_EntityIndex::prepend(RS_Entity* entity)
+{
+    if (pImpl && entity) {
+        insert(entity, --pImpl->firstOrder);
+    }
+}
+
+bool LC_EntityIndex::remove(RS_Entity* entity)
+{
+    if (!(pImpl && entity)) {
+        return false;
+    }
+    auto it = pImpl->entries.find(entity);
+    if (it == pImpl->entries.end()) {
+        return false;
+    }
+    if (it->second.bounded) {
+        pImpl->tree.remove(Value{it->second.box, entity});
+    } else {
+        auto& unbounded = pImpl->unbounded;
+        unbounded.erase(std::find(unbounded.begin(), unbounded.end(), entity));
+    }
+    pImpl->entries.erase(it);
+    return true;
+}
+
+void LC_EntityIndex::replace(RS_Entity* oldEntity, RS_Entity* newEntity)
+{
+    if (!pImpl) {
+        return;
+    }
+    auto it = pImpl->entries.find(oldEntity);
+    const long long order = it != pImpl->entries.end() ? it->second.order : ++pImpl->lastOrder;
+    remove(oldEntity);
+    if (newEntity) {
+        insert(newEntity, order);
+    }
+}
+
+bool LC_EntityIndex::update(RS_Entity* entity)
+{
+    if (!(pImpl && entity)) {
+        return false;
+    }
+    auto it = pImpl->entries.find(entity);
+    if (it == pImpl->entries.end()) {
+        return false;
+    }
+    Box box;
+    const bool bounded = boundingBox(entity, box);
+    if (bounded == it->second.bounded && (!bounded || bg::equals(box, it->second.box))) {
+        return false;
+    }
+    const long long order = it->second.order;
+    remove(entity);
+    insert(entity, order);
+    return true;
+}
+
+std::vector<RS_Entity*> LC_EntityIndex::intersecting(const RS_Vector& v1, const RS_Vector& v2,
+                                                     double tolerance, bool ordered) const
+{
+    std::vector<RS_Entity*> ret;
+    if (!pImpl) {
+        return ret;
+    }
+    ret = pImpl->unbounded;
+    const Box window{Point{std::min(v1.x, v2.x) - tolerance, std::min(v1.y, v2.y) - tolerance},
+                     Point{std::max(v1.x, v2.x) + tolerance, std::max(v1.y, v2.y) + tolerance}};
+    std::vector<Value> found;
+    pImpl->tree.query(bgi::intersects(window), std::back_inserter(found));
+    ret.reserve(ret.size() + found.size());
+    for (const Value& v: found) {
+        ret.push_back(v.second);
+    }
+    if (ordered) {
+        sortByOrder(ret);
+    }
+    return ret;
+}
+
+void LC_EntityIndex::sortByOrder(std::vector<RS_Entity*>& entities) const
+{
+    std::vector<std::pair<long long, RS_Entity*>> sorted;
+    sorted.reserve(entities.size());
+    if (pImpl) {
+        for (RS_Entity* e: entities) {
+            auto it = pImpl->entries.find(e);
+            if (it != pImpl->entries.end()) {
+                sorted.emplace_back(it->second.order, e);
+            }
+        }
+    }
+    std::sort(sorted.begin(), sorted.end());
+    entities.resize(sorted.size());
+    for (size_t i = 0; i < sorted.size(); ++i) {
+        entities[i] = sorted[i].second;
+    }
+}
+
+void LC_EntityIndex::visitByDistance(const RS_Vector& coord,
+                                     const std::function<bool(RS_Entity*, double, long long)>& visitor) const
+{
+    if (!pImpl) {
+        return;
+    }
+    for (RS_Entity* e: pImpl->unbounded) {
+        if (!visitor(e, 0., pImpl->entries.at(e).order)) {
+            return;
+        }
+    }
+    if (pImpl->tree.empty()) {
+        return;
+    }
+    const Point p{coord.x, coord.y};
+    // the nearest query iterator is incremental, the tree is only searched
+    // as far as the visitor consumes entities
+    for (auto it = pImpl->tree.qbegin(bgi::nearest(p, pImpl->tree.size()));
+         it != pImpl->tree.qend(); ++it) {
+        if (!visitor(it->second, distanceToBox(p, it->first),
+                     pImpl->entries.at(it->second).order)) {
+            return;
+        }
+    }
+}
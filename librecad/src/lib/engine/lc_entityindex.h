@@ -0,0 +1,109 @@
+/****************************************************************************
+**
+** This file is part of the LibreCAD project, a 2D CAD program
+**
+** Copyright (C) 2020 librecad.org (www.librecad.org)
+**
+**
+** This file may be distributed and/or modified under the terms of the
+** GNU General Public License version 2 as published by the Free Software
+** Foundation and appearing in the file gpl-2.0.txt included in the
+** packaging of this file.
+**
+** This program is distributed in the hope that it will be useful,
+** but WITHOUT ANY WARRANTY; without even the implied warranty of
+** MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+** GNU General Public License for more details.
+**
+** You should have received a copy of the GNU General Public License
+** along with this program; if not, write to the Free Software
+** Foundation, Inc., 51 Franklin Street, Fifth Floor, Boston, MA  02110-1301  USA
+**
+** This copyright notice MUST APPEAR in all copies of the script!
+**
+**********************************************************************/
+
+#ifndef LC_ENTITYINDEX_H
+#define LC_ENTITYINDEX_H
+
+#include <functional>
+#include <memory>
+#include <vector>
+
+class RS_Entity;
+class RS_Vector;
+
+/** \brief Bounding box R-tree over the direct children of an entity container
+ *
+ * The index stores every entity with the bounding box it had when it was
+ * inserted or last updated. Entities without a usable bounding box (e.g.
+ * construction lines, which extend to infinity, or empty containers) are
+ * kept in a separate list and are reported by every query, so a query result
+ * is always a superset of the entities that can match.
+ *
+ * The index also keeps the order of the entities in their container, so
+ * query results can be returned in drawing order.
+ *
+ * Copies of an index are empty: an index belongs to exactly one container
+ * and cloned containers build their own index on demand.
+ */
+class LC_EntityIndex
+{
+public:
+    LC_EntityIndex();
+    LC_EntityIndex(const LC_EntityIndex&);
+    LC_EntityIndex& operator = (const LC_EntityIndex&);
+    ~LC_EntityIndex();
+
+    bool isValid() const;
+    size_t size() const;
+
+    void clear();
+    /** (re)builds the index with bulk loading, afterwards the index is valid */
+    void build(const std::vector<RS_Entity*>& entities);
+    /**
+     * append/prepend/remove/replace/update are ignored while the index is
+     * not valid. append and prepend refer to the container order.
+     */
+    void append(RS_Entity* entity);
+    void prepend(RS_Entity* entity);
+    bool remove(RS_Entity* entity);
+    /** puts newEntity at the position of oldEntity */
+    void replace(RS_Entity* oldEntity, RS_Entity* newEntity);
+    /** re-reads the bounding box of the entity, returns true if it changed */
+    bool update(RS_Entity* entity);
+
+    /**
+     * @brief intersecting entities whose bounding box intersects the window
+     * (v1, v2), enlarged by tolerance on each side
+     * @param ordered sort the result by container order
+     */
+    std::vector<RS_Entity*> intersecting(const RS_Vector& v1, const RS_Vector& v2,
+                                         double tolerance = 0.,
+                                         bool ordered = false) const;
+
+    /**
+     * @brief sortByOrder sorts entities by their order in the container,
+     * entities which are not in the index are dropped
+     */
+    void sortByOrder(std::vector<RS_Entity*>& entities) const;
+
+    /**
+     * @brief visitByDistance visits entities in the order of increasing
+     * distance from coord to their bounding box. Unbounded entities are
+     * visited first with a distance of 0.
+     * @param visitor gets the entity, the distance of its bounding box and
+     * its position in the container, relative to the other entities only.
+     * It returns false to stop the traversal.
+     */
+    void visitByDistance(const RS_Vector& coord,
+                         const std::function<bool(RS_Entity*, double, long long)>& visitor) const;
+
+private:
+    void insert(RS_Entity* entity, long long order);
+
+    struct Impl;
+    std::unique_ptr<Impl> pImpl;
+};
+
+#endif // LC_ENTITYINDEX_H
@@ -0,0 +1,276 @@
+/****************************************************************************
+**
+** This file is part of the LibreCAD project, a 2D CAD program
+**
+** Copyright (C) 2020 librecad.org (www.librecad.org)
+**
+**
+** This file may be distributed and/or modified under the terms of the
+** GNU General Public License version 2 as published by the Free Software
+** Foundation and appearing in the file gpl-2.0.txt included in the
+** packaging of this file.
+**
+** This program is distributed in the hope that it will be useful,
+** but WITHOUT ANY WARRANTY; without even the implied warranty of
+** MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+** GNU General Public License for more details.
+**
+** You should have received a copy of the GNU General Public License
+** along with this program; if not, write to the Free Software
+** Foundation, Inc., 51 Franklin Street, Fifth Floor, Boston, MA  02110-1301  USA
+**
+** This copyright notice MUST APPEAR in all copies of the script!
+**
+**********************************************************************/
+
+#include <algorithm>
+#include <cstring>
+
+#include <QCryptographicHash>
+#include <QDateTime>
+#include <QDir>
+#include <QFileInfo>
+#include <QSaveFile>
+#include <QStandardPaths>
+
+#include "lc_fontcache.h"
+#include "rs_debug.h"
+#include "rs_system.h"
+
+bool LC_FontCache::enabled = true;
+
+namespace {
+const char magic[8] = {'L', 'C', 'F', 'O', 'N', 'T', 'C', '\0'};
+/** to be increased with every change of the layout or of the glyph data */
+const quint32 version = 1;
+/** written in the byte order of the machine */
+const quint32 byteOrder = 0x01020304;
+}
+
+/** the cache starts with the header, followed by the glyph table, the
+ * glyph values and the font properties */
+struct LC_FontCache::Header {
+    char magic[8];
+    quint32 version;
+    quint32 byteOrder;
+    qint64 fontSize;
+    qint64 fontModified;
+    quint64 glyphCount;
+    quint64 valueCount;
+    quint64 propertiesSize;
+};
+
+/** glyph table entry, sorted by code */
+struct LC_FontCache::Glyph {
+    quint32 code;
+    quint32 size;
+    quint64 offset;
+};
+
+LC_FontCache::LC_FontCache(const QString& fontPath):
+    fontPath(fontPath)
+{
+    QFileInfo info(fontPath);
+    if (info.exists()) {
+        fontSize = info.size();
+        fontModified = info.lastModified().toMSecsSinceEpoch();
+    }
+}
+
+LC_FontCache::~LC_FontCache() = default;
+
+void LC_FontCache::setEnabled(bool enable)
+{
+    enabled = enable;
+}
+
+bool LC_FontCache::isEnabled()
+{
+    return enabled;
+}
+
+QString LC_FontCache::getCachePath() const
+{
+    const QByteArray hash = QCryptographicHash::hash(
+                QFileInfo(fontPath).absoluteFilePath().toUtf8(),
+                QCryptographicHash::Md5).toHex().left(16);
+    return QStandardPaths::writableLocation(QStandardPaths::DataLocation)
+            + QDir::separator() + "fontCache" + QDir::separator()
+            + QFileInfo(fontPath).baseName() + "-" + QString::fromLatin1(hash) + ".lfc";
+}
+
+bool LC_FontCache::load()
+{
+    if (!enabled || fontSize < 0) {
+        return false;
+    }
+
+    std::unique_ptr<QFile> f(new QFile(getCachePath()));
+    if (!f->open(QIODevice::ReadOnly)) {
+        return false;
+    }
+    const uchar* data = f->map(0, f->size());
+    if (!data || !attach(data, f->size())) {
+        RS_DEBUG->print(RS_Debug::D_WARNING,
+                        "LC_FontCache::load: ignoring invalid cache %s",
+                        qPrintable(f->fileName()));
+        detach();
+        return false;
+    }
+
+    const Header* header = reinterpret_cast<const Header*>(data);
+    if (header->fontSize != fontSize || header->fontModified != fontModified) {
+        RS_DEBUG->print("LC_FontCache::load: outdated cache %s",
+                        qPrintable(f->fileName()));
+        detach();
+        return false;
+    }
+
+    file = std::move(f);
+    RS_DEBUG->print("LC_FontCache::load: %d glyphs from %s",
+                    static_cast<int>(glyphCount), qPrintable(file->fileName()));
+    return true;
+}
+
+bool LC_FontCache::attach(const uchar* data, qint64 size)
+{
+    if (size < static_cast<qint64>(sizeof(Header))) {
+        return false;
+    }
+    const Header* header = reinterpret_cast<const Header*>(data);
+    if (std::memcmp(header->magic, magic, sizeof(magic)) != 0
+            || header->version != version || header->byteOrder != byteOrder) {
+        return false;
+    }
+
+    // the sections must fill the cache exactly
+    const quint64 available = static_cast<quint64>(size) - sizeof(Header);
+    if (header->glyphCount > available / sizeof(Glyph)
+            || header->valueCount > available / sizeof(double)
+            || header->propertiesSize > available
+            || header->glyphCount * sizeof(Glyph) + header->valueCount * sizeof(double)
+            + header->propertiesSize != available) {
+        return false;
+    }
+
+    glyphCount = header->glyphCount;
+    glyphs = reinterpret_cast<const Glyph*>(data + sizeof(Header));
+    valueCount = header->valueCount;
+    values = reinterpret_cast<const double*>(data + sizeof(Header) + glyphCount * sizeof(Glyph));
+    properties = QByteArray::fromRawData(
+                reinterpret_cast<const char*>(values + valueCount),
+                static_cast<int>(header->propertiesSize));
+    return true;
+}
+
+void LC_FontCache::detach()
+{
+    glyphs = nullptr;
+    glyphCount = 0;
+    values = nullptr;
+    valueCount = 0;
+    properties.clear();
+}
+
+void LC_FontCache::addGlyph(unsigned code, std::vector<double>&& data)
+{
+    added[code] = std::move(data);
+}
+
+void LC_FontCache::setProperties(const QByteArray& properties)
+{
+    this->properties = properties;
+}
+
+bool LC_FontCache::save()
+{
+    size_t addedValues = 0;
+    for (const auto& a: added) {
+        addedValues += a.second.size();
+    }
+
+    Header header;
+    std::memcpy(header.magic, magic, sizeof(magic));
+    header.version = version;
+    header.byteOrder = byteOrder;
+    header.fontSize = fontSize;
+    header.fontModified = fontModified;
+    header.glyphCount = added.size();
+    header.valueCount = addedValues;
+    header.propertiesSize = static_cast<quint64>(properties.size());
+
+    const QByteArray props = properties;
+    image = QByteArray(static_cast<int>(sizeof(Header) + added.size() * sizeof(Glyph)
+                                        + addedValues * sizeof(double) + props.size()),
+                       Qt::Uninitialized);
+    char* p = image.data();
+    std::memcpy(p, &header, sizeof(Header));
+    p += sizeof(Header);
+    quint64 offset = 0;
+    for (const auto& a: added) {
+        Glyph glyph{a.first, static_cast<quint32>(a.second.size()), offset};
+        std::memcpy(p, &glyph, sizeof(Glyph));
+        p += sizeof(Glyph);
+        offset += a.second.size();
+    }
+    for (const auto& a: added) {
+        std::memcpy(p, a.second.data(), a.second.size() * sizeof(double));
+        p += a.second.size() * sizeof(double);
+    }
+    std::memcpy(p, props.constData(), props.size());
+    added.clear();
+    file.reset();
+    attach(reinterpret_cast<const uchar*>(image.constData()), image.size());
+
+    if (!enabled || fontSize < 0) {
+        return false;
+    }
+    const QString path = getCachePath();
+    RS_SYSTEM->createPaths(QFileInfo(path).absolutePath());
+    QSaveFile f(path);
+    if (!f.open(QIODevice::WriteOnly)
+            || f.write(image) != image.size() || !f.commit()) {
+        RS_DEBUG->print(RS_Debug::D_WARNING,
+                        "LC_FontCache::save: cannot write %s", qPrintable(path));
+        return false;
+    }
+    return true;
+}
+
+bool LC_FontCache::isValid() const
+{
+    return glyphs != nullptr;
+}
+
+QByteArray LC_FontCache::getProperties() const
+{
+    return properties;
+}
+
+std::vector<unsigned> LC_FontCache::getCodes() const
+{
+    std::vector<unsigned> codes;
+    codes.reserve(glyphCount);
+    for (size_t i = 0; i < glyphCount; ++i) {
+        codes.push_back(glyphs[i].code);
+    }
+    return codes;
+}
+
+const double* LC_FontCache::getGlyph(unsigned code, size_t* size) const
+{
+    if (!glyphs) {
+        return nullptr;
+    }
+    const Glyph* end = glyphs + glyphCount;
+    const Glyph* glyph = std::lower_bound(glyphs, end, code,
+                                          [](const Glyph& g, unsigned c) {
+        return g.code < c;
+    });
+    if (glyph == end || glyph->code != code
+            || glyph->offset > valueCount || glyph->size > valueCount - glyph->offset) {
+        return nullptr;
+    }
+    *size = glyph->size;
+    return values + glyph->offset;
+}
@@ -0,0 +1,117 @@
+/****************************************************************************
+**
+** This file is part of the LibreCAD project, a 2D CAD program
+**
+** Copyright (C) 2020 librecad.org (www.librecad.org)
+**
+**
+** This file may be distributed and/or modified under the terms of the
+** GNU General Public License version 2 as published by the Free Software
+** Foundation and appearing in the file gpl-2.0.txt included in the
+** packaging of this file.
+**
+** This program is distributed in the hope that it will be useful,
+** but WITHOUT ANY WARRANTY; without even the implied warranty of
+** MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+** GNU General Public License for more details.
+**
+** You should have received a copy of the GNU General Public License
+** along with this program; if not, write to the Free Software
+** Foundation, Inc., 51 Franklin Street, Fifth Floor, Boston, MA  02110-1301  USA
+**
+** This copyright notice MUST APPEAR in all copies of the script!
+**
+**********************************************************************/
+
+#ifndef LC_FONTCACHE_H
+#define LC_FONTCACHE_H
+
+#include <cstddef>
+#include <map>
+#include <memory>
+#include <vector>
+
+#include <QByteArray>
+#include <QFile>
+#include <QString>
+
+/** \brief Binary cache of the glyphs of a font file
+ *
+ * Parsing large LFF fonts, e.g. the unicode fonts, takes a noticeable
+ * time. The glyphs are stored once as flat arrays of numbers in a cache
+ * file per font file, which is memory mapped by later sessions. The cache
+ * is valid while size and modification time of the font file and the
+ * cache version match.
+ *
+ * The meaning of the numbers of a glyph is up to the font, the cache only
+ * stores them with a block of font properties. A cache file is written in
+ * the byte order of the machine and rejected on other machines.
+ */
+class LC_FontCache
+{
+public:
+    explicit LC_FontCache(const QString& fontPath);
+    ~LC_FontCache();
+
+    /**
+     * Maps the cache of the font file.
+     * @return false, if there is no valid cache for the font file
+     */
+    bool load();
+
+    /** Adds the data of a glyph to a cache which was not loaded. */
+    void addGlyph(unsigned code, std::vector<double>&& data);
+    void setProperties(const QByteArray& properties);
+    /**
+     * Builds the cache from the added glyphs and writes it, the glyphs
+     * can be looked up afterwards even if writing fails.
+     */
+    bool save();
+
+    bool isValid() const;
+    QByteArray getProperties() const;
+    /** @return codes of all glyphs in ascending order */
+    std::vector<unsigned> getCodes() const;
+    /**
+     * @brief getGlyph looks up the data of a glyph
+     * @param size number of values of the glyph
+     * @return nullptr, if the glyph is not in the cache
+     */
+    const double* getGlyph(unsigned code, size_t* size) const;
+
+    /**
+     * Enables / disables the font cache. If disabled, fonts are parsed
+     * from their files every time. By default this is turned on.
+     */
+    static void setEnabled(bool enable);
+    static bool isEnabled();
+
+private:
+    struct Header;
+    struct Glyph;
+
+    QString getCachePath() const;
+    /** points to the sections of the cache image at data of size bytes */
+    bool attach(const uchar* data, qint64 size);
+    void detach();
+
+    QString fontPath;
+    qint64 fontSize = -1;
+    qint64 fontModified = 0;
+
+    /** glyphs added before save() */
+    std::map<unsigned, std::vector<double>> added;
+    QByteArray properties;
+
+    /** the cache file mapped by load() or the image built by save() */
+    std::unique_ptr<QFile> file;
+    QByteArray image;
+    const Glyph* glyphs = nullptr;
+    size_t glyphCount = 0;
+    const double* values = nullptr;
+    size_t valueCount = 0;
+
+    static bool enabled;
+};
+
+#endif // LC_FONTCACHE_H
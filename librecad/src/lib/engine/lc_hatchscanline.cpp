@@ -0,0 +1,285 @@
+/****************************************************************************
+**
+** This file is part of the LibreCAD project, a 2D CAD program
+**
+** Copyright (C) 2020 librecad.org (www.librecad.org)
+**
+**
+** This file may be distributed and/or modified under the terms of the
+** GNU General Public License version 2 as published by the Free Software
+** Foundation and appearing in the file gpl-2.0.txt included in the
+** packaging of this file.
+**
+** This program is distributed in the hope that it will be useful,
+** but WITHOUT ANY WARRANTY; without even the implied warranty of
+** MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+** GNU General Public License for more details.
+**
+** You should have received a copy of the GNU General Public License
+** along with this program; if not, write to the Free Software
+** Foundation, Inc., 51 Franklin Street, Fifth Floor, Boston, MA  02110-1301  USA
+**
+** This copyright notice MUST APPEAR in all copies of the script!
+**
+**********************************************************************/
+
+
+#include <algorithm>
+#include <cmath>
+#include <vector>
+
+#include "lc_hatchscanline.h"
+#include "rs_arc.h"
+#include "rs_circle.h"
+#include "rs_entitycontainer.h"
+#include "rs_line.h"
+#include "rs_math.h"
+
+namespace {
+struct Edge {
+    //! range of scanlines the edge reaches
+    double vMin;
+    double vMax;
+    RS_Entity* entity;
+};
+
+struct Scanline {
+    double v;
+    RS_Line* line;
+};
+
+struct Family {
+    //! direction of the lines, the normal gives the scanline coordinate
+    RS_Vector direction;
+    std::vector<Scanline> scanlines;
+};
+
+/**
+ * Intersections of the scanline v with an edge, as coordinates along the
+ * scanline. With crossing set, only proper crossings are reported: edges
+ * count by the half-open rule and tangents not at all.
+ */
+void intersect(const Edge& edge, const RS_Vector& direction, double v,
+               bool crossing, std::vector<double>& us)
+{
+    const RS_Vector normal{-direction.y, direction.x};
+    auto toU = [&direction](const RS_Vector& p) {
+        return p.x * direction.x + p.y * direction.y;
+    };
+    auto toV = [&normal](const RS_Vector& p) {
+        return p.x * normal.x + p.y * normal.y;
+    };
+
+    switch (edge.entity->rtti()) {
+    case RS2::EntityLine: {
+        auto line = static_cast<RS_Line*>(edge.entity);
+        const RS_Vector& p1 = line->getStartpoint();
+        const RS_Vector& p2 = line->getEndpoint();
+        const double v1 = toV(p1);
+        const double v2 = toV(p2);
+        if (crossing ? (v1 <= v) == (v2 <= v)
+                     : (v1 - v) * (v2 - v) > 0. || std::abs(v2 - v1) < RS_TOLERANCE) {
+            // parallel lines don't cut the scanline
+            return;
+        }
+        const double t = (v - v1) / (v2 - v1);
+        us.push_back(toU(p1) + t * (toU(p2) - toU(p1)));
+        break;
+    }
+    case RS2::EntityArc:
+    case RS2::EntityCircle: {
+        const RS_Vector center = edge.entity->getCenter();
+        const double radius = edge.entity->getRadius();
+        const double dv = v - toV(center);
+        const double disc = radius * radius - dv * dv;
+        if (disc < 0. || (crossing && disc < RS_TOLERANCE * RS_TOLERANCE)) {
+            return;
+        }
+        const double s = std::sqrt(disc);
+        for (double u: {toU(center) - s, toU(center) + s}) {
+            if (edge.entity->rtti() == RS2::EntityArc) {
+                auto arc = static_cast<RS_Arc*>(edge.entity);
+                const RS_Vector p = direction * u + normal * v;
+                if (!RS_Math::isAngleBetween(center.angleTo(p), arc->getAngle1(),
+                                             arc->getAngle2(), arc->isReversed())) {
+                    continue;
+                }
+            }
+            us.push_back(u);
+            if (s < RS_TOLERANCE) {
+                break;
+            }
+        }
+        break;
+    }
+    default:
+        break;
+    }
+}
+}
+
+bool LC_HatchScanline::trim(const RS_EntityContainer& contour,
+                            const RS_EntityContainer& carpet,
+                            RS_EntityContainer& pieces)
+{
+    std::vector<RS_Entity*> edges;
+    for (RS_Entity* loop: contour) {
+        if (!loop->isContainer()) {
+            continue;
+        }
+        for (RS_Entity* e: *static_cast<RS_EntityContainer*>(loop)) {
+            switch (e->rtti()) {
+            case RS2::EntityLine:
+            case RS2::EntityArc:
+            case RS2::EntityCircle:
+                edges.push_back(e);
+                break;
+            default:
+                return false;
+            }
+        }
+    }
+
+    // group the pattern lines into families of parallel lines
+    std::vector<Family> families;
+    for (RS_Entity* e: carpet) {
+        if (e->rtti() != RS2::EntityLine) {
+            return false;
+        }
+        auto line = static_cast<RS_Line*>(e);
+        RS_Vector direction = line->getEndpoint() - line->getStartpoint();
+        const double length = direction.magnitude();
+        if (length < RS_TOLERANCE) {
+            continue;
+        }
+        direction /= length;
+        if (direction.x < 0. || (direction.x == 0. && direction.y < 0.)) {
+            direction = -direction;
+        }
+        auto family = std::find_if(families.begin(), families.end(),
+                                   [&direction](const Family& f) {
+            return std::abs(f.direction.x * direction.y - f.direction.y * direction.x) < 1e-9;
+        });
+        if (family == families.end()) {
+            families.push_back(Family{direction, {}});
+            family = families.end() - 1;
+        }
+        const RS_Vector& p = line->getStartpoint();
+        family->scanlines.push_back(
+                    Scanline{p.y * family->direction.x - p.x * family->direction.y, line});
+    }
+
+    std::vector<double> cuts;
+    std::vector<double> crossings;
+    std::vector<double> us;
+    for (Family& family: families) {
+        const RS_Vector& direction = family.direction;
+        const RS_Vector normal{-direction.y, direction.x};
+        auto toU = [&direction](const RS_Vector& p) {
+            return p.x * direction.x + p.y * direction.y;
+        };
+        auto toV = [&normal](const RS_Vector& p) {
+            return p.x * normal.x + p.y * normal.y;
+        };
+
+        // edge table, sorted by the first scanline an edge reaches
+        std::vector<Edge> table;
+        table.reserve(edges.size());
+        double vMin = RS_MAXDOUBLE;
+        double vMax = RS_MINDOUBLE;
+        for (RS_Entity* e: edges) {
+            Edge edge{0., 0., e};
+            if (e->rtti() == RS2::EntityLine) {
+                auto line = static_cast<RS_Line*>(e);
+                edge.vMin = std::min(toV(line->getStartpoint()), toV(line->getEndpoint()));
+                edge.vMax = std::max(toV(line->getStartpoint()), toV(line->getEndpoint()));
+            } else {
+                edge.vMin = toV(e->getCenter()) - e->getRadius();
+                edge.vMax = toV(e->getCenter()) + e->getRadius();
+            }
+            vMin = std::min(vMin, edge.vMin);
+            vMax = std::max(vMax, edge.vMax);
+            table.push_back(edge);
+        }
+        std::sort(table.begin(), table.end(), [](const Edge& a, const Edge& b) {
+            return a.vMin < b.vMin;
+        });
+
+        std::sort(family.scanlines.begin(), family.scanlines.end(),
+                  [](const Scanline& a, const Scanline& b) {
+            return a.v < b.v;
+        });
+
+        // the even-odd rule is evaluated on a slightly shifted scanline,
+        // which avoids passing exactly through contour vertices
+        const double shift = 1e-9 * std::max(1., vMax - vMin);
+        const double margin = 2. * shift + RS_TOLERANCE;
+
+        std::vector<const Edge*> active;
+        size_t nextEdge = 0;
+        bool scanned = false;
+        double scannedV = 0.;
+        for (const Scanline& scanline: family.scanlines) {
+            const double v = scanline.v;
+            if (!scanned || v - scannedV > RS_TOLERANCE) {
+                // update the active edges and the crossings of the scanline
+                while (nextEdge < table.size() && table[nextEdge].vMin <= v + margin) {
+                    active.push_back(&table[nextEdge++]);
+                }
+                active.erase(std::remove_if(active.begin(), active.end(),
+                                            [v, margin](const Edge* edge) {
+                    return edge->vMax < v - margin;
+                }), active.end());
+
+                cuts.clear();
+                crossings.clear();
+                for (const Edge* edge: active) {
+                    intersect(*edge, direction, v, false, cuts);
+                    intersect(*edge, direction, v + shift, true, crossings);
+                }
+                std::sort(cuts.begin(), cuts.end());
+                std::sort(crossings.begin(), crossings.end());
+                scanned = true;
+                scannedV = v;
+            }
+            if (crossings.empty()) {
+                continue;
+            }
+
+            // cut the pattern line at the contour, from start to end
+            RS_Line* line = scanline.line;
+            const RS_Vector& start = line->getStartpoint();
+            const RS_Vector& end = line->getEndpoint();
+            const double u0 = toU(start);
+            const double u1 = toU(end);
+            us.clear();
+            us.push_back(std::min(u0, u1));
+            for (double u: cuts) {
+                if (u - us.back() > RS_TOLERANCE && std::max(u0, u1) - u > RS_TOLERANCE) {
+                    us.push_back(u);
+                }
+            }
+            us.push_back(std::max(u0, u1));
+            if (u0 > u1) {
+                std::reverse(us.begin(), us.end());
+            }
+
+            auto pointAt = [&](double u) {
+                return start + (end - start) * ((u - u0) / (u1 - u0));
+            };
+            for (size_t i = 1; i < us.size(); ++i) {
+                if (std::abs(us[i] - us[i-1]) < RS_TOLERANCE) {
+                    continue;
+                }
+                // inside, if an odd number of crossings lies before the middle
+                const double middle = 0.5 * (us[i-1] + us[i]);
+                const auto before = std::lower_bound(crossings.begin(), crossings.end(), middle)
+                        - crossings.begin();
+                if (before % 2 == 1) {
+                    pieces.addEntity(new RS_Line{&pieces, pointAt(us[i-1]), pointAt(us[i])});
+                }
+            }
+        }
+    }
+    return true;
+}
@@ -0,0 +1,59 @@
+/****************************************************************************
+**
+** This file is part of the LibreCAD project, a 2D CAD program
+**
+** Copyright (C) 2020 librecad.org (www.librecad.org)
+**
+**
+** This file may be distributed and/or modified under the terms of the
+** GNU General Public License version 2 as published by the Free Software
+** Foundation and appearing in the file gpl-2.0.txt included in the
+** packaging of this file.
+**
+** This program is distributed in the hope that it will be useful,
+** but WITHOUT ANY WARRANTY; without even the implied warranty of
+** MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+** GNU General Public License for more details.
+**
+** You should have received a copy of the GNU General Public License
+** along with this program; if not, write to the Free Software
+** Foundation, Inc., 51 Franklin Street, Fifth Floor, Boston, MA  02110-1301  USA
+**
+** This copyright notice MUST APPEAR in all copies of the script!
+**
+**********************************************************************/
+
+
+#ifndef LC_HATCHSCANLINE_H
+#define LC_HATCHSCANLINE_H
+
+class RS_EntityContainer;
+
+/** \brief Trims the pattern carpet of a hatch to the hatch contour
+ *
+ * The pattern lines are grouped into families of parallel lines. For
+ * every family the contour edges are put into an edge table sorted by
+ * the first scanline they reach, and the scanlines of the family are
+ * swept in order while the table provides the edges crossing the
+ * current scanline. Collinear pattern lines share the crossings of
+ * their scanline.
+ *
+ * The inside spans of a scanline follow from the even-odd rule, so no
+ * point in contour test is needed for the trimmed pieces.
+ */
+class LC_HatchScanline
+{
+public:
+    /**
+     * @brief trim adds the pieces of the lines of carpet inside the loops
+     * of contour to pieces.
+     * @return false without adding anything, if contour or carpet hold
+     * entities the scanline engine doesn't handle. The contour may consist
+     * of lines, arcs and circles, the carpet of lines.
+     */
+    static bool trim(const RS_EntityContainer& contour,
+                     const RS_EntityContainer& carpet,
+                     RS_EntityContainer& pieces);
+};
+
+#endif // LC_HATCHSCANLINE_H
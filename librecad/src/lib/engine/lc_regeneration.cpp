@@ -0,0 +1,262 @@
+/****************************************************************************
+**
+** This file is part of the LibreCAD project, a 2D CAD program
+**
+** Copyright (C) 2020 librecad.org (www.librecad.org)
+**
+**
+** This file may be distributed and/or modified under the terms of the
+** GNU General Public License version 2 as published by the Free Software
+** Foundation and appearing in the file gpl-2.0.txt included in the
+** packaging of this file.
+**
+** This program is distributed in the hope that it will be useful,
+** but WITHOUT ANY WARRANTY; without even the implied warranty of
+** MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+** GNU General Public License for more details.
+**
+** You should have received a copy of the GNU General Public License
+** along with this program; if not, write to the Free Software
+** Foundation, Inc., 51 Franklin Street, Fifth Floor, Boston, MA  02110-1301  USA
+**
+** This copyright notice MUST APPEAR in all copies of the script!
+**
+**********************************************************************/
+
+#include <algorithm>
+#include <atomic>
+#include <functional>
+#include <thread>
+#include <vector>
+
+#include "lc_regeneration.h"
+#include "lc_trace.h"
+#include "rs_block.h"
+#include "rs_blocklist.h"
+#include "rs_debug.h"
+#include "rs_graphic.h"
+#include "rs_insert.h"
+
+bool LC_Regeneration::enabled = true;
+
+namespace {
+/** entities taken by a thread at once */
+const size_t chunkSize = 64;
+
+/**
+ * @brief parallelFor calls f(i) for every i in [0, count) on up to threads
+ * threads, the calling thread included
+ */
+void parallelFor(size_t count, unsigned threads,
+                 const std::function<void(size_t)>& f)
+{
+    threads = static_cast<unsigned>(std::min<size_t>(threads, (count + chunkSize - 1) / chunkSize));
+    if (threads <= 1) {
+        for (size_t i = 0; i < count; ++i) {
+            f(i);
+        }
+        return;
+    }
+
+    std::atomic<size_t> next{0};
+    auto worker = [&]() {
+        LC_TRACE_SCOPE("regen", "LC_Regeneration::worker");
+        for (size_t begin = next.fetch_add(chunkSize); begin < count;
+             begin = next.fetch_add(chunkSize)) {
+            const size_t end = std::min(begin + chunkSize, count);
+            for (size_t i = begin; i < end; ++i) {
+                f(i);
+            }
+        }
+    };
+    std::vector<std::thread> pool;
+    pool.reserve(threads - 1);
+    for (unsigned t = 1; t < threads; ++t) {
+        pool.emplace_back(worker);
+    }
+    worker();
+    for (std::thread& t: pool) {
+        t.join();
+    }
+}
+
+bool isDimension(RS_Entity* e)
+{
+    switch (e->rtti()) {
+    case RS2::EntityDimAligned:
+    case RS2::EntityDimLinear:
+    case RS2::EntityDimRadial:
+    case RS2::EntityDimDiametric:
+    case RS2::EntityDimAngular:
+    case RS2::EntityDimLeader:
+        return true;
+    default:
+        return false;
+    }
+}
+
+void updateEntity(RS_Entity* e)
+{
+    if (e->rtti() == RS2::EntityInsert) {
+        // the inserts of its block belong to a lower level
+        static_cast<RS_Insert*>(e)->update(false);
+    } else {
+        e->update();
+    }
+}
+}
+
+void LC_Regeneration::setEnabled(bool enable)
+{
+    enabled = enable;
+}
+
+bool LC_Regeneration::isEnabled()
+{
+    return enabled;
+}
+
+void LC_Regeneration::add(RS_Entity* entity)
+{
+    if (entity) {
+        queued[entity->getParent()].append(entity);
+    }
+}
+
+void LC_Regeneration::remove(RS_EntityContainer* container)
+{
+    queued.remove(container);
+}
+
+void LC_Regeneration::clear()
+{
+    queued.clear();
+}
+
+void LC_Regeneration::run(RS_Graphic* graphic)
+{
+    LC_TRACE_SCOPE("regen", "LC_Regeneration::run");
+    RS_DEBUG->print("LC_Regeneration::run");
+    if (!graphic) {
+        clear();
+        return;
+    }
+
+    // the level of a block is one above the levels of the blocks it inserts
+    RS_BlockList* blockList = graphic->getBlockList();
+    QHash<RS_Block*, int> blockLevels;
+    std::function<int(RS_Block*)> levelOf = [&](RS_Block* block) {
+        auto it = blockLevels.find(block);
+        if (it != blockLevels.end()) {
+            return it.value();
+        }
+        // a block inserting itself must not recurse forever
+        blockLevels.insert(block, 0);
+        int level = 0;
+        for (RS_Entity* e: *block) {
+            if (e->rtti() == RS2::EntityInsert) {
+                RS_Block* inserted = static_cast<RS_Insert*>(e)->getBlockForInsert();
+                if (inserted && inserted != block) {
+                    level = std::max(level, levelOf(inserted) + 1);
+                }
+            }
+        }
+        blockLevels[block] = level;
+        return level;
+    };
+
+    // dimensions add missing $DIM* variables to the graphic while they are
+    // updated, so they and the inserts copying them are updated serially
+    QHash<RS_Block*, bool> blockDimensions;
+    std::function<bool(RS_Block*)> hasDimensions = [&](RS_Block* block) {
+        auto it = blockDimensions.find(block);
+        if (it != blockDimensions.end()) {
+            return it.value();
+        }
+        blockDimensions.insert(block, false);
+        bool found = false;
+        for (RS_Entity* e: *block) {
+            if (isDimension(e)) {
+                found = true;
+            } else if (e->rtti() == RS2::EntityInsert) {
+                RS_Block* inserted = static_cast<RS_Insert*>(e)->getBlockForInsert();
+                found = inserted && hasDimensions(inserted);
+            }
+            if (found) {
+                break;
+            }
+        }
+        blockDimensions[block] = found;
+        return found;
+    };
+    auto isSerial = [&](RS_Entity* e) {
+        if (e->rtti() == RS2::EntityInsert) {
+            RS_Block* inserted = static_cast<RS_Insert*>(e)->getBlockForInsert();
+            return inserted && hasDimensions(inserted);
+        }
+        return isDimension(e);
+    };
+
+    // the entities to update and the containers to recalculate per level,
+    // the graphic comes last
+    int graphicLevel = 0;
+    for (RS_Block* block: *blockList) {
+        graphicLevel = std::max(graphicLevel, levelOf(block) + 1);
+    }
+    std::vector<std::vector<RS_Entity*>> levelEntities(graphicLevel + 1);
+    std::vector<std::vector<RS_EntityContainer*>> levelContainers(graphicLevel + 1);
+    auto addContainer = [&](RS_EntityContainer* container, int level) {
+        levelContainers[level].push_back(container);
+        for (RS_Entity* e: *container) {
+            if (e->rtti() == RS2::EntityInsert) {
+                levelEntities[level].push_back(e);
+            }
+        }
+        auto it = queued.find(container);
+        if (it != queued.end()) {
+            levelEntities[level].insert(levelEntities[level].end(),
+                                        it.value().begin(), it.value().end());
+            queued.erase(it);
+        }
+    };
+    for (RS_Block* block: *blockList) {
+        addContainer(block, blockLevels.value(block));
+    }
+    addContainer(graphic, graphicLevel);
+    // entities of other containers depend on all blocks
+    for (const QList<RS_Entity*>& entities: queued) {
+        levelEntities[graphicLevel].insert(levelEntities[graphicLevel].end(),
+                                           entities.begin(), entities.end());
+    }
+    queued.clear();
+
+    // the debugging output of several threads would be interleaved
+    unsigned threads = std::max(1u, std::thread::hardware_concurrency());
+    if (RS_DEBUG->getLevel() == RS_Debug::D_DEBUGGING) {
+        threads = 1;
+    }
+
+    for (int level = 0; level <= graphicLevel; ++level) {
+        RS_DEBUG->print("LC_Regeneration::run: level %d: %d entities", level,
+                        static_cast<int>(levelEntities[level].size()));
+        std::vector<RS_Entity*> entities;
+        std::vector<RS_Entity*> serialEntities;
+        for (RS_Entity* e: levelEntities[level]) {
+            (isSerial(e) ? serialEntities : entities).push_back(e);
+        }
+        parallelFor(entities.size(), threads, [&entities](size_t i) {
+            updateEntity(entities[i]);
+        });
+        for (RS_Entity* e: serialEntities) {
+            updateEntity(e);
+        }
+
+        // entities were added to their containers before they were updated
+        const std::vector<RS_EntityContainer*>& containers = levelContainers[level];
+        parallelFor(containers.size(), threads, [&containers](size_t i) {
+            containers[i]->calculateBorders();
+        });
+    }
+
+    RS_DEBUG->print("LC_Regeneration::run: OK");
+}
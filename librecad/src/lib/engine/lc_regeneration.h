@@ -0,0 +1,82 @@
+/****************************************************************************
+**
+** This file is part of the LibreCAD project, a 2D CAD program
+**
+** Copyright (C) 2020 librecad.org (www.librecad.org)
+**
+**
+** This file may be distributed and/or modified under the terms of the
+** GNU General Public License version 2 as published by the Free Software
+** Foundation and appearing in the file gpl-2.0.txt included in the
+** packaging of this file.
+**
+** This program is distributed in the hope that it will be useful,
+** but WITHOUT ANY WARRANTY; without even the implied warranty of
+** MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+** GNU General Public License for more details.
+**
+** You should have received a copy of the GNU General Public License
+** along with this program; if not, write to the Free Software
+** Foundation, Inc., 51 Franklin Street, Fifth Floor, Boston, MA  02110-1301  USA
+**
+** This copyright notice MUST APPEAR in all copies of the script!
+**
+**********************************************************************/
+
+#ifndef LC_REGENERATION_H
+#define LC_REGENERATION_H
+
+#include <QHash>
+#include <QList>
+
+class RS_Entity;
+class RS_EntityContainer;
+class RS_Graphic;
+
+/** \brief Regeneration of the entities of a graphic after loading it
+ *
+ * Import filters queue the entities with an expensive update(), e.g. texts,
+ * dimensions and hatches, instead of updating them one by one while the
+ * file is read. run() orders the blocks of the graphic by their inserts, so
+ * a block is regenerated after all blocks it inserts, and updates the queued
+ * entities and the inserts of one level on a pool of threads. The borders of
+ * the blocks and of the graphic are recalculated once all entities of their
+ * level are up to date.
+ *
+ * The updated entities only change themselves and their own sub-entities,
+ * the fonts and patterns they share are loaded under a lock. Dimensions
+ * write the $DIM* variables of the graphic, so they and the inserts of
+ * blocks with dimensions are updated on the calling thread after the other
+ * entities of their level.
+ */
+class LC_Regeneration
+{
+public:
+    /** Queues entity, which must have been added to its parent already. */
+    void add(RS_Entity* entity);
+    /** Drops the queued entities of container, e.g. before deleting it. */
+    void remove(RS_EntityContainer* container);
+    void clear();
+
+    /**
+     * Updates the queued entities and the inserts of the graphic and its
+     * blocks, then recalculates the borders. The queue is empty afterwards.
+     */
+    void run(RS_Graphic* graphic);
+
+    /**
+     * Enables / disables the regeneration after loading. If disabled,
+     * filters update the entities while reading. By default this is
+     * turned on.
+     */
+    static void setEnabled(bool enable);
+    static bool isEnabled();
+
+private:
+    /** queued entities by their parent container */
+    QHash<RS_EntityContainer*, QList<RS_Entity*>> queued;
+
+    static bool enabled;
+};
+
+#endif
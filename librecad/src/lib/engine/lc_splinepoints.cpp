@@ -1909,14 +1909,14 @@ void LC_SplinePoints::draw(RS_Painter* painter, RS_GraphicView* view, double& pa
 
 	// Pattern:
 	const RS_LineTypePattern* pat = nullptr;
-	if(isSelected() && !(view->isPrinting() || view->isPrintPreview()))
+	if(view->isDrawnSelected(this) && !(view->isPrinting() || view->isPrintPreview()))
 	{
 //		styleFactor=1.;
         pat = &RS_LineTypePattern::patternSelected;
 	}
 	else
 	{
-		pat = view->getPattern(getPen().getLineType());
+		pat = view->getPattern(view->getDrawnPen(this).getLineType());
 	}
 
 	bool bDrawPattern = false;
@@ -896,8 +896,9 @@ void RS_Arc::draw(RS_Painter* painter, RS_GraphicView* view,
 	if (!( painter && view)) return;
 
     //only draw the visible portion of line
-    RS_Vector vpMin(view->toGraph(0,view->getHeight()));
-    RS_Vector vpMax(view->toGraph(view->getWidth(),0));
+    const LC_Rect viewArea = view->getViewArea();
+    RS_Vector vpMin(viewArea.minP());
+    RS_Vector vpMax(viewArea.maxP());
     QPolygonF visualBox(QRectF(vpMin.x,vpMin.y,vpMax.x-vpMin.x, vpMax.y-vpMin.y));
 
     RS_Vector vpStart(isReversed()?getEndpoint():getStartpoint());
@@ -961,11 +962,11 @@ void RS_Arc::drawVisible(RS_Painter* painter, RS_GraphicView* view,
     //double styleFactor = getStyleFactor();
     patternOffset -= length;
 
-    bool drawAsSelected = isSelected() && !(view->isPrinting() || view->isPrintPreview());
+    bool drawAsSelected = view->isDrawnSelected(this) && !(view->isPrinting() || view->isPrintPreview());
 
     // simple style-less lines
     if ( !drawAsSelected && (
-             getPen().getLineType()==RS2::SolidLine ||
+             view->getDrawnPen(this).getLineType()==RS2::SolidLine ||
              view->getDrawingMode()==RS2::ModePreview)) {
         painter->drawArc(cp,
                          ra,
@@ -988,7 +989,7 @@ void RS_Arc::drawVisible(RS_Painter* painter, RS_GraphicView* view,
     {
         pat = &RS_LineTypePattern::patternSelected;
     } else {
-        pat = view->getPattern(getPen().getLineType());
+        pat = view->getPattern(view->getDrawnPen(this).getLineType());
     }
 
 	if (!pat || ra<0.5) {//avoid division by zero from small ra
@@ -53,6 +53,7 @@ RS_BlockList::RS_BlockList(bool owner) {
  */
 void RS_BlockList::clear() {
     blocks.clear();
+    blockIndex.clear();
 	activeBlock = nullptr;
 	setModified(true);
 }
@@ -98,6 +99,7 @@ bool RS_BlockList::add(RS_Block* block, bool notify) {
     RS_Block* b = find(block->getName());
 	if (!b) {
         blocks.append(block);
+        blockIndex.insert(block->getName(), block);
 
         if (notify) {
             addNotification();
@@ -140,6 +142,14 @@ void RS_BlockList::remove(RS_Block* block) {
 
     // here the block is removed from the list but not deleted
     blocks.removeOne(block);
+    if (block) {
+        auto it = blockIndex.find(block->getName());
+        if (it != blockIndex.end() && it.value() == block) {
+            blockIndex.erase(it);
+        } else {
+            reindex();
+        }
+    }
 
 	for(auto l: blockListListeners){
 		l->blockRemoved(block);
@@ -173,7 +183,17 @@ void RS_BlockList::remove(RS_Block* block) {
 bool RS_BlockList::rename(RS_Block* block, const QString& name) {
 	if (block) {
 		if (!find(name)) {
+			auto it = blockIndex.find(block->getName());
+			bool const indexed = it != blockIndex.end() && it.value() == block;
+			if (indexed) {
+				blockIndex.erase(it);
+			}
 			block->setName(name);
+			if (indexed) {
+				blockIndex.insert(name, block);
+			} else {
+				reindex();
+			}
 			setModified(true);
 			return true;
 		}
@@ -206,21 +226,30 @@ void RS_BlockList::editBlock(RS_Block* block, const RS_Block& source) {
  */
 RS_Block* RS_BlockList::find(const QString& name) {
     try {
-        RS_DEBUG->print(RS_Debug::D_DEBUGGING, "RS_BlockList::find(): %s", name.toLatin1().constData());
+        RS_DEBUG_PRINT("RS_BlockList::find(): %s", name.toLatin1().constData());
     }
     catch(...) {
-        RS_DEBUG->print(RS_Debug::D_DEBUGGING, "RS_BlockList::find(): wrong name to find");
+        RS_DEBUG_PRINT("RS_BlockList::find(): wrong name to find");
         return nullptr;
     }
-	// Todo : reduce this from O(N) to O(log(N)) complexity based on sorted list or hash
-	//DFS
+	RS_Block* b = blockIndex.value(name, nullptr);
+	if (!b) {
+		RS_DEBUG_PRINT("RS_BlockList::find(): bad");
+	}
+	return b;
+}
+
+/**
+ * Rebuilds the name index of the blocks.
+ */
+void RS_BlockList::reindex() {
+	blockIndex.clear();
+	blockIndex.reserve(blocks.size());
 	for(RS_Block* b: blocks) {
-		if (b->getName()==name) {
-			return b;
+		if (!blockIndex.contains(b->getName())) {
+			blockIndex.insert(b->getName(), b);
 		}
 	}
-    RS_DEBUG->print(RS_Debug::D_DEBUGGING, "RS_BlockList::find(): bad");
-	return nullptr;
 }
 
 /**
@@ -30,8 +30,9 @@
 
 
 #include <QList>
+#include <QHash>
+#include <QString>
 
-class QString;
 class RS_Block;
 class RS_BlockListListener;
 
@@ -105,12 +106,16 @@ private:
     bool owner;
     //! Blocks in the graphic
     QList<RS_Block*> blocks;
+    //! Blocks by name, maintained by add(), remove(), rename() and clear()
+    QHash<QString, RS_Block*> blockIndex;
     //! List of registered BlockListListeners
     QList<RS_BlockListListener*> blockListListeners;
     //! Currently active block
     RS_Block* activeBlock;
     /** Flag set if the block list was modified and not yet saved. */
     bool modified;
+
+    void reindex();
 };
 
 #endif
@@ -26,9 +26,18 @@
 **********************************************************************/
 
 
+#include <algorithm>
+#include <functional>
+#include <vector>
+
 #include "rs_document.h"
 #include "rs_debug.h"
 
+namespace {
+/** number of undo cycles after which undone entities are compacted */
+const int compactionInterval = 32;
+}
+
 
 /**
  * Constructor.
@@ -51,6 +60,13 @@ RS_Document::RS_Document(RS_EntityContainer* parent)
     gv = NULL;//used to read/save current view
 }
 
+
+
+RS_Document::~RS_Document()
+{
+    deleteUndone();
+}
+
 /**
  * Overwritten to set modified flag when undo cycle finished with undoable(s).
  */
@@ -61,5 +77,155 @@ void RS_Document::endUndoCycle()
     }
 
     RS_Undo::endUndoCycle();
+
+    if (!isUndoCycleActive() && ++undoneStore.cycles >= compactionInterval) {
+        compactUndone();
+    }
+}
+
+
+
+bool RS_Document::undo()
+{
+    if (!RS_Undo::undo()) {
+        return false;
+    }
+    restoreUndone();
+    return true;
+}
+
+
+
+bool RS_Document::redo()
+{
+    if (!RS_Undo::redo()) {
+        return false;
+    }
+    restoreUndone();
+    return true;
+}
+
+
+
+void RS_Document::removeUndoable(RS_Undoable* u)
+{
+    if (u && u->undoRtti()==RS2::UndoableEntity && u->isUndone()) {
+        RS_Entity* e = static_cast<RS_Entity*>(u);
+        if (undoneStore.entities.remove(e) > 0) {
+            if (autoDelete) {
+                delete e;
+            }
+        } else {
+            removeEntity(e);
+        }
+    }
+}
+
+
+
+void RS_Document::clear()
+{
+    deleteUndone();
+    RS_EntityContainer::clear();
+}
+
+
+
+void RS_Document::compactUndone()
+{
+    undoneStore.cycles = 0;
+
+    QList<RS_Entity*> live;
+    live.reserve(entities.size());
+    RS_Entity* previous = nullptr;
+    for (RS_Entity* e: entities) {
+        if (e->isUndone()) {
+            undoneStore.entities.insert(e, {previous ? previous->getId() : 0,
+                                            previous == nullptr,
+                                            undoneStore.count++});
+        } else {
+            live.append(e);
+            previous = e;
+        }
+    }
+
+    if (live.size() < entities.size()) {
+        RS_DEBUG->print("RS_Document::compactUndone: %d undone entities",
+                        entities.size() - live.size());
+        entities = live;
+        spatialIndex.clear();
+    }
+}
+
+
+
+/**
+ * Puts the compacted entities which are no longer undone back behind the
+ * entities they followed. Entities following a removed entity are
+ * appended.
+ */
+void RS_Document::restoreUndone()
+{
+    std::vector<std::pair<unsigned long long, RS_Entity*>> restored;
+    for (auto it = undoneStore.entities.begin(); it != undoneStore.entities.end(); ++it) {
+        if (!it.key()->isUndone()) {
+            restored.emplace_back(it.value().order, it.key());
+        }
+    }
+    if (restored.empty()) {
+        return;
+    }
+    std::sort(restored.begin(), restored.end());
+
+    // restored entities by the id of the entity they followed, in their
+    // former order
+    QList<RS_Entity*> leading;
+    QHash<unsigned long int, QList<RS_Entity*>> followers;
+    std::vector<unsigned long int> previous;
+    previous.reserve(restored.size());
+    for (const auto& r: restored) {
+        const UndoneStore::Entry entry = undoneStore.entities.take(r.second);
+        if (entry.first) {
+            leading.append(r.second);
+        } else {
+            previous.push_back(entry.previousId);
+            followers[entry.previousId].append(r.second);
+        }
+    }
+
+    QList<RS_Entity*> merged;
+    merged.reserve(entities.size() + static_cast<int>(restored.size()));
+    std::function<void(RS_Entity*)> append = [&](RS_Entity* e) {
+        merged.append(e);
+        for (RS_Entity* f: followers.take(e->getId())) {
+            append(f);
+        }
+    };
+    for (RS_Entity* f: leading) {
+        append(f);
+    }
+    for (RS_Entity* e: entities) {
+        append(e);
+    }
+    for (unsigned long int p: previous) {
+        for (RS_Entity* f: followers.take(p)) {
+            append(f);
+        }
+    }
+
+    entities = merged;
+    spatialIndex.clear();
+}
+
+
+
+void RS_Document::deleteUndone()
+{
+    if (autoDelete) {
+        for (auto it = undoneStore.entities.begin(); it != undoneStore.entities.end(); ++it) {
+            delete it.key();
+        }
+    }
+    undoneStore.entities.clear();
 }
 
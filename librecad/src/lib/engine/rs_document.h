@@ -29,6 +29,8 @@
 #ifndef RS_DOCUMENT_H
 #define RS_DOCUMENT_H
 
+#include <QHash>
+
 #include "rs_layerlist.h"
 #include "rs_entitycontainer.h"
 #include "rs_undo.h"
@@ -47,7 +49,7 @@ class RS_Document : public RS_EntityContainer,
     public RS_Undo {
 public:
 	RS_Document(RS_EntityContainer* parent=nullptr);
-	virtual ~RS_Document() = default;
+	virtual ~RS_Document();
 
     virtual RS_LayerList* getLayerList() = 0;
     virtual RS_BlockList* getBlockList() = 0;
@@ -70,11 +72,10 @@ public:
      * Removes an entity from the entiy container. Implementation
      * from RS_Undo.
      */
-    virtual void removeUndoable(RS_Undoable* u) {
-        if (u && u->undoRtti()==RS2::UndoableEntity && u->isUndone()) {
-			removeEntity(static_cast<RS_Entity*>(u));
-        }
-    }
+    virtual void removeUndoable(RS_Undoable* u);
+
+    /** Erases all entities, the compacted undone ones included. */
+    void clear() override;
 
     /**
      * @return Currently active drawing pen.
@@ -132,6 +133,20 @@ public:
      * Overwritten to set modified flag when undo cycle finished with undoable(s).
      */
     virtual void endUndoCycle() override;
+    /**
+     * Overwritten to put compacted entities which are no longer undone
+     * back into the document.
+     */
+    bool undo() override;
+    bool redo() override;
+
+    /**
+     * Moves the undone entities out of the entity list, so they are not
+     * visited by drawing, snapping and other traversals. They are kept
+     * for undo / redo and put back at their former position once they
+     * are no longer undone. Called periodically by endUndoCycle().
+     */
+    void compactUndone();
 
     void setGraphicView(RS_GraphicView * g) {gv = g;}
     RS_GraphicView* getGraphicView() {return gv;}
@@ -149,6 +164,33 @@ protected:
 	RS2::FormatType formatType;
     RS_GraphicView * gv;//used to read/save current view
 
+private:
+    void restoreUndone();
+    void deleteUndone();
+
+    /** undone entities moved out of the entity list by compactUndone() */
+    struct UndoneStore {
+        UndoneStore() = default;
+        // copies of documents do not own the entities of the original
+        UndoneStore(const UndoneStore&) {}
+        UndoneStore& operator = (const UndoneStore&) { return *this; }
+
+        struct Entry {
+            /**
+             * id of the live entity this one followed, ids stay unique
+             * while entities are deleted and their memory reused
+             */
+            unsigned long int previousId;
+            /** this one was the first entity, without previous one */
+            bool first;
+            /** order of compaction, keeps runs of entities in order */
+            unsigned long long order;
+        };
+        QHash<RS_Entity*, Entry> entities;
+        unsigned long long count = 0;
+        /** undo cycles closed since the last compaction */
+        int cycles = 0;
+    } undoneStore;
 };
 
 
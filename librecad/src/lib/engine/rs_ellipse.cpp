@@ -1545,8 +1545,9 @@ void RS_Ellipse::moveRef(const RS_Vector& ref, const RS_Vector& offset) {
 */
 bool RS_Ellipse::isVisibleInWindow(RS_GraphicView* view) const
 {
-    RS_Vector vpMin(view->toGraph(0,view->getHeight()));
-    RS_Vector vpMax(view->toGraph(view->getWidth(),0));
+    const LC_Rect viewArea = view->getViewArea();
+    RS_Vector vpMin(viewArea.minP());
+    RS_Vector vpMax(viewArea.maxP());
     //viewport
     QRectF visualRect(vpMin.x,vpMin.y,vpMax.x-vpMin.x, vpMax.y-vpMin.y);
     QPolygonF visualBox(visualRect);
@@ -1707,8 +1708,9 @@ void RS_Ellipse::draw(RS_Painter* painter, RS_GraphicView* view, double& pattern
         return;
     }
     //only draw the visible portion of line
-    RS_Vector vpMin(view->toGraph(0,view->getHeight()));
-    RS_Vector vpMax(view->toGraph(view->getWidth(),0));
+    const LC_Rect viewArea = view->getViewArea();
+    RS_Vector vpMin(viewArea.minP());
+    RS_Vector vpMax(viewArea.maxP());
     QPolygonF visualBox(QRectF(vpMin.x,vpMin.y,vpMax.x-vpMin.x, vpMax.y-vpMin.y));
 
     RS_Vector vpStart(isReversed()?getEndpoint():getStartpoint());
@@ -1783,12 +1785,12 @@ void RS_Ellipse::drawVisible(RS_Painter* painter, RS_GraphicView* view, double&
         return;
     }
 
-    bool drawAsSelected = isSelected() && !(view->isPrinting() || view->isPrintPreview());
+    bool drawAsSelected = view->isDrawnSelected(this) && !(view->isPrinting() || view->isPrintPreview());
 
     double mAngle=getAngle();
     RS_Vector cp(view->toGui(getCenter()));
 	if (!drawAsSelected && (
-             getPen().getLineType()==RS2::SolidLine ||
+             view->getDrawnPen(this).getLineType()==RS2::SolidLine ||
              view->getDrawingMode()==RS2::ModePreview)) {
         painter->drawEllipse(cp,
                              ra, rb,
@@ -1804,7 +1806,7 @@ void RS_Ellipse::drawVisible(RS_Painter* painter, RS_GraphicView* view, double&
 		pat = &RS_LineTypePattern::patternSelected;
 	}
 	else {
-		pat = view->getPattern(getPen().getLineType());
+		pat = view->getPattern(view->getDrawnPen(this).getLineType());
 	}
 
 	if (!pat) {
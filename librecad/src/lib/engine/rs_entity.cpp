@@ -26,6 +26,7 @@
 **********************************************************************/
 
 
+#include <atomic>
 #include <iostream>
 #include <utility>
 #include <QPolygon>
@@ -63,6 +64,13 @@ RS_Entity::RS_Entity(RS_EntityContainer* parent) {
 }
 
 
+RS_Entity::~RS_Entity() {
+    if (selectionRegistry.document) {
+        selectionRegistry.document->removeSelectionCandidate(this);
+    }
+}
+
+
 /**
  * Copy constructor.
  */
@@ -96,7 +104,8 @@ void RS_Entity::init() {
  * Gives this entity a new unique id.
  */
 void RS_Entity::initId() {
-    static unsigned long int idCounter=0;
+    // atomic: entities are also created by the regeneration threads
+    static std::atomic<unsigned long int> idCounter{0};
     id = idCounter++;
 }
 
@@ -140,6 +149,20 @@ bool RS_Entity::setSelected(bool select) {
         delFlag(RS2::FlagSelected);
     }
 
+    // keep the selection candidates of the document up to date,
+    // they drive the drawing of the selected entities
+    RS_Entity* top = this;
+    while (top->parent && !top->parent->isDocument()) {
+        top = top->parent;
+    }
+    if (top->parent) {
+        if (select) {
+            top->parent->addSelectionCandidate(top);
+        } else if (top == this) {
+            top->parent->removeSelectionCandidate(top);
+        }
+    }
+
     return true;
 }
 
@@ -290,8 +313,9 @@ bool RS_Entity::isArc() const
 /** whether the entity's bounding box intersects with visible portion of graphic view */
 bool RS_Entity::isVisibleInWindow(RS_GraphicView* view) const
 {
-    RS_Vector vpMin(view->toGraph(0,view->getHeight()));
-    RS_Vector vpMax(view->toGraph(view->getWidth(),0));
+    const LC_Rect viewArea = view->getViewArea();
+    RS_Vector vpMin(viewArea.minP());
+    RS_Vector vpMax(viewArea.maxP());
     if( getStartpoint().isInWindowOrdered(vpMin, vpMax) ) return true;
     if( getEndpoint().isInWindowOrdered(vpMin, vpMax) ) return true;
     QPolygonF visualBox(QRectF(vpMin.x,vpMin.y,vpMax.x-vpMin.x, vpMax.y-vpMin.y));
@@ -920,9 +944,10 @@ double RS_Entity::getStyleFactor(RS_GraphicView* view) {
 		}
 
 		// the factor caused by the line width:
-		if (((int)getPen(true).getWidth())>0) {
-			styleFactor *= ((double)getPen(true).getWidth()/100.0);
-		} else if (((int)getPen(true).getWidth())==0) {
+		const RS2::LineWidth width = view->getDrawnPen(this).getWidth();
+		if (((int)width)>0) {
+			styleFactor *= ((double)width/100.0);
+		} else if (((int)width)==0) {
 			styleFactor *= 0.01;
 		}
 	}
@@ -61,7 +61,7 @@ class QString;
 class RS_Entity : public RS_Undoable {
 public:
 	RS_Entity(RS_EntityContainer* parent=nullptr);
-	virtual ~RS_Entity() = default;
+	virtual ~RS_Entity();
 
     void init();
     virtual void initId();
@@ -580,6 +580,20 @@ protected:
 
 private:
 	std::map<QString, QString> varList;
+
+	/**
+	 * Document which holds this entity in its selection candidates.
+	 * Copies of an entity are not registered.
+	 */
+	struct SelectionRegistry {
+		SelectionRegistry() = default;
+		SelectionRegistry(const SelectionRegistry&) {}
+		SelectionRegistry& operator = (const SelectionRegistry&) { return *this; }
+
+		RS_EntityContainer* document = nullptr;
+	} selectionRegistry;
+
+	friend class RS_EntityContainer;
 };
 
 #endif
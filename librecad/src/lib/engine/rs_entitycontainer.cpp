@@ -32,6 +32,7 @@
 #include "rs_dialogfactory.h"
 #include "qg_dialogfactory.h"
 #include "rs_entitycontainer.h"
+#include "lc_connectivityindex.h"
 
 #include "rs_debug.h"
 #include "rs_dimension.h"
@@ -47,6 +48,15 @@
 #include "rs_constructionline.h"
 
 bool RS_EntityContainer::autoUpdateBorders = true;
+bool RS_EntityContainer::spatialIndexEnabled = true;
+
+namespace {
+/**
+ * containers with fewer entities are searched linearly, the index
+ * would not pay off for them
+ */
+const int spatialIndexThreshold = 1000;
+}
 
 /**
  * Default constructor.
@@ -82,6 +92,11 @@ RS_EntityContainer::RS_EntityContainer(const RS_EntityContainer& ec)
  * Destructor.
  */
 RS_EntityContainer::~RS_EntityContainer() {
+    for (RS_Entity* e: selectionCandidates) {
+        e->selectionRegistry.document = nullptr;
+    }
+    selectionCandidates.clear();
+
     if (autoDelete) {
         while (!entities.isEmpty())
             delete entities.takeFirst();
@@ -129,6 +144,9 @@ void RS_EntityContainer::detach() {
 
     // clear shared pointers:
     entities.clear();
+    spatialIndex.clear();
+    // the candidates are registered with the original container
+    selectionCandidates.clear();
     setOwner(autoDel);
 
     // point to new deep copies:
@@ -170,6 +188,7 @@ void RS_EntityContainer::setVisible(bool v) {
  * @return Total length of all entities in this container.
  */
 double RS_EntityContainer::getLength() const {
+    ensureEntities();
     double ret = 0.0;
 
 	for(auto e: entities){
@@ -209,6 +228,69 @@ bool RS_EntityContainer::setSelected(bool select) {
 
 
 
+const QSet<RS_Entity*>& RS_EntityContainer::getSelectionCandidates() const
+{
+	return selectionCandidates;
+}
+
+std::vector<RS_Entity*> RS_EntityContainer::getSelectionCandidatesInOrder() const
+{
+	std::vector<RS_Entity*> ret;
+	// a few candidates are sorted by the order kept in the index, many are
+	// picked from the entities
+	if (spatialIndex.isValid() && selectionCandidates.size() < entities.size() / 16) {
+		ret.assign(selectionCandidates.begin(), selectionCandidates.end());
+		spatialIndex.sortByOrder(ret);
+		return ret;
+	}
+	ret.reserve(selectionCandidates.size());
+	for (RS_Entity* e: entities) {
+		if (selectionCandidates.contains(e)) {
+			ret.push_back(e);
+		}
+	}
+	return ret;
+}
+
+void RS_EntityContainer::addSelectionCandidate(RS_Entity* entity)
+{
+	RS_EntityContainer*& document = entity->selectionRegistry.document;
+	if (document == this) {
+		return;
+	}
+	if (document) {
+		document->removeSelectionCandidate(entity);
+	}
+	selectionCandidates.insert(entity);
+	document = this;
+}
+
+void RS_EntityContainer::removeSelectionCandidate(RS_Entity* entity)
+{
+	if (entity->selectionRegistry.document == this) {
+		selectionCandidates.remove(entity);
+		entity->selectionRegistry.document = nullptr;
+	}
+}
+
+/**
+ * Registers entities added to a document which are already selected,
+ * e.g. clones of selected entities.
+ */
+void RS_EntityContainer::addedSelectionCandidate(RS_Entity* entity)
+{
+	if (isDocument()
+			&& (entity->getFlag(RS2::FlagSelected)
+				|| (entity->isContainer()
+					// entities yet to be created take the selection of their container
+					&& !static_cast<RS_EntityContainer*>(entity)->entitiesPending
+					&& static_cast<RS_EntityContainer*>(entity)->countSelected() > 0))) {
+		addSelectionCandidate(entity);
+	}
+}
+
+
+
 /**
  * Toggles select on this entity.
  */
@@ -236,11 +318,19 @@ bool RS_EntityContainer::toggleSelected() {
  * @param select True to select, False to deselect the entities.
  */
 void RS_EntityContainer::selectWindow(RS_Vector v1, RS_Vector v2,
-                                      bool select, bool cross) {
+                                      bool select, bool cross,
+                                      std::vector<RS_Entity*>* changed) {
+	ensureEntities();
 
     bool included;
 
-	for(auto e: entities){
+	// entities outside of the window can neither be included nor crossed
+	const LC_EntityIndex* index = getSpatialIndex();
+	const std::vector<RS_Entity*> candidates = index
+			? index->intersecting(v1, v2)
+			: std::vector<RS_Entity*>(entities.begin(), entities.end());
+
+	for(auto e: candidates){
 
         included = false;
 
@@ -286,8 +376,8 @@ void RS_EntityContainer::selectWindow(RS_Vector v1, RS_Vector v2,
             }
         }
 
-        if (included) {
-            e->setSelected(select);
+        if (included && e->setSelected(select) && changed) {
+            changed->push_back(e);
         }
     }
 }
@@ -299,6 +389,7 @@ void RS_EntityContainer::selectWindow(RS_Vector v1, RS_Vector v2,
  * entity-container if autoUpdateBorders is true.
  */
 void RS_EntityContainer::addEntity(RS_Entity* entity) {
+    ensureEntities();
     /*
        if (isDocument()) {
            RS_LayerList* lst = getDocument()->getLayerList();
@@ -316,9 +407,12 @@ void RS_EntityContainer::addEntity(RS_Entity* entity) {
     if (entity->rtti()==RS2::EntityImage ||
             entity->rtti()==RS2::EntityHatch) {
         entities.prepend(entity);
+        spatialIndex.prepend(entity);
     } else {
         entities.append(entity);
+        spatialIndex.append(entity);
     }
+    addedSelectionCandidate(entity);
     if (autoUpdateBorders) {
         adjustBorders(entity);
     }
@@ -330,9 +424,12 @@ void RS_EntityContainer::addEntity(RS_Entity* entity) {
  * borders of this entity-container if autoUpdateBorders is true.
  */
 void RS_EntityContainer::appendEntity(RS_Entity* entity){
+	ensureEntities();
 	if (!entity)
         return;
     entities.append(entity);
+    spatialIndex.append(entity);
+    addedSelectionCandidate(entity);
     if (autoUpdateBorders)
         adjustBorders(entity);
 }
@@ -342,8 +439,11 @@ void RS_EntityContainer::appendEntity(RS_Entity* entity){
  * borders of this entity-container if autoUpdateBorders is true.
  */
 void RS_EntityContainer::prependEntity(RS_Entity* entity){
+	ensureEntities();
 	if (!entity) return;
     entities.prepend(entity);
+    spatialIndex.prepend(entity);
+    addedSelectionCandidate(entity);
     if (autoUpdateBorders)
         adjustBorders(entity);
 }
@@ -353,6 +453,7 @@ void RS_EntityContainer::prependEntity(RS_Entity* entity){
  * the borders of this entity-container if autoUpdateBorders is true.
  */
 void RS_EntityContainer::moveEntity(int index, QList<RS_Entity *>& entList){
+    ensureEntities();
     if (entList.isEmpty()) return;
     int ci = 0; //current index for insert without invert order
     bool ret, into = false;
@@ -381,6 +482,8 @@ void RS_EntityContainer::moveEntity(int index, QList<RS_Entity *>& entList){
 	for(auto e: entList){
             entities.insert(ci++, e);
     }
+    // drawing order has changed
+    spatialIndex.clear();
 }
 
 /**
@@ -388,9 +491,19 @@ void RS_EntityContainer::moveEntity(int index, QList<RS_Entity *>& entList){
  * the borders of this entity-container if autoUpdateBorders is true.
  */
 void RS_EntityContainer::insertEntity(int index, RS_Entity* entity) {
+	ensureEntities();
 	if (!entity) return;
 
     entities.insert(index, entity);
+    if (index <= 0) {
+        spatialIndex.prepend(entity);
+    } else if (index >= entities.size() - 1) {
+        spatialIndex.append(entity);
+    } else {
+        // the drawing order is kept by the index, rebuild it on demand
+        spatialIndex.clear();
+    }
+    addedSelectionCandidate(entity);
 
     if (autoUpdateBorders) {
         adjustBorders(entity);
@@ -405,6 +518,7 @@ void RS_EntityContainer::insertEntity(int index, RS_Entity* entity) {
  */
 /*RLZ unused function
 void RS_EntityContainer::replaceEntity(int index, RS_Entity* entity) {
+    ensureEntities();
 //RLZ TODO: is needed to delete the old entity? not documented in Q3PtrList
 //    investigate in qt3support code if reactivate this function.
 	if (!entity) {
@@ -425,11 +539,16 @@ void RS_EntityContainer::replaceEntity(int index, RS_Entity* entity) {
  * this entity-container if autoUpdateBorders is true.
  */
 bool RS_EntityContainer::removeEntity(RS_Entity* entity) {
+	ensureEntities();
 	//RLZ TODO: in Q3PtrList if 'entity' is nullptr remove the current item-> at.(entIdx)
     //    and sets 'entIdx' in next() or last() if 'entity' is the last item in the list.
 	//    in LibreCAD is never called with nullptr
     bool ret;
     ret = entities.removeOne(entity);
+    if (ret) {
+        spatialIndex.remove(entity);
+        removeSelectionCandidate(entity);
+    }
 
     if (autoDelete && ret) {
         delete entity;
@@ -446,15 +565,22 @@ bool RS_EntityContainer::removeEntity(RS_Entity* entity) {
  * Erases all entities in this container and resets the borders..
  */
 void RS_EntityContainer::clear() {
+    for (RS_Entity* e: selectionCandidates) {
+        e->selectionRegistry.document = nullptr;
+    }
+    selectionCandidates.clear();
     if (autoDelete) {
         while (!entities.isEmpty())
             delete entities.takeFirst();
     } else
         entities.clear();
+    entitiesPending = false;
+    spatialIndex.clear();
     resetBorders();
 }
 
 unsigned int RS_EntityContainer::count() const{
+    ensureEntities();
     return entities.size();
 }
 
@@ -463,6 +589,7 @@ unsigned int RS_EntityContainer::count() const{
  * Counts all entities (leaves of the tree).
  */
 unsigned int RS_EntityContainer::countDeep() const{
+	ensureEntities();
 	unsigned int c=0;
 	for(auto t: *this){
 		c += t->countDeep();
@@ -476,10 +603,13 @@ unsigned int RS_EntityContainer::countDeep() const{
  * Counts the selected entities in this container.
  */
 unsigned int RS_EntityContainer::countSelected(bool deep, std::initializer_list<RS2::EntityType> const& types) {
+    ensureEntities();
     unsigned int c=0;
 	std::set<RS2::EntityType> type = types;
 
-	for (RS_Entity* t: entities){
+	// the selected entities of a document are among its selection candidates
+	const QList<RS_Entity*>& candidates = isDocument() ? selectionCandidates.values() : entities;
+	for (RS_Entity* t: candidates){
 
 		if (t->isSelected())
 			if (!types.size() || type.count(t->rtti()))
@@ -493,11 +623,13 @@ unsigned int RS_EntityContainer::countSelected(bool deep, std::initializer_list<
 }
 
 /**
- * Counts the selected entities in this container.
+ * Sums up the lengths of the selected entities in this container.
  */
 double RS_EntityContainer::totalSelectedLength() {
+    ensureEntities();
     double ret(0.0);
-	for (RS_Entity* e: entities){
+	const QList<RS_Entity*>& candidates = isDocument() ? selectionCandidates.values() : entities;
+	for (RS_Entity* e: candidates){
 
         if (e->isVisible() && e->isSelected()) {
             double l = e->getLength();
@@ -538,7 +670,7 @@ void RS_EntityContainer::adjustBorders(RS_Entity* entity) {
  * Recalculates the borders of this entity container.
  */
 void RS_EntityContainer::calculateBorders() {
-    RS_DEBUG->print("RS_EntityContainer::calculateBorders");
+    RS_DEBUG_PRINT("RS_EntityContainer::calculateBorders");
 
 	resetBorders();
 	for (RS_Entity* e: entities){
@@ -548,13 +680,16 @@ void RS_EntityContainer::calculateBorders() {
         //        RS_DEBUG->print("RS_EntityContainer::calculateBorders: "
         //                        "isVisible: %d", (int)e->isVisible());
 
+        // hidden entities keep up to date boxes in the index, they are
+        // found again once they are shown
+        e->calculateBorders();
 		if (e->isVisible() && !(layer && layer->isFrozen())) {
-            e->calculateBorders();
             adjustBorders(e);
         }
+        spatialIndex.update(e);
     }
 
-    RS_DEBUG->print("RS_EntityContainer::calculateBorders: size 1: %f,%f",
+    RS_DEBUG_PRINT("RS_EntityContainer::calculateBorders: size 1: %f,%f",
                     getSize().x, getSize().y);
 
     // needed for correcting corrupt data (PLANS.dxf)
@@ -571,7 +706,7 @@ void RS_EntityContainer::calculateBorders() {
         maxV.y = 0.0;
     }
 
-    RS_DEBUG->print("RS_EntityContainer::calculateBorders: size: %f,%f",
+    RS_DEBUG_PRINT("RS_EntityContainer::calculateBorders: size: %f,%f",
                     getSize().x, getSize().y);
 
     //RS_DEBUG->print("  borders: %f/%f %f/%f", minV.x, minV.y, maxV.x, maxV.y);
@@ -597,6 +732,12 @@ void RS_EntityContainer::calculateBorders() {
 void RS_EntityContainer::forcedCalculateBorders() {
     //RS_DEBUG->print("RS_EntityContainer::calculateBorders");
 
+    if (entitiesPending) {
+        // the borders don't depend on entities which are not created yet
+        calculateBorders();
+        return;
+    }
+
     resetBorders();
     for (RS_Entity* e: entities){
 
@@ -608,6 +749,7 @@ void RS_EntityContainer::forcedCalculateBorders() {
             e->calculateBorders();
         }
         adjustBorders(e);
+        spatialIndex.update(e);
     }
 
     // needed for correcting corrupt data (PLANS.dxf)
@@ -637,6 +779,7 @@ void RS_EntityContainer::forcedCalculateBorders() {
  * @param autoText Automatically reposition the text label bool autoText=true
  */
 void RS_EntityContainer::updateDimensions(bool autoText) {
+    ensureEntities();
 
     RS_DEBUG->print("RS_EntityContainer::updateDimensions()");
 
@@ -664,26 +807,27 @@ void RS_EntityContainer::updateDimensions(bool autoText) {
  * Updates all Insert entities in this container.
  */
 void RS_EntityContainer::updateInserts() {
+    ensureEntities();
 
-    RS_DEBUG->print("RS_EntityContainer::updateInserts() ID/type: %d/%d", getId(), rtti());
+    RS_DEBUG_PRINT("RS_EntityContainer::updateInserts() ID/type: %d/%d", getId(), rtti());
 
     for (RS_Entity* e: entities){
         //// Only update our own inserts and not inserts of inserts
         if (e->rtti()==RS2::EntityInsert  /*&& e->getParent()==this*/) {
             ((RS_Insert*)e)->update();
-            RS_DEBUG->print("RS_EntityContainer::updateInserts: updated ID/type: %d/%d", e->getId(), e->rtti());
+            RS_DEBUG_PRINT("RS_EntityContainer::updateInserts: updated ID/type: %d/%d", e->getId(), e->rtti());
         } else if (e->isContainer()) {
             if (e->rtti()==RS2::EntityHatch) {
-                RS_DEBUG->print(RS_Debug::D_DEBUGGING, "RS_EntityContainer::updateInserts: skip hatch ID/type: %d/%d", e->getId(), e->rtti());
+                RS_DEBUG_PRINT("RS_EntityContainer::updateInserts: skip hatch ID/type: %d/%d", e->getId(), e->rtti());
             } else {
-                RS_DEBUG->print("RS_EntityContainer::updateInserts: update container ID/type: %d/%d", e->getId(), e->rtti());
+                RS_DEBUG_PRINT("RS_EntityContainer::updateInserts: update container ID/type: %d/%d", e->getId(), e->rtti());
                 ((RS_EntityContainer*)e)->updateInserts();
             }
         } else {
-            RS_DEBUG->print(RS_Debug::D_DEBUGGING, "RS_EntityContainer::updateInserts: skip entity ID/type: %d/%d", e->getId(), e->rtti());
+            RS_DEBUG_PRINT("RS_EntityContainer::updateInserts: skip entity ID/type: %d/%d", e->getId(), e->rtti());
         }
     }
-    RS_DEBUG->print("RS_EntityContainer::updateInserts() ID/type: %d/%d OK", getId(), rtti());
+    RS_DEBUG_PRINT("RS_EntityContainer::updateInserts() ID/type: %d/%d OK", getId(), rtti());
 }
 
 
@@ -694,6 +838,7 @@ void RS_EntityContainer::updateInserts() {
  */
 void RS_EntityContainer::renameInserts(const QString& oldName,
                                        const QString& newName) {
+    ensureEntities();
     RS_DEBUG->print("RS_EntityContainer::renameInserts()");
 
     //for (RS_Entity* e=firstEntity(RS2::ResolveNone);
@@ -719,6 +864,7 @@ void RS_EntityContainer::renameInserts(const QString& oldName,
  * Updates all Spline entities in this container.
  */
 void RS_EntityContainer::updateSplines() {
+    ensureEntities();
 
     RS_DEBUG->print("RS_EntityContainer::updateSplines()");
 
@@ -739,8 +885,10 @@ void RS_EntityContainer::updateSplines() {
  * Updates the sub entities of this container.
  */
 void RS_EntityContainer::update() {
+	ensureEntities();
 	for (RS_Entity* e: entities){
 		e->update();
+		spatialIndex.update(e);
     }
 }
 
@@ -757,6 +905,7 @@ void RS_EntityContainer::addRectangle(RS_Vector const& v0, RS_Vector const& v1)
  * @param level
  */
 RS_Entity* RS_EntityContainer::firstEntity(RS2::ResolveLevel level) {
+	ensureEntities();
 	RS_Entity* e = nullptr;
     entIdx = -1;
     switch (level) {
@@ -839,6 +988,7 @@ RS_Entity* RS_EntityContainer::firstEntity(RS2::ResolveLevel level) {
  *              \li \p 2 all Entity Containers are resolved
  */
 RS_Entity* RS_EntityContainer::lastEntity(RS2::ResolveLevel level) {
+	ensureEntities();
 	RS_Entity* e = nullptr;
 	if(!entities.size()) return nullptr;
     entIdx = entities.size()-1;
@@ -1096,6 +1246,7 @@ RS_Entity* RS_EntityContainer::prevEntity(RS2::ResolveLevel level) {
  * @return Entity at the given index or nullptr if the index is out of range.
  */
 RS_Entity* RS_EntityContainer::entityAt(int index) {
+    ensureEntities();
     if (entities.size() > index && index >= 0)
         return entities.at(index);
     else
@@ -1103,10 +1254,18 @@ RS_Entity* RS_EntityContainer::entityAt(int index) {
 }
 
 void RS_EntityContainer::setEntityAt(int index,RS_Entity* en){
+	ensureEntities();
+	spatialIndex.replace(entities.at(index), en);
+	if (entities.at(index)) {
+		removeSelectionCandidate(entities.at(index));
+	}
 	if(autoDelete && entities.at(index)) {
 		delete entities.at(index);
 	}
 	entities[index] = en;
+	if (en) {
+		addedSelectionCandidate(en);
+	}
 }
 
 /**
@@ -1122,6 +1281,7 @@ int RS_EntityContainer::entityAt() {
  * Finds the given entity and makes it the current entity if found.
  */
 int RS_EntityContainer::findEntity(RS_Entity const* const entity) {
+	ensureEntities();
 	entIdx = entities.indexOf(const_cast<RS_Entity*>(entity));
     return entIdx;
 }
@@ -1132,13 +1292,14 @@ int RS_EntityContainer::findEntity(RS_Entity const* const entity) {
  */
 RS_Vector RS_EntityContainer::getNearestEndpoint(const RS_Vector& coord,
                                                  double* dist  )const {
+    ensureEntities();
 
     double minDist = RS_MAXDOUBLE;  // minimum measured distance
     double curDist;                 // currently measured distance
     RS_Vector closestPoint(false);  // closest found endpoint
     RS_Vector point;                // endpoint found
 
-	for (RS_Entity* en: entities){
+	visitNearest(coord, [&](RS_Entity* en) {
 
 		if (en->isVisible()
                 && !en->getParent()->ignoredOnModification()
@@ -1152,7 +1313,8 @@ RS_Vector RS_EntityContainer::getNearestEndpoint(const RS_Vector& coord,
                 }
             }
         }
-    }
+        return minDist;
+    });
 
     return closestPoint;
 }
@@ -1165,6 +1327,7 @@ RS_Vector RS_EntityContainer::getNearestEndpoint(const RS_Vector& coord,
  */
 RS_Vector RS_EntityContainer::getNearestEndpoint(const RS_Vector& coord,
                                                  double* dist,  RS_Entity** pEntity)const {
+    ensureEntities();
 
     double minDist = RS_MAXDOUBLE;  // minimum measured distance
     double curDist;                 // currently measured distance
@@ -1176,10 +1339,8 @@ RS_Vector RS_EntityContainer::getNearestEndpoint(const RS_Vector& coord,
 	//while ( (en = it.current())  ) {
     //    ++it;
 
-    unsigned i0=0;
-	for(auto en: entities){
+	visitNearest(coord, [&](RS_Entity* en) {
         if (!en->getParent()->ignoredOnModification() ){//no end point for Insert, text, Dim
-//            std::cout<<"find nearest for entity "<<i0<<std::endl;
             point = en->getNearestEndpoint(coord, &curDist);
             if (point.valid && curDist<minDist) {
                 closestPoint = point;
@@ -1192,8 +1353,8 @@ RS_Vector RS_EntityContainer::getNearestEndpoint(const RS_Vector& coord,
                 }
             }
         }
-        i0++;
-    }
+        return minDist;
+    });
 
 //    std::cout<<__FILE__<<" : "<<__func__<<" : line "<<__LINE__<<std::endl;
 //    std::cout<<"count()="<<const_cast<RS_EntityContainer*>(this)->count()<<"\tminDist= "<<minDist<<"\tclosestPoint="<<closestPoint;
@@ -1206,6 +1367,7 @@ RS_Vector RS_EntityContainer::getNearestEndpoint(const RS_Vector& coord,
 
 RS_Vector RS_EntityContainer::getNearestPointOnEntity(const RS_Vector& coord,
                                                       bool onEntity, double* dist, RS_Entity** entity)const {
+    ensureEntities();
 
     RS_Vector point(false);
 
@@ -1224,6 +1386,7 @@ RS_Vector RS_EntityContainer::getNearestPointOnEntity(const RS_Vector& coord,
 
 RS_Vector RS_EntityContainer::getNearestCenter(const RS_Vector& coord,
 											   double* dist) const{
+    ensureEntities();
     double minDist = RS_MAXDOUBLE;  // minimum measured distance
     double curDist = RS_MAXDOUBLE;  // currently measured distance
     RS_Vector closestPoint(false);  // closest found endpoint
@@ -1254,12 +1417,13 @@ RS_Vector RS_EntityContainer::getNearestMiddle(const RS_Vector& coord,
                                                double* dist,
                                                int middlePoints
                                                ) const{
+    ensureEntities();
     double minDist = RS_MAXDOUBLE;  // minimum measured distance
     double curDist = RS_MAXDOUBLE;  // currently measured distance
     RS_Vector closestPoint(false);  // closest found endpoint
     RS_Vector point;                // endpoint found
 
-	for(auto en: entities){
+	visitNearest(coord, [&](RS_Entity* en) {
 
         if (en->isVisible()
 				&& !en->getParent()->ignoredSnap()
@@ -1270,7 +1434,8 @@ RS_Vector RS_EntityContainer::getNearestMiddle(const RS_Vector& coord,
                 minDist = curDist;
             }
         }
-    }
+        return minDist;
+    });
 	if (dist) {
         *dist = minDist;
     }
@@ -1283,6 +1448,7 @@ RS_Vector RS_EntityContainer::getNearestMiddle(const RS_Vector& coord,
 RS_Vector RS_EntityContainer::getNearestDist(double distance,
                                              const RS_Vector& coord,
 											 double* dist) const{
+    ensureEntities();
 
     RS_Vector point(false);
     RS_Entity* closestEntity;
@@ -1303,6 +1469,7 @@ RS_Vector RS_EntityContainer::getNearestDist(double distance,
  */
 RS_Vector RS_EntityContainer::getNearestIntersection(const RS_Vector& coord,
                                                      double* dist) {
+    ensureEntities();
 
     double minDist = RS_MAXDOUBLE;  // minimum measured distance
     double curDist = RS_MAXDOUBLE;  // currently measured distance
@@ -1313,27 +1480,44 @@ RS_Vector RS_EntityContainer::getNearestIntersection(const RS_Vector& coord,
 
 	closestEntity = getNearestEntity(coord, nullptr, RS2::ResolveAllButTextImage);
 
-	if (closestEntity) {
+    auto intersect = [&](RS_Entity* en) {
+        if (!en->isVisible() || en->getParent()->ignoredSnap()) {
+            return;
+        }
+
+        sol = RS_Information::getIntersection(closestEntity, en, true);
+
+        point=sol.getClosest(coord,&curDist,nullptr);
+        if(sol.getNumber()>0 && curDist<minDist){
+            closestPoint=point;
+            minDist=curDist;
+        }
+    };
+
+	const LC_EntityIndex* index = getSpatialIndex();
+	if (closestEntity && index
+			&& closestEntity->rtti() != RS2::EntityConstructionLine) {
+		// only entities with overlapping bounding boxes can intersect
+		for (RS_Entity* e: index->intersecting(closestEntity->getMin(),
+											   closestEntity->getMax(),
+											   RS_TOLERANCE)) {
+			if (e->isContainer()
+					&& e->rtti() != RS2::EntityText && e->rtti() != RS2::EntityMText) {
+				RS_EntityContainer* ec = static_cast<RS_EntityContainer*>(e);
+				for (RS_Entity* en = ec->firstEntity(RS2::ResolveAllButTextImage);
+					 en;
+					 en = ec->nextEntity(RS2::ResolveAllButTextImage)) {
+					intersect(en);
+				}
+			} else {
+				intersect(e);
+			}
+		}
+	} else if (closestEntity) {
         for (RS_Entity* en = firstEntity(RS2::ResolveAllButTextImage);
              en;
              en = nextEntity(RS2::ResolveAllButTextImage)) {
-            if (
-                    !en->isVisible()
-					|| en->getParent()->ignoredSnap()
-                    ){
-                continue;
-            }
-
-            sol = RS_Information::getIntersection(closestEntity,
-                                                  en,
-                                                  true);
-
-			point=sol.getClosest(coord,&curDist,nullptr);
-            if(sol.getNumber()>0 && curDist<minDist){
-                closestPoint=point;
-                minDist=curDist;
-            }
-
+			intersect(en);
         }
     }
 	if(dist && closestPoint.valid) {
@@ -1347,6 +1531,7 @@ RS_Vector RS_EntityContainer::getNearestVirtualIntersection(const RS_Vector& coo
                                                             const double& angle,
                                                             double* dist)
 {
+    ensureEntities();
 
     RS_Vector point;                // endpoint found
     RS_VectorSolutions sol;
@@ -1383,6 +1568,7 @@ RS_Vector RS_EntityContainer::getNearestVirtualIntersection(const RS_Vector& coo
 
 RS_Vector RS_EntityContainer::getNearestRef(const RS_Vector& coord,
 											double* dist) const{
+    ensureEntities();
 
     double minDist = RS_MAXDOUBLE;  // minimum measured distance
     double curDist;                 // currently measured distance
@@ -1409,6 +1595,7 @@ RS_Vector RS_EntityContainer::getNearestRef(const RS_Vector& coord,
 
 RS_Vector RS_EntityContainer::getNearestSelectedRef(const RS_Vector& coord,
 													double* dist) const{
+    ensureEntities();
 
     double minDist = RS_MAXDOUBLE;  // minimum measured distance
     double curDist;                 // currently measured distance
@@ -1437,25 +1624,27 @@ double RS_EntityContainer::getDistanceToPoint(const RS_Vector& coord,
                                               RS_Entity** entity,
                                               RS2::ResolveLevel level,
                                               double solidDist) const{
+    ensureEntities();
 
-    RS_DEBUG->print("RS_EntityContainer::getDistanceToPoint");
+    RS_DEBUG_PRINT("RS_EntityContainer::getDistanceToPoint");
 
 
     double minDist = RS_MAXDOUBLE;      // minimum measured distance
     double curDist;                     // currently measured distance
 	RS_Entity* closestEntity = nullptr;    // closest entity found
+	long long closestOrder = 0;            // container position of the entity holding closestEntity
 	RS_Entity* subEntity = nullptr;
 
-	for(auto e: entities){
+	visitNearestWithOrder(coord, [&](RS_Entity* e, long long order) {
 
         if (e->isVisible()) {
-            RS_DEBUG->print("entity: getDistanceToPoint");
-            RS_DEBUG->print("entity: %d", e->rtti());
+            RS_DEBUG_PRINT("entity: getDistanceToPoint");
+            RS_DEBUG_PRINT("entity: %d", e->rtti());
             // bug#426, need to ignore Images to find nearest intersections
-            if(level==RS2::ResolveAllButTextImage && e->rtti()==RS2::EntityImage) continue;
+            if(level==RS2::ResolveAllButTextImage && e->rtti()==RS2::EntityImage) return minDist;
             curDist = e->getDistanceToPoint(coord, &subEntity, level, solidDist);
 
-            RS_DEBUG->print("entity: getDistanceToPoint: OK");
+            RS_DEBUG_PRINT("entity: getDistanceToPoint: OK");
 
 			/*
 			 * By using '<=', we will prefer the *last* item in the container if there are multiple
@@ -1465,8 +1654,11 @@ double RS_EntityContainer::getDistanceToPoint(const RS_Vector& coord,
 			 * drawn directly over top of another, and it's reasonable to assume that humans will
 			 * tend to want to reference entities that they see or have recently drawn as opposed
 			 * to deeper more forgotten and invisible ones...
+			 * The index visits entities sorted by distance, so the container order
+			 * is compared explicitly.
 			 */
-			if (curDist<=minDist)
+			if (curDist<minDist
+					|| (curDist==minDist && (minDist>=RS_MAXDOUBLE || order > closestOrder)))
 			{
                 switch(level){
                 case RS2::ResolveAll:
@@ -1476,15 +1668,17 @@ double RS_EntityContainer::getDistanceToPoint(const RS_Vector& coord,
                 default:
                     closestEntity = e;
                 }
+                closestOrder = order;
                 minDist = curDist;
             }
         }
-    }
+        return minDist;
+    });
 
 	if (entity) {
         *entity = closestEntity;
     }
-    RS_DEBUG->print("RS_EntityContainer::getDistanceToPoint: OK");
+    RS_DEBUG_PRINT("RS_EntityContainer::getDistanceToPoint: OK");
 
     return minDist;
 }
@@ -1494,8 +1688,9 @@ double RS_EntityContainer::getDistanceToPoint(const RS_Vector& coord,
 RS_Entity* RS_EntityContainer::getNearestEntity(const RS_Vector& coord,
                                                 double* dist,
 												RS2::ResolveLevel level) const{
+    ensureEntities();
 
-    RS_DEBUG->print("RS_EntityContainer::getNearestEntity");
+    RS_DEBUG_PRINT("RS_EntityContainer::getNearestEntity");
 
 	RS_Entity* e = nullptr;
 
@@ -1515,7 +1710,7 @@ RS_Entity* RS_EntityContainer::getNearestEntity(const RS_Vector& coord,
 	if (dist) {
         *dist = d;
     }
-    RS_DEBUG->print("RS_EntityContainer::getNearestEntity: OK");
+    RS_DEBUG_PRINT("RS_EntityContainer::getNearestEntity: OK");
 
     return e;
 }
@@ -1533,18 +1728,15 @@ RS_Entity* RS_EntityContainer::getNearestEntity(const RS_Vector& coord,
  * to do: find closed contour by flood-fill
  */
 bool RS_EntityContainer::optimizeContours() {
-//    std::cout<<"RS_EntityContainer::optimizeContours: begin"<<std::endl;
-
-//    DEBUG_HEADER
-//    std::cout<<"loop with count()="<<count()<<std::endl;
+    ensureEntities();
     RS_DEBUG->print("RS_EntityContainer::optimizeContours");
 
-    RS_EntityContainer tmp;
-    tmp.setAutoUpdateBorders(false);
-    bool closed=true;
-
-    /** accept all full circles **/
+    /** new entities in contour order, accept all full circles **/
+    QList<RS_Entity*> sorted;
+    /** entities to remove: full circles and unsupported entities **/
     QList<RS_Entity*> enList;
+    /** edges to connect **/
+    std::vector<RS_Entity*> edges;
 	for(auto e1: entities){
         if (!e1->isEdge() || e1->isContainer() ) {
             enList<<e1;
@@ -1554,101 +1746,106 @@ bool RS_EntityContainer::optimizeContours() {
         //detect circles and whole ellipses
         switch(e1->rtti()){
         case RS2::EntityEllipse:
-			if(static_cast<RS_Ellipse*>(e1)->isEllipticArc())
+			if(static_cast<RS_Ellipse*>(e1)->isEllipticArc()) {
+                edges.push_back(e1);
                 continue;
+            }
             // fall-through
         case RS2::EntityCircle:
             //directly detect circles, bug#3443277
-            tmp.addEntity(e1->clone());
+            sorted<<e1->clone();
             enList<<e1;
-            // fall-through
-        default:
             continue;
+        default:
+            edges.push_back(e1);
         }
+    }
 
+    /** connect entities by their endpoints **/
+    LC_ConnectivityIndex index;
+    for (RS_Entity* e: edges) {
+        index.insert(e);
     }
-    //    std::cout<<"RS_EntityContainer::optimizeContours: 1"<<std::endl;
-
-    /** remove unsupported entities */
-    for(RS_Entity* it: enList)
-        removeEntity(it);
-
-    /** check and form a closed contour **/
-//    std::cout<<"RS_EntityContainer::optimizeContours: 2"<<std::endl;
-    /** the first entity **/
-	RS_Entity* current(nullptr);
-    if(count()>0) {
-        current=entityAt(0)->clone();
-        tmp.addEntity(current);
-        removeEntity(entityAt(0));
-    }else {
-        if(tmp.count()==0) return false;
-    }
-//    std::cout<<"RS_EntityContainer::optimizeContours: 3"<<std::endl;
-    RS_Vector vpStart;
-    RS_Vector vpEnd;
-	if(current){
-        vpStart=current->getStartpoint();
-        vpEnd=current->getEndpoint();
-    }
-	RS_Entity* next(nullptr);
-//    std::cout<<"RS_EntityContainer::optimizeContours: 4"<<std::endl;
-    /** connect entities **/
+    QSet<RS_Entity*> used;
+    size_t first = 0;
+    bool closed = true;
+    RS_Vector vpStart(false);
+    RS_Vector vpEnd(false);
     const QString errMsg=QObject::tr("Hatch failed due to a gap=%1 between (%2, %3) and (%4, %5)");
 
-    while(count()>0) {
-        double dist(0.);
-        RS_Vector&& vpTmp=getNearestEndpoint(vpEnd,&dist,&next);
-        if(dist>1e-8) {
-            if(vpEnd.squaredTo(vpStart) < 1e-8) {
-                RS_Entity* e2=entityAt(0);
-                tmp.addEntity(e2->clone());
-                vpStart=e2->getStartpoint();
-                vpEnd=e2->getEndpoint();
-                removeEntity(e2);
-                continue;
-            }
-            else {
-                QG_DIALOGFACTORY->commandMessage(
-                            errMsg.arg(dist).arg(vpTmp.x).arg(vpTmp.y).arg(vpEnd.x).arg(vpEnd.y)
-                            );
-                RS_DEBUG->print(RS_Debug::D_ERROR, "RS_EntityContainer::optimizeContours: hatch failed due to a gap");
-                closed=false;
-                break;
+    while ((size_t) used.size() < edges.size()) {
+        RS_Entity* next = nullptr;
+        double dist = RS_MAXDOUBLE;
+        for (RS_Entity* e: index.getConnected(vpEnd)) {
+            double curDist;
+            e->getNearestEndpoint(vpEnd, &curDist);
+            if (curDist < dist) {
+                dist = curDist;
+                next = e;
             }
         }
-        if(!next) { 	    //workaround if next is nullptr
-//      	    std::cout<<"RS_EntityContainer::optimizeContours: next is nullptr" <<std::endl;
-            RS_DEBUG->print("RS_EntityContainer::optimizeContours: next is nullptr");
-//			closed=false;	//workaround if next is nullptr
-            break;			//workaround if next is nullptr
-        } 					//workaround if next is nullptr
-        if(closed) {
-            next->setProcessed(true);
-            RS_Entity* eTmp = next->clone();
+
+        RS_Entity* eTmp = nullptr;
+        if (next && dist <= 1e-8) {
+            eTmp = next->clone();
             if(vpEnd.squaredTo(eTmp->getStartpoint())>vpEnd.squaredTo(eTmp->getEndpoint()))
                 eTmp->revertDirection();
             vpEnd=eTmp->getEndpoint();
-            tmp.addEntity(eTmp);
-        	removeEntity(next);
+        } else if (!vpEnd.valid || vpEnd.squaredTo(vpStart) < 1e-8) {
+            // the contour is closed, start the next one
+            while (used.contains(edges[first])) {
+                ++first;
+            }
+            next = edges[first];
+            eTmp = next->clone();
+            vpStart=eTmp->getStartpoint();
+            vpEnd=eTmp->getEndpoint();
+        } else {
+            RS_Vector vpTmp(false);
+            for (RS_Entity* e: edges) {
+                double curDist;
+                RS_Vector point = used.contains(e) ? RS_Vector(false)
+                                                   : e->getNearestEndpoint(vpEnd, &curDist);
+                if (point.valid && (!vpTmp.valid || curDist < dist)) {
+                    vpTmp = point;
+                    dist = curDist;
+                }
+            }
+            QG_DIALOGFACTORY->commandMessage(
+                        errMsg.arg(dist).arg(vpTmp.x).arg(vpTmp.y).arg(vpEnd.x).arg(vpEnd.y)
+                        );
+            RS_DEBUG->print(RS_Debug::D_ERROR, "RS_EntityContainer::optimizeContours: hatch failed due to a gap");
+            closed=false;
+            break;
         }
+
+        sorted<<eTmp;
+        index.remove(next);
+        used.insert(next);
     }
-//    DEBUG_HEADER
-//    if(vpEnd.valid && vpEnd.squaredTo(vpStart) > 1e-8) {
-//		QG_DIALOGFACTORY->commandMessage(errMsg.arg(vpEnd.distanceTo(vpStart))
-//											 .arg(vpStart.x).arg(vpStart.y).arg(vpEnd.x).arg(vpEnd.y));
-//        RS_DEBUG->print("RS_EntityContainer::optimizeContours: hatch failed due to a gap");
-//        closed=false;
-//    }
-//    std::cout<<"RS_EntityContainer::optimizeContours: 5"<<std::endl;
 
+    if (edges.empty() && sorted.empty()) {
+        closed = false;
+    }
 
-    // add new sorted entities:
-	for(auto en: tmp){
-		en->setProcessed(false);
-        addEntity(en->clone());
+    /** replace the entities, the edges not connected come first **/
+    QList<RS_Entity*> remaining;
+    for (RS_Entity* e: edges) {
+        if (used.contains(e)) {
+            enList<<e;
+        } else {
+            remaining<<e;
+        }
+    }
+    for (RS_Entity* e: enList) {
+        removeSelectionCandidate(e);
+        if (autoDelete) {
+            delete e;
+        }
     }
-//    std::cout<<"RS_EntityContainer::optimizeContours: 6"<<std::endl;
+    entities = remaining + sorted;
+    spatialIndex.clear();
+    calculateBorders();
 
     if(closed) {
         RS_DEBUG->print("RS_EntityContainer::optimizeContours: OK");
@@ -1656,13 +1853,12 @@ bool RS_EntityContainer::optimizeContours() {
     else {
         RS_DEBUG->print("RS_EntityContainer::optimizeContours: bad");
     }
-//    std::cout<<"RS_EntityContainer::optimizeContours: end: count()="<<count()<<std::endl;
-//    std::cout<<"RS_EntityContainer::optimizeContours: closed="<<closed<<std::endl;
     return closed;
 }
 
 
 bool RS_EntityContainer::hasEndpointsWithinWindow(const RS_Vector& v1, const RS_Vector& v2) {
+	ensureEntities();
 	for(auto e: entities){
         if (e->hasEndpointsWithinWindow(v1, v2))  {
             return true;
@@ -1674,6 +1870,8 @@ bool RS_EntityContainer::hasEndpointsWithinWindow(const RS_Vector& v1, const RS_
 
 
 void RS_EntityContainer::move(const RS_Vector& offset) {
+	ensureEntities();
+	spatialIndex.clear();
 	for(auto e: entities){
 
         e->move(offset);
@@ -1689,7 +1887,9 @@ void RS_EntityContainer::move(const RS_Vector& offset) {
 
 
 void RS_EntityContainer::rotate(const RS_Vector& center, const double& angle) {
+    ensureEntities();
     RS_Vector angleVector(angle);
+    spatialIndex.clear();
 
 	for(auto e: entities){
         e->rotate(center, angleVector);
@@ -1701,6 +1901,8 @@ void RS_EntityContainer::rotate(const RS_Vector& center, const double& angle) {
 
 
 void RS_EntityContainer::rotate(const RS_Vector& center, const RS_Vector& angleVector) {
+    ensureEntities();
+    spatialIndex.clear();
 
 	for(auto e: entities){
         e->rotate(center, angleVector);
@@ -1712,6 +1914,8 @@ void RS_EntityContainer::rotate(const RS_Vector& center, const RS_Vector& angleV
 
 
 void RS_EntityContainer::scale(const RS_Vector& center, const RS_Vector& factor) {
+    ensureEntities();
+    spatialIndex.clear();
     if (fabs(factor.x)>RS_TOLERANCE && fabs(factor.y)>RS_TOLERANCE) {
 
 		for(auto e: entities){
@@ -1726,6 +1930,8 @@ void RS_EntityContainer::scale(const RS_Vector& center, const RS_Vector& factor)
 
 
 void RS_EntityContainer::mirror(const RS_Vector& axisPoint1, const RS_Vector& axisPoint2) {
+    ensureEntities();
+    spatialIndex.clear();
 	if (axisPoint1.distanceTo(axisPoint2)>RS_TOLERANCE) {
 
 		for(auto e: entities){
@@ -1738,7 +1944,9 @@ void RS_EntityContainer::mirror(const RS_Vector& axisPoint1, const RS_Vector& ax
 void RS_EntityContainer::stretch(const RS_Vector& firstCorner,
                                  const RS_Vector& secondCorner,
                                  const RS_Vector& offset) {
+    ensureEntities();
 
+    spatialIndex.clear();
     if (getMin().isInWindow(firstCorner, secondCorner) &&
             getMax().isInWindow(firstCorner, secondCorner)) {
 
@@ -1758,7 +1966,8 @@ void RS_EntityContainer::stretch(const RS_Vector& firstCorner,
 
 void RS_EntityContainer::moveRef(const RS_Vector& ref,
                                  const RS_Vector& offset) {
-
+	ensureEntities();
+	spatialIndex.clear();
 
 	for(auto e: entities){
         e->moveRef(ref, offset);
@@ -1771,7 +1980,8 @@ void RS_EntityContainer::moveRef(const RS_Vector& ref,
 
 void RS_EntityContainer::moveSelectedRef(const RS_Vector& ref,
                                          const RS_Vector& offset) {
-
+	ensureEntities();
+	spatialIndex.clear();
 
 	for(auto e: entities){
         e->moveSelectedRef(ref, offset);
@@ -1782,6 +1992,8 @@ void RS_EntityContainer::moveSelectedRef(const RS_Vector& ref,
 }
 
 void RS_EntityContainer::revertDirection() {
+	ensureEntities();
+	spatialIndex.clear();
 	for(int k = 0; k < entities.size() / 2; ++k) {
 		entities.swap(k, entities.size() - 1 - k);
 	}
@@ -1803,6 +2015,17 @@ void RS_EntityContainer::draw(RS_Painter* painter, RS_GraphicView* view,
         return;
     }
 
+    // large containers only draw the entities within the visible area,
+    // printing always draws everything
+    const LC_EntityIndex* index = view->isPrinting() ? nullptr : getSpatialIndex();
+    if (index) {
+        const LC_Rect area = view->getDrawingArea();
+        for (RS_Entity* e: index->intersecting(area.minP(), area.maxP(), 0., true)) {
+            view->drawEntity(painter, e);
+        }
+        return;
+    }
+
     foreach (auto e, entities)
     {
         view->drawEntity(painter, e);
@@ -1816,6 +2039,7 @@ void RS_EntityContainer::draw(RS_Painter* painter, RS_GraphicView* view,
  */
 double RS_EntityContainer::areaLineIntegral() const
 {
+    ensureEntities();
     //TODO make sure all contour integral is by counter-clockwise
     double contourArea=0.;
     //closed area is always positive
@@ -1845,6 +2069,59 @@ double RS_EntityContainer::areaLineIntegral() const
     return fabs(contourArea)+closedArea;
 }
 
+void RS_EntityContainer::setSpatialIndexEnabled(bool enable)
+{
+	spatialIndexEnabled = enable;
+}
+
+bool RS_EntityContainer::isSpatialIndexEnabled()
+{
+	return spatialIndexEnabled;
+}
+
+const LC_EntityIndex* RS_EntityContainer::getSpatialIndex() const
+{
+	if (!spatialIndexEnabled || entities.size() < spatialIndexThreshold) {
+		return nullptr;
+	}
+	if (!spatialIndex.isValid()) {
+		RS_DEBUG->print("RS_EntityContainer::getSpatialIndex: building index of %d entities",
+						entities.size());
+		spatialIndex.build(std::vector<RS_Entity*>(entities.begin(), entities.end()));
+	}
+	return &spatialIndex;
+}
+
+void RS_EntityContainer::visitNearest(const RS_Vector& coord,
+									  const std::function<double(RS_Entity*)>& visitor) const
+{
+	visitNearestWithOrder(coord, [&visitor](RS_Entity* e, long long) {
+		return visitor(e);
+	});
+}
+
+void RS_EntityContainer::visitNearestWithOrder(const RS_Vector& coord,
+											   const std::function<double(RS_Entity*, long long)>& visitor) const
+{
+	const LC_EntityIndex* index = getSpatialIndex();
+	if (!index) {
+		long long order = 0;
+		for (RS_Entity* e: entities) {
+			visitor(e, order++);
+		}
+		return;
+	}
+
+	double minDist = RS_MAXDOUBLE;
+	index->visitByDistance(coord, [&](RS_Entity* e, double boxDist, long long order) {
+		if (boxDist > minDist) {
+			return false;
+		}
+		minDist = visitor(e, order);
+		return true;
+	});
+}
+
 bool RS_EntityContainer::ignoredOnModification() const
 {
     switch(rtti()){
@@ -1875,23 +2152,39 @@ bool RS_EntityContainer::ignoredSnap() const
 	return ignoredOnModification();
 }
 
+/**
+ * Creates the entities of containers which defer the creation until
+ * the entities are needed.
+ */
+void RS_EntityContainer::ensureEntities() const
+{
+	if (entitiesPending) {
+		entitiesPending = false;
+		createEntities();
+	}
+}
+
 QList<RS_Entity *>::const_iterator RS_EntityContainer::begin() const
 {
+	ensureEntities();
 	return entities.begin();
 }
 
 QList<RS_Entity *>::const_iterator RS_EntityContainer::end() const
 {
+	ensureEntities();
 	return entities.end();
 }
 
 QList<RS_Entity *>::iterator RS_EntityContainer::begin()
 {
+	ensureEntities();
 	return entities.begin();
 }
 
 QList<RS_Entity *>::iterator RS_EntityContainer::end()
 {
+	ensureEntities();
 	return entities.end();
 }
 
@@ -1961,15 +2254,18 @@ std::ostream& operator << (std::ostream& os, RS_EntityContainer& ec) {
 
 RS_Entity* RS_EntityContainer::first() const
 {
+	ensureEntities();
 	return entities.first();
 }
 
 RS_Entity* RS_EntityContainer::last() const
 {
+	ensureEntities();
 	return entities.last();
 }
 
 const QList<RS_Entity*>& RS_EntityContainer::getEntityList()
 {
+    ensureEntities();
     return entities;
 }
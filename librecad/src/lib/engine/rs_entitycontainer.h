@@ -28,8 +28,11 @@
 #ifndef RS_ENTITYCONTAINER_H
 #define RS_ENTITYCONTAINER_H
 
+#include <functional>
 #include <vector>
+#include <QSet>
 #include "rs_entity.h"
+#include "lc_entityindex.h"
 
 /**
  * Class representing a tree of entities.
@@ -79,8 +82,29 @@ public:
 	bool setSelected(bool select=true) override;
 	bool toggleSelected() override;
 
+	/**
+	 * @brief getSelectionCandidates entities of this document which are
+	 * selected or hold selected sub-entities. Maintained by
+	 * RS_Entity::setSelected() for the top level entities of documents.
+	 * The set may contain entities which lost the selection of their
+	 * sub-entities in the meantime, it is a superset of the selection.
+	 */
+	const QSet<RS_Entity*>& getSelectionCandidates() const;
+	/**
+	 * @brief getSelectionCandidatesInOrder the selection candidates in the
+	 * order of this container, which is the drawing order
+	 */
+	std::vector<RS_Entity*> getSelectionCandidatesInOrder() const;
+	void addSelectionCandidate(RS_Entity* entity);
+	void removeSelectionCandidate(RS_Entity* entity);
+
+	/**
+	 * (De)selects the entities in the window v1, v2. The entities whose
+	 * selection changed are added to changed, if given.
+	 */
 	virtual void selectWindow(RS_Vector v1, RS_Vector v2,
-				bool select=true, bool cross=false);
+				bool select=true, bool cross=false,
+				std::vector<RS_Entity*>* changed=nullptr);
 
     virtual void addEntity(RS_Entity* entity);
     virtual void appendEntity(RS_Entity* entity);
@@ -129,6 +153,12 @@ public:
     virtual void setAutoUpdateBorders(bool enable) {
         autoUpdateBorders = enable;
     }
+    /**
+     * Enables / disables the bounding box index used by nearest entity
+     * and window queries of large containers. By default this is turned on.
+     */
+    static void setSpatialIndexEnabled(bool enable);
+    static bool isSpatialIndexEnabled();
     virtual void adjustBorders(RS_Entity* entity);
 	void calculateBorders() override;
 	void forcedCalculateBorders();
@@ -233,10 +263,29 @@ public:
     const QList<RS_Entity*>& getEntityList();
 
 protected:
+    /**
+     * Creates the entities of containers which create them on demand,
+     * e.g. inserts sharing the geometry of their block. Called once
+     * entitiesPending is set and the entities are accessed.
+     * Any walk over the entities creates them, e.g. begin(), entityAt(),
+     * getNearestEntity() or resolving with RS2::ResolveAll, which
+     * selection, snapping and export do. Once created they stay in memory
+     * until clear(), which RS_Insert::update() calls when the insert or
+     * its block change.
+     */
+    virtual void createEntities() const {}
+    void ensureEntities() const;
 
     /** entities in the container */
     QList<RS_Entity *> entities;
 
+    /** top level entities which are or hold selected entities */
+    QSet<RS_Entity*> selectionCandidates;
+    void addedSelectionCandidate(RS_Entity* entity);
+
+    /** the entities are created by createEntities() when they are accessed */
+    mutable bool entitiesPending = false;
+
     /** sub container used only temporarily for iteration. */
     RS_EntityContainer* subContainer;
 
@@ -246,6 +295,37 @@ protected:
      */
     static bool autoUpdateBorders;
 
+    /**
+     * Bounding box index of the entities, built on demand for large
+     * containers and maintained by entity additions, removals and
+     * border calculations.
+     */
+    mutable LC_EntityIndex spatialIndex;
+
+    static bool spatialIndexEnabled;
+
+    /**
+     * @brief getSpatialIndex index of the entities, built if necessary
+     * @return nullptr, if this container is too small to be indexed
+     */
+    const LC_EntityIndex* getSpatialIndex() const;
+    /**
+     * @brief visitNearest calls visitor for candidates of a nearest entity
+     * search. Indexed containers visit the entities by increasing distance of
+     * their bounding boxes and stop, once a bounding box is further away than
+     * the minimum distance returned by the visitor.
+     * Entities must not be closer to coord than their bounding box is.
+     */
+    void visitNearest(const RS_Vector& coord,
+                      const std::function<double(RS_Entity*)>& visitor) const;
+    /**
+     * @brief visitNearestWithOrder like visitNearest(), the visitor also
+     * gets the position of the entity in this container, relative to the
+     * other entities only.
+     */
+    void visitNearestWithOrder(const RS_Vector& coord,
+                               const std::function<double(RS_Entity*, long long)>& visitor) const;
+
 private:
 	/**
 	 * @brief ignoredSnap whether snapping is ignored
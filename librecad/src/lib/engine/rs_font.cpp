@@ -27,10 +27,12 @@
 
 
 #include <iostream>
+#include <QDataStream>
 #include <QTextStream>
 #include <QTextCodec>
 
 #include "rs_font.h"
+#include "lc_fontcache.h"
 #include "rs_arc.h"
 #include "rs_line.h"
 #include "rs_polyline.h"
@@ -54,6 +56,8 @@ RS_Font::RS_Font(const QString& fileName, bool owner)
     rawLffFontList.clear();
 }
 
+RS_Font::~RS_Font() = default;
+
 
 
 /**
@@ -278,11 +282,21 @@ void RS_Font::readCXF(QString path) {
 }
 
 void RS_Font::readLFF(QString path) {
+    encoding = "UTF-8";
+    glyphCache.reset();
+    if (LC_FontCache::isEnabled()) {
+        glyphCache.reset(new LC_FontCache(path));
+        if (glyphCache->load()) {
+            readProperties(glyphCache->getProperties());
+            return;
+        }
+    }
+
     QString line;
     QFile f(path);
-    encoding = "UTF-8";
     f.open(QIODevice::ReadOnly);
     QTextStream ts(&f);
+    QRegExp regexp("[0-9A-Fa-f]{1,5}");
 
     // Read line by line until we find a new letter:
     while (!ts.atEnd()) {
@@ -328,7 +342,6 @@ void RS_Font::readLFF(QString path) {
             QChar ch;
 
             // read unicode:
-            QRegExp regexp("[0-9A-Fa-f]{1,5}");
             regexp.indexIn(line);
             QString cap = regexp.cap();
             if (!cap.isNull()) {
@@ -355,34 +368,43 @@ void RS_Font::readLFF(QString path) {
         }
     }
     f.close();
-}
 
-void RS_Font::generateAllFonts(){
-    QMap<QString, QStringList>::const_iterator i = rawLffFontList.constBegin();
-    while (i != rawLffFontList.constEnd()) {
-        generateLffFont(i.key());
-        ++i;
+    // compile the letters once, later sessions map the cache
+    if (glyphCache) {
+        for (auto it = rawLffFontList.constBegin(); it != rawLffFontList.constEnd(); ++it) {
+            glyphCache->addGlyph(it.key().at(0).unicode(), compileLffLetter(it.value()));
+        }
+        glyphCache->setProperties(writeProperties());
+        glyphCache->save();
+        rawLffFontList.clear();
     }
 }
 
-RS_Block* RS_Font::generateLffFont(const QString& ch){
-        if(rawLffFontList.contains(ch) == false ){
-                RS_DEBUG->print("RS_Font::generateLffFont(QChar %s ) : can not find the letter in given lff font file",qPrintable(ch));
-				return nullptr;
-        }
-    // create new letter:
-    RS_FontChar* letter =
-			new RS_FontChar(nullptr, ch, RS_Vector(0.0, 0.0));
+QByteArray RS_Font::writeProperties() const {
+    QByteArray properties;
+    QDataStream ds(&properties, QIODevice::WriteOnly);
+    ds << letterSpacing << wordSpacing << lineSpacingFactor
+       << names << authors << fileLicense << encoding << fileCreate;
+    return properties;
+}
 
-    // Read entities of this letter:
+void RS_Font::readProperties(const QByteArray& properties) {
+    QDataStream ds(properties);
+    ds >> letterSpacing >> wordSpacing >> lineSpacingFactor
+       >> names >> authors >> fileLicense >> encoding >> fileCreate;
+}
+
+/**
+ * Compiles the lines of a lff letter to the values of the glyph cache:
+ * 0, code for a letter inserted from the font
+ * 1, n, x1, y1, bulge1, ... xn, yn, bulgen for a polyline of n vertices
+ */
+std::vector<double> RS_Font::compileLffLetter(const QStringList& fontData) {
+    std::vector<double> values;
     QStringList vertex;
     QStringList coords;
-    QStringList fontData=rawLffFontList[ch];
-    QString line;
-
-    while(fontData.isEmpty() == false) {
-        line = fontData.takeFirst();
 
+    for (QString line: fontData) {
         if (line.isEmpty()) {
             continue;
         }
@@ -390,19 +412,9 @@ RS_Block* RS_Font::generateLffFont(const QString& ch){
         // Defined char:
         if (line.at(0)=='C') {
             line.remove(0,1);
-			int uCode = line.toInt(nullptr, 16);
-            QChar ch = QChar(uCode);
-            RS_Block* bk = letterList.find(ch);
-			if (!bk && rawLffFontList.contains(ch)) {
-                generateLffFont(ch);
-                bk = letterList.find(ch);
-            }
-			if (bk) {
-                RS_Entity* bk2 = bk->clone();
-                bk2->setPen(RS_Pen(RS2::FlagInvalid));
-				bk2->setLayer(nullptr);
-                letter->addEntity(bk2);
-            }
+            int uCode = line.toInt(nullptr, 16);
+            values.push_back(0.);
+            values.push_back(QChar(uCode).unicode());
         }
         //sequence:
         else {
@@ -410,30 +422,114 @@ RS_Block* RS_Font::generateLffFont(const QString& ch){
             //at least is required two vertex
             if (vertex.size()<2)
                 continue;
-            RS_Polyline* pline = new RS_Polyline(letter, RS_PolylineData());
-            pline->setPen(RS_Pen(RS2::FlagInvalid));
-			pline->setLayer(nullptr);
+            values.push_back(1.);
+            const size_t count = values.size();
+            values.push_back(0.);
             for (int i = 0; i < vertex.size(); ++i) {
-                double x1, y1;
                 double bulge = 0;
 
                 coords = vertex.at(i).split(',', QString::SkipEmptyParts);
                 //at least X,Y is required
                 if (coords.size()<2)
                     continue;
-                x1 = coords.at(0).toDouble();
-                y1 = coords.at(1).toDouble();
                 //check presence of bulge
                 if (coords.size() == 3 && coords.at(2).at(0) == QChar('A')){
                     QString bulgeStr = coords.at(2);
                     bulge = bulgeStr.remove(0,1).toDouble();
                 }
+                values.push_back(coords.at(0).toDouble());
+                values.push_back(coords.at(1).toDouble());
+                values.push_back(bulge);
+                values[count] += 1.;
+            }
+        }
+    }
+    return values;
+}
+
+void RS_Font::generateAllFonts(){
+    if (glyphCache) {
+        for (unsigned code: glyphCache->getCodes()) {
+            QString ch(QChar(static_cast<ushort>(code)));
+            if (!letterList.find(ch)) {
+                generateLffFont(ch);
+            }
+        }
+        return;
+    }
+    QMap<QString, QStringList>::const_iterator i = rawLffFontList.constBegin();
+    while (i != rawLffFontList.constEnd()) {
+        generateLffFont(i.key());
+        ++i;
+    }
+}
+
+bool RS_Font::hasLffLetter(const QString& ch) const {
+    if (glyphCache) {
+        size_t size = 0;
+        return ch.size() == 1 && glyphCache->getGlyph(ch.at(0).unicode(), &size);
+    }
+    return rawLffFontList.contains(ch);
+}
+
+RS_Block* RS_Font::generateLffFont(const QString& ch){
+    std::vector<double> compiled;
+    const double* values = nullptr;
+    size_t size = 0;
+    if (glyphCache) {
+        if (ch.size() == 1) {
+            values = glyphCache->getGlyph(ch.at(0).unicode(), &size);
+        }
+    } else if (rawLffFontList.contains(ch)) {
+        compiled = compileLffLetter(rawLffFontList[ch]);
+        values = compiled.data();
+        size = compiled.size();
+    }
+    if (!values) {
+        RS_DEBUG->print("RS_Font::generateLffFont(QChar %s ) : can not find the letter in given lff font file",qPrintable(ch));
+        return nullptr;
+    }
+
+    // create new letter:
+    RS_FontChar* letter =
+			new RS_FontChar(nullptr, ch, RS_Vector(0.0, 0.0));
+
+    // Create entities of this letter:
+    size_t i = 0;
+    while (i + 1 < size) {
+        // Defined char:
+        if (values[i] == 0.) {
+            QChar ch = QChar(static_cast<ushort>(values[i + 1]));
+            i += 2;
+            RS_Block* bk = letterList.find(ch);
+			if (!bk && hasLffLetter(ch)) {
+                generateLffFont(ch);
+                bk = letterList.find(ch);
+            }
+			if (bk) {
+                RS_Entity* bk2 = bk->clone();
+                bk2->setPen(RS_Pen(RS2::FlagInvalid));
+				bk2->setLayer(nullptr);
+                letter->addEntity(bk2);
+            }
+        }
+        //sequence:
+        else {
+            const size_t count = static_cast<size_t>(values[i + 1]);
+            i += 2;
+            if (count > (size - i) / 3) {
+                break;
+            }
+            RS_Polyline* pline = new RS_Polyline(letter, RS_PolylineData());
+            pline->setPen(RS_Pen(RS2::FlagInvalid));
+			pline->setLayer(nullptr);
+            for (size_t j = 0; j < count; ++j, i += 3) {
+                const double bulge = values[i + 2];
                 pline->setNextBulge(bulge);
-                pline->addVertex(RS_Vector(x1, y1), bulge);
+                pline->addVertex(RS_Vector(values[i], values[i + 1]), bulge);
             }
             letter->addEntity(pline);
         }
-
     }
 
     if (letter->isEmpty()) {
@@ -447,6 +543,8 @@ RS_Block* RS_Font::generateLffFont(const QString& ch){
 }
 
 RS_Block* RS_Font::findLetter(const QString& name) {
+    // letters are generated on demand, also by the regeneration threads
+    QMutexLocker locker(&letterMutex);
     RS_Block* ret= letterList.find(name);
 	if (ret) return ret;
     return generateLffFont(name);
@@ -29,10 +29,15 @@
 #define RS_FONT_H
 
 #include <iosfwd>
+#include <memory>
+#include <vector>
 #include <QStringList>
 #include <QMap>
+#include <QMutex>
 #include "rs_blocklist.h"
 
+class LC_FontCache;
+
 /**
  * Class for representing a font. This is implemented as a RS_Graphic
  * with a name (the font name) and several blocks, one for each letter
@@ -44,6 +49,7 @@ class RS_Font {
 public:
     RS_Font(const QString& name, bool owner=true);
     //RS_Font(const char* name);
+    ~RS_Font();
 
     /** @return the fileName of this font. */
     QString getFileName() const {
@@ -117,13 +123,22 @@ private:
     void readCXF(QString path);
     void readLFF(QString path);
     RS_Block* generateLffFont(const QString& ch);
+    bool hasLffLetter(const QString& ch) const;
+    /** glyph values of the lines of a lff letter, as stored in the cache */
+    static std::vector<double> compileLffLetter(const QStringList& fontData);
+    QByteArray writeProperties() const;
+    void readProperties(const QByteArray& properties);
 
 private:
     //raw lff font file list, not processed into blocks yet
     QMap<QString, QStringList> rawLffFontList;
+    //! compiled lff letters, replaces rawLffFontList if available
+    std::unique_ptr<LC_FontCache> glyphCache;
 
         //! block list (letters)
         RS_BlockList letterList;
+    //! Guards the letters generated on demand by findLetter()
+    QMutex letterMutex;
 
     //! Font file name
     QString fileName;
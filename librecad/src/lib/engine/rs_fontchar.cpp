@@ -0,0 +1,85 @@
+/****************************************************************************
+**
+** This file is part of the LibreCAD project, a 2D CAD program
+**
+** Copyright (C) 2010 R. van Twisk (librecad@rvt.dds.nl)
+** Copyright (C) 2001-2003 RibbonSoft. All rights reserved.
+**
+**
+** This file may be distributed and/or modified under the terms of the
+** GNU General Public License version 2 as published by the Free Software 
+** Foundation and appearing in the file gpl-2.0.txt included in the
+** packaging of this file.
+**
+** This program is distributed in the hope that it will be useful,
+** but WITHOUT ANY WARRANTY; without even the implied warranty of
+** MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+** GNU General Public License for more details.
+** 
+** You should have received a copy of the GNU General Public License
+** along with this program; if not, write to the Free Software
+** Foundation, Inc., 51 Franklin Street, Fifth Floor, Boston, MA  02110-1301  USA
+**
+** This copyright notice MUST APPEAR in all copies of the script!  
+**
+**********************************************************************/
+
+
+#include "rs_fontchar.h"
+#include "rs_arc.h"
+#include "rs_line.h"
+#include "rs_math.h"
+
+namespace {
+void addToPath(QPainterPath& path, const RS_Vector& start)
+{
+    if (path.elementCount() == 0
+            || RS_Vector(path.currentPosition().x(), path.currentPosition().y()).distanceTo(start) > RS_TOLERANCE) {
+        path.moveTo(start.x, start.y);
+    }
+}
+
+void addToPath(QPainterPath& path, RS_Entity const* e)
+{
+    switch (e->rtti()) {
+    case RS2::EntityLine: {
+        auto line = static_cast<RS_Line const*>(e);
+        addToPath(path, line->getStartpoint());
+        path.lineTo(line->getEndpoint().x, line->getEndpoint().y);
+        break;
+    }
+    case RS2::EntityArc: {
+        auto arc = static_cast<RS_Arc const*>(e);
+        // arcs are kept as curves, which the painter flattens for the
+        // size they are drawn at. Qt measures angles clockwise in the
+        // y-up block coordinates, hence the negated angles.
+        const double r = arc->getRadius();
+        const RS_Vector& c = arc->getCenter();
+        const double angleLength = RS_Math::rad2deg(arc->getAngleLength());
+        addToPath(path, arc->getStartpoint());
+        path.arcTo(QRectF(c.x - r, c.y - r, 2. * r, 2. * r),
+                   -RS_Math::rad2deg(arc->getAngle1()),
+                   arc->isReversed() ? angleLength : -angleLength);
+        break;
+    }
+    default:
+        if (e->isContainer()) {
+            for (RS_Entity const* child: *static_cast<RS_EntityContainer const*>(e)) {
+                addToPath(path, child);
+            }
+        }
+        break;
+    }
+}
+}
+
+const QPainterPath& RS_FontChar::getPath() const {
+    if (!pathValid) {
+        path = QPainterPath();
+        for (RS_Entity const* e: *this) {
+            addToPath(path, e);
+        }
+        pathValid = true;
+    }
+    return path;
+}
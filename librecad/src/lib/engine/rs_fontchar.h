@@ -28,11 +28,15 @@
 #ifndef RS_FONTCHAR_H
 #define RS_FONTCHAR_H
 
+#include <QPainterPath>
+
 #include "rs_block.h"
 
 
 /**
  * A character in a font is represented by this special block class.
+ * Letters don't change once the font is loaded, so their outline is
+ * cached for drawing.
  *
  * @author Andrew Mustun
  */
@@ -56,6 +60,13 @@ public:
         return RS2::EntityFontChar;
     }
 
+    /**
+     * @return Outline of the letter in block coordinates, made of the
+     * lines and arcs of the letter. Arcs are kept as curves, so the
+     * outline is exact at any zoom.
+     */
+    const QPainterPath& getPath() const;
+
 
     /*friend std::ostream& operator << (std::ostream& os, const RS_FontChar& b) {
        	os << " name: " << b.getName().latin1() << "\n";
@@ -65,6 +76,8 @@ public:
 
 
 protected:
+    mutable QPainterPath path;
+    mutable bool pathValid = false;
 };
 
 
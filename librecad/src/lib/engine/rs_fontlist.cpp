@@ -26,6 +26,7 @@
 
 #include <iostream>
 #include <QHash>
+#include <QMutex>
 #include "rs_fontlist.h"
 #include "rs_debug.h"
 #include "rs_font.h"
@@ -111,6 +112,8 @@ RS_Font* RS_FontList::requestFont(const QString& name) {
 
         if (f->getFileName().toLower() == name2) {
             // Make sure this font is loaded into memory:
+            static QMutex loadMutex;
+            QMutexLocker locker(&loadMutex);
             f->loadFont();
 			foundFont = f.get();
             break;
@@ -30,6 +30,7 @@
 #include <QBrush>
 #include <QString>
 #include "rs_hatch.h"
+#include "lc_hatchscanline.h"
 
 #include "rs_arc.h"
 #include "rs_circle.h"
@@ -102,14 +103,14 @@ bool RS_Hatch::validate() {
 
 
 RS_Entity* RS_Hatch::clone() const{
-    RS_DEBUG->print(RS_Debug::D_DEBUGGING, "RS_Hatch::clone()");
+    RS_DEBUG_PRINT("RS_Hatch::clone()");
     RS_Hatch* t = new RS_Hatch(*this);
     t->setOwner(isOwner());
     t->initId();
     t->detach();
     t->update();
 //    t->hatch = nullptr;
-    RS_DEBUG->print(RS_Debug::D_DEBUGGING, "RS_Hatch::clone(): OK");
+    RS_DEBUG_PRINT("RS_Hatch::clone(): OK");
     return t;
 }
 
@@ -133,13 +134,13 @@ bool RS_Hatch::isContainer() const {
  * Recalculates the borders of this hatch.
  */
 void RS_Hatch::calculateBorders() {
-    RS_DEBUG->print("RS_Hatch::calculateBorders");
+    RS_DEBUG_PRINT("RS_Hatch::calculateBorders");
 
     activateContour(true);
 
     RS_EntityContainer::calculateBorders();
 
-        RS_DEBUG->print("RS_Hatch::calculateBorders: size: %f,%f",
+        RS_DEBUG_PRINT("RS_Hatch::calculateBorders: size: %f,%f",
                 getSize().x, getSize().y);
 
     activateContour(false);
@@ -155,7 +156,7 @@ void RS_Hatch::calculateBorders() {
  */
 void RS_Hatch::update() {
 
-    RS_DEBUG->print(RS_Debug::D_DEBUGGING, "RS_Hatch::update");
+    RS_DEBUG_PRINT("RS_Hatch::update");
 
     updateError = HATCH_OK;
     if (updateRunning) {
@@ -169,12 +170,12 @@ void RS_Hatch::update() {
     }
 
     if (data.solid==true) {
-        RS_DEBUG->print(RS_Debug::D_DEBUGGING, "RS_Hatch::update: processing solid hatch");
+        RS_DEBUG_PRINT("RS_Hatch::update: processing solid hatch");
         calculateBorders();
         return;
     }
 
-    RS_DEBUG->print(RS_Debug::D_DEBUGGING, "RS_Hatch::update: contour has %d loops", count());
+    RS_DEBUG_PRINT("RS_Hatch::update: contour has %d loops", count());
     updateRunning = true;
 
     // save attributes for the current hatch
@@ -201,7 +202,7 @@ void RS_Hatch::update() {
     }
 
     // search for pattern
-    RS_DEBUG->print(RS_Debug::D_DEBUGGING, "RS_Hatch::update: requesting pattern");
+    RS_DEBUG_PRINT("RS_Hatch::update: requesting pattern");
     RS_Pattern* pat = RS_PATTERNLIST->requestPattern(data.pattern);
 	if (!pat) {
         updateRunning = false;
@@ -209,12 +210,12 @@ void RS_Hatch::update() {
         updateError = HATCH_PATTERN_NOT_FOUND;
         return;
     } else {
-        RS_DEBUG->print(RS_Debug::D_DEBUGGING, "RS_Hatch::update: requesting pattern: OK");
+        RS_DEBUG_PRINT("RS_Hatch::update: requesting pattern: OK");
         // make a working copy of hatch pattern
-        RS_DEBUG->print(RS_Debug::D_DEBUGGING, "RS_Hatch::update: cloning pattern");
+        RS_DEBUG_PRINT("RS_Hatch::update: cloning pattern");
         pat = (RS_Pattern*)pat->clone();
         if (pat) {
-            RS_DEBUG->print(RS_Debug::D_DEBUGGING, "RS_Hatch::update: cloning pattern: OK");
+            RS_DEBUG_PRINT("RS_Hatch::update: cloning pattern: OK");
         } else {
             RS_DEBUG->print(RS_Debug::D_ERROR, "RS_Hatch::update: error while cloning hatch pattern");
             return;
@@ -222,11 +223,11 @@ void RS_Hatch::update() {
     }
 
     // scale pattern
-    RS_DEBUG->print(RS_Debug::D_DEBUGGING, "RS_Hatch::update: scaling pattern");
+    RS_DEBUG_PRINT("RS_Hatch::update: scaling pattern");
     pat->scale(RS_Vector(0.0,0.0), RS_Vector(data.scale, data.scale));
     pat->calculateBorders();
     forcedCalculateBorders();
-    RS_DEBUG->print(RS_Debug::D_DEBUGGING, "RS_Hatch::update: scaling pattern: OK");
+    RS_DEBUG_PRINT("RS_Hatch::update: scaling pattern: OK");
 
     // find out how many pattern-instances we need in x/y:
     int px1, py1, px2, py2;
@@ -241,8 +242,8 @@ void RS_Hatch::update() {
 //    RS_Vector cPos = getMin();
     RS_Vector cSize = getSize();
 
-    RS_DEBUG->print(RS_Debug::D_DEBUGGING, "RS_Hatch::update: pattern size: %f/%f", pSize.x, pSize.y);
-    RS_DEBUG->print(RS_Debug::D_DEBUGGING, "RS_Hatch::update: contour size: %f/%f", cSize.x, cSize.y);
+    RS_DEBUG_PRINT("RS_Hatch::update: pattern size: %f/%f", pSize.x, pSize.y);
+    RS_DEBUG_PRINT("RS_Hatch::update: contour size: %f/%f", cSize.x, cSize.y);
 
     // check pattern sizes for sanity
     if (cSize.x<1.0e-6 || cSize.y<1.0e-6 ||
@@ -282,7 +283,7 @@ void RS_Hatch::update() {
     RS_EntityContainer tmp;   // container for untrimmed lines
 
     // adding array of patterns to tmp:
-    RS_DEBUG->print(RS_Debug::D_DEBUGGING, "RS_Hatch::update: creating pattern carpet");
+    RS_DEBUG_PRINT("RS_Hatch::update: creating pattern carpet");
     for (int px=px1; px<px2; px++) {
 		for (int py=py1; py<py2; py++) {
 			for(auto e: *pat){
@@ -298,11 +299,17 @@ void RS_Hatch::update() {
     pat = nullptr;
     delete copy;
     copy = nullptr;
-    RS_DEBUG->print(RS_Debug::D_DEBUGGING, "RS_Hatch::update: creating pattern carpet: OK");
+    RS_DEBUG_PRINT("RS_Hatch::update: creating pattern carpet: OK");
 
     // cut pattern to contour shape
-    RS_DEBUG->print(RS_Debug::D_DEBUGGING, "RS_Hatch::update: cutting pattern carpet");
+    RS_DEBUG_PRINT("RS_Hatch::update: cutting pattern carpet");
     RS_EntityContainer tmp2;   // container for small cut lines
+    // the scanline engine trims line patterns directly to the pieces
+    // inside the contour, the carpet is not cut below then
+    const bool trimmed = scanlineEnabled && LC_HatchScanline::trim(*this, tmp, tmp2);
+    if (trimmed) {
+        tmp.clear();
+    }
 	RS_Line* line = nullptr;
 	RS_Arc* arc = nullptr;
 	RS_Circle* circle = nullptr;
@@ -370,7 +377,7 @@ void RS_Hatch::update() {
                     for (const RS_Vector& vp: sol) {
 						if (vp.valid) {
 							is.append(vp);
-                            RS_DEBUG->print(RS_Debug::D_DEBUGGING, "  pattern line intersection: %f/%f", vp.x, vp.y);
+                            RS_DEBUG_PRINT("  pattern line intersection: %f/%f", vp.x, vp.y);
 						}
 					}
 				}
@@ -469,7 +476,7 @@ void RS_Hatch::update() {
     } // end for very very long for(auto e: tmp) loop
 
     // updating hatch / adding entities that are inside
-    RS_DEBUG->print(RS_Debug::D_DEBUGGING, "RS_Hatch::update: cutting pattern carpet: OK");
+    RS_DEBUG_PRINT("RS_Hatch::update: cutting pattern carpet: OK");
 
     //RS_EntityContainer* rubbish = new RS_EntityContainer(getGraphic());
 
@@ -480,8 +487,20 @@ void RS_Hatch::update() {
     hatch->setFlag(RS2::FlagTemp);
 
     //calculateBorders();
+    if (trimmed) {
+        // the pieces are inside the contour already, the hatch takes them over
+        tmp2.setOwner(false);
+    }
 	for(auto e: tmp2){
 
+        if (trimmed) {
+            e->setPen(hatch_pen);
+            e->setLayer(hatch_layer);
+            e->reparent(hatch);
+            hatch->addEntity(e);
+            continue;
+        }
+
         RS_Vector middlePoint;
         RS_Vector middlePoint2;
         if (e->rtti()==RS2::EntityLine) {
@@ -526,7 +545,19 @@ void RS_Hatch::update() {
 
     updateRunning = false;
 
-    RS_DEBUG->print(RS_Debug::D_DEBUGGING, "RS_Hatch::update: OK");
+    RS_DEBUG_PRINT("RS_Hatch::update: OK");
+}
+
+
+
+bool RS_Hatch::scanlineEnabled = true;
+
+void RS_Hatch::setScanlineEnabled(bool enable) {
+    scanlineEnabled = enable;
+}
+
+bool RS_Hatch::isScanlineEnabled() {
+    return scanlineEnabled;
 }
 
 
@@ -140,6 +140,14 @@ public:
         }
         void activateContour(bool on);
 
+        /**
+         * Enables / disables trimming line patterns with LC_HatchScanline
+         * instead of cutting the pattern carpet at every contour edge.
+         * By default this is turned on.
+         */
+        static void setScanlineEnabled(bool enable);
+        static bool isScanlineEnabled();
+
 		void draw(RS_Painter* painter, RS_GraphicView* view,
 						  double& patternOffset) override;
 
@@ -170,6 +178,9 @@ protected:
         bool updateRunning;
         bool needOptimization;
         int  updateError;
+
+private:
+        static bool scanlineEnabled;
 };
 
 #endif
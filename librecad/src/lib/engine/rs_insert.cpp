@@ -26,16 +26,22 @@
 
 #include<iostream>
 #include<cmath>
+#include <algorithm>
+#include <QBrush>
+#include <QTransform>
 #include "rs_insert.h"
 
 #include "rs_arc.h"
 #include "rs_circle.h"
 #include "rs_ellipse.h"
 #include "rs_block.h"
+#include "rs_fontchar.h"
 #include "rs_graphic.h"
 #include "rs_layer.h"
 #include "rs_math.h"
 #include "rs_debug.h"
+#include "rs_graphicview.h"
+#include "rs_painter.h"
 
 RS_InsertData::RS_InsertData(const QString& _name,
 							 RS_Vector _insertionPoint,
@@ -86,14 +92,41 @@ RS_Entity* RS_Insert::clone() const{
 }
 
 
+bool RS_Insert::sharedGeometryEnabled = true;
+
+void RS_Insert::setSharedGeometryEnabled(bool enable) {
+    sharedGeometryEnabled = enable;
+}
+
+bool RS_Insert::isSharedGeometryEnabled() {
+    return sharedGeometryEnabled;
+}
+
+/**
+ * Inserts of blocks and font letters share the geometry of the block.
+ * Previews keep their own entities.
+ */
+bool RS_Insert::usesSharedGeometry() const {
+    return sharedGeometryEnabled && data.updateMode != RS2::PreviewUpdate;
+}
+
+bool RS_Insert::isScaleValid() const {
+    return fabs(data.scaleFactor.x)>1.0e-6 && fabs(data.scaleFactor.y)>1.0e-6;
+}
+
+
 /**
  * Updates the entity buffer of this insert entity. This method
  * needs to be called whenever the block this insert is based on changes.
  */
 void RS_Insert::update() {
+    update(true);
+}
+
+void RS_Insert::update(bool updateBlockInserts) {
 
-        RS_DEBUG->print("RS_Insert::update");
-        RS_DEBUG->print("RS_Insert::update: name: %s", data.name.toLatin1().data());
+        RS_DEBUG_PRINT("RS_Insert::update");
+        RS_DEBUG_PRINT("RS_Insert::update: name: %s", data.name.toLatin1().data());
 //        RS_DEBUG->print("RS_Insert::update: insertionPoint: %f/%f",
 //                data.insertionPoint.x, data.insertionPoint.y);
 
@@ -106,30 +139,53 @@ void RS_Insert::update() {
     RS_Block* blk = getBlockForInsert();
 	if (!blk) {
 		//return nullptr;
-				RS_DEBUG->print("RS_Insert::update: Block is nullptr");
+				RS_DEBUG_PRINT("RS_Insert::update: Block is nullptr");
         return;
     }
 
     if (isUndone()) {
-                RS_DEBUG->print("RS_Insert::update: Insert is in undo list");
+                RS_DEBUG_PRINT("RS_Insert::update: Insert is in undo list");
         return;
     }
 
-        if (fabs(data.scaleFactor.x)<1.0e-6 || fabs(data.scaleFactor.y)<1.0e-6) {
-                RS_DEBUG->print("RS_Insert::update: scale factor is 0");
+        if (!isScaleValid()) {
+                RS_DEBUG_PRINT("RS_Insert::update: scale factor is 0");
                 return;
         }
 
-    RS_Pen tmpPen;
+    if (usesSharedGeometry()) {
+        // the borders of the block include its sub-inserts
+        if (updateBlockInserts) {
+            bool subInsertsChanged = false;
+            for (auto e: *blk) {
+                if (e->rtti()==RS2::EntityInsert) {
+                    const RS_Vector vMin = e->getMin();
+                    const RS_Vector vMax = e->getMax();
+                    static_cast<RS_Insert*>(e)->update();
+                    subInsertsChanged = subInsertsChanged
+                            || vMin != e->getMin() || vMax != e->getMax();
+                }
+            }
+            if (subInsertsChanged) {
+                blk->calculateBorders();
+            }
+        }
+
+        // the entities are created on demand only
+        entitiesPending = true;
+        calculateBorders();
+        RS_DEBUG_PRINT("RS_Insert::update: OK (shared geometry)");
+        return;
+    }
 
         /*QListIterator<RS_Entity> it = createIterator();
     RS_Entity* e;
 	while ( (e = it.current())  ) {
         ++it;*/
 
-        RS_DEBUG->print("RS_Insert::update: cols: %d, rows: %d",
+        RS_DEBUG_PRINT("RS_Insert::update: cols: %d, rows: %d",
                 data.cols, data.rows);
-        RS_DEBUG->print("RS_Insert::update: block has %d entities",
+        RS_DEBUG_PRINT("RS_Insert::update: block has %d entities",
                 blk->count());
 //int i_en_counts=0;
 		for(auto e: *blk){
@@ -139,13 +195,58 @@ void RS_Insert::update() {
 //                i_en_counts++;
 //                RS_DEBUG->print("RS_Insert::update: row %d", r);
 
-                if (e->rtti()==RS2::EntityInsert &&
+                if (e->rtti()==RS2::EntityInsert && updateBlockInserts &&
                     data.updateMode!=RS2::PreviewUpdate) {
 
 //                                        RS_DEBUG->print("RS_Insert::update: updating sub-insert");
 					static_cast<RS_Insert*>(e)->update();
                 }
 
+                RS_Entity* ne = createEntity(e, blk, c, r);
+                ne->initId();
+
+//                                RS_DEBUG->print("RS_Insert::update: adding new entity");
+                appendEntity(ne);
+//                std::cout<<"done # of entity: "<<i_en_counts<<std::endl;
+            }
+        }
+    }
+    calculateBorders();
+
+        RS_DEBUG_PRINT("RS_Insert::update: OK");
+}
+
+
+
+/**
+ * Creates the transformed copies of the block entities of an insert
+ * with shared geometry, once they are accessed. They are deleted again
+ * by the next update().
+ */
+void RS_Insert::createEntities() const {
+    RS_Block* blk = getBlockForInsert();
+    if (!blk) {
+        return;
+    }
+    RS_DEBUG_PRINT("RS_Insert::createEntities: name: %s", data.name.toLatin1().data());
+
+    // the entities are a cache of the block geometry
+    RS_Insert* self = const_cast<RS_Insert*>(this);
+    for (auto e: *blk) {
+        for (int c=0; c<data.cols; ++c) {
+            for (int r=0; r<data.rows; ++r) {
+                RS_Entity* ne = self->createEntity(e, blk, c, r);
+                ne->initId();
+                self->appendEntity(ne);
+            }
+        }
+    }
+    self->RS_EntityContainer::calculateBorders();
+}
+
+
+
+RS_Entity* RS_Insert::createEntity(RS_Entity* e, RS_Block* blk, int c, int r) {
 //                                RS_DEBUG->print("RS_Insert::update: cloning entity");
 
                 RS_Entity* ne;
@@ -170,7 +271,6 @@ void RS_Insert::update() {
                         ne = e->clone();
                 } else
                     ne = e->clone();
-                ne->initId();
                 ne->setUpdateEnabled(false);
                 // if entity layer are 0 set to insert layer to allow "1 layer control" bug ID #3602152
                 RS_Layer *l= ne->getLayer();//special fontchar block don't have
@@ -205,7 +305,7 @@ void RS_Insert::update() {
                 ne->setSelected(isSelected());
 
                 // individual entities can be on indiv. layers
-                tmpPen = ne->getPen(false);
+                RS_Pen tmpPen = ne->getPen(false);
 
                 // color from block (free floating):
                 if (tmpPen.getColor()==RS_Color(RS2::FlagByBlock)) {
@@ -237,15 +337,307 @@ void RS_Insert::update() {
                     ne->update();
                 }
 
-//                                RS_DEBUG->print("RS_Insert::update: adding new entity");
-                appendEntity(ne);
-//                std::cout<<"done # of entity: "<<i_en_counts<<std::endl;
+                return ne;
+}
+
+
+
+/**
+ * Same transformation as applied to the entities by createEntity().
+ */
+RS_Vector RS_Insert::transformed(const RS_Vector& coord, RS_Block* blk, int c, int r) const {
+    RS_Vector ret = coord + data.insertionPoint - blk->getBasePoint()
+            + RS_Vector(data.spacing.x/data.scaleFactor.x*c,
+                        data.spacing.y/data.scaleFactor.y*r);
+    ret.scale(data.insertionPoint, data.scaleFactor);
+    ret.rotate(data.insertionPoint, data.angle);
+    return ret;
+}
+
+
+
+RS_Vector RS_Insert::untransformed(const RS_Vector& coord, RS_Block* blk, int c, int r) const {
+    RS_Vector ret = coord;
+    ret.rotate(data.insertionPoint, -data.angle);
+    ret.scale(data.insertionPoint, RS_Vector(1./data.scaleFactor.x, 1./data.scaleFactor.y));
+    return ret - data.insertionPoint + blk->getBasePoint()
+            - RS_Vector(data.spacing.x/data.scaleFactor.x*c,
+                        data.spacing.y/data.scaleFactor.y*r);
+}
+
+
+
+/**
+ * The block entities can be queried instead of the entities of this
+ * insert while those weren't created and the insert keeps the shapes
+ * of the block, i.e. scales uniformly.
+ */
+bool RS_Insert::isQueriedInBlock() const {
+    return entitiesPending && getBlockForInsert() && isScaleValid()
+            && fabs(fabs(data.scaleFactor.x) - fabs(data.scaleFactor.y)) < RS_TOLERANCE;
+}
+
+
+
+RS_Vector RS_Insert::getNearestInBlock(const RS_Vector& coord, double* dist,
+                                       const std::function<RS_Vector(RS_Block*, const RS_Vector&)>& query) const {
+    RS_Block* blk = getBlockForInsert();
+    double minDist = RS_MAXDOUBLE;
+    RS_Vector closestPoint(false);
+    for (int c=0; c<data.cols; ++c) {
+        for (int r=0; r<data.rows; ++r) {
+            RS_Vector point = query(blk, untransformed(coord, blk, c, r));
+            if (!point.valid) {
+                continue;
+            }
+            point = transformed(point, blk, c, r);
+            const double curDist = point.distanceTo(coord);
+            if (curDist < minDist) {
+                closestPoint = point;
+                minDist = curDist;
             }
         }
     }
-    calculateBorders();
+    if (dist) {
+        *dist = minDist;
+    }
+    return closestPoint;
+}
+
+
+
+RS_Vector RS_Insert::getNearestEndpoint(const RS_Vector& coord, double* dist) const {
+    if (!isQueriedInBlock()) {
+        return RS_EntityContainer::getNearestEndpoint(coord, dist);
+    }
+    return getNearestInBlock(coord, dist, [](RS_Block* blk, const RS_Vector& v) {
+        return blk->getNearestEndpoint(v);
+    });
+}
+
+
+
+/**
+ * The block entities aren't handed out, the entities of this insert are
+ * created if the nearest entity is requested.
+ */
+RS_Vector RS_Insert::getNearestPointOnEntity(const RS_Vector& coord, bool onEntity,
+                                             double* dist, RS_Entity** entity) const {
+    if (entity || !isQueriedInBlock()) {
+        return RS_EntityContainer::getNearestPointOnEntity(coord, onEntity, dist, entity);
+    }
+    return getNearestInBlock(coord, dist, [onEntity](RS_Block* blk, const RS_Vector& v) {
+        return blk->getNearestPointOnEntity(v, onEntity);
+    });
+}
+
+
+
+RS_Vector RS_Insert::getNearestCenter(const RS_Vector& coord, double* dist) const {
+    if (!isQueriedInBlock()) {
+        return RS_EntityContainer::getNearestCenter(coord, dist);
+    }
+    return getNearestInBlock(coord, dist, [](RS_Block* blk, const RS_Vector& v) {
+        return blk->getNearestCenter(v);
+    });
+}
+
+
+
+RS_Vector RS_Insert::getNearestMiddle(const RS_Vector& coord, double* dist,
+                                      int middlePoints) const {
+    if (!isQueriedInBlock()) {
+        return RS_EntityContainer::getNearestMiddle(coord, dist, middlePoints);
+    }
+    return getNearestInBlock(coord, dist, [middlePoints](RS_Block* blk, const RS_Vector& v) {
+        return blk->getNearestMiddle(v, nullptr, middlePoints);
+    });
+}
+
+
+
+RS_Vector RS_Insert::getNearestDist(double distance, const RS_Vector& coord,
+                                    double* dist) const {
+    if (!isQueriedInBlock()) {
+        return RS_EntityContainer::getNearestDist(distance, coord, dist);
+    }
+    const double blockDistance = distance / fabs(data.scaleFactor.x);
+    return getNearestInBlock(coord, dist, [blockDistance](RS_Block* blk, const RS_Vector& v) {
+        return blk->getNearestDist(blockDistance, v);
+    });
+}
+
+
+
+/**
+ * The entities of an insert are selected along with the insert, so they
+ * have no selected references of their own.
+ */
+RS_Vector RS_Insert::getNearestSelectedRef(const RS_Vector& coord, double* dist) const {
+    if (!entitiesPending) {
+        return RS_EntityContainer::getNearestSelectedRef(coord, dist);
+    }
+    return RS_Vector(false);
+}
 
-        RS_DEBUG->print("RS_Insert::update: OK");
+
+
+/**
+ * Without resolving, the insert itself is the entity closest to coord,
+ * its entities are created only if they are resolved.
+ */
+double RS_Insert::getDistanceToPoint(const RS_Vector& coord, RS_Entity** entity,
+                                     RS2::ResolveLevel level, double solidDist) const {
+    if (level != RS2::ResolveNone || !isQueriedInBlock()) {
+        return RS_EntityContainer::getDistanceToPoint(coord, entity, level, solidDist);
+    }
+
+    RS_Block* blk = getBlockForInsert();
+    const double factor = fabs(data.scaleFactor.x);
+    const double blockSolidDist = solidDist < RS_MAXDOUBLE ? solidDist / factor : RS_MAXDOUBLE;
+    double minDist = RS_MAXDOUBLE;
+    for (int c=0; c<data.cols; ++c) {
+        for (int r=0; r<data.rows; ++r) {
+            const double curDist = blk->getDistanceToPoint(untransformed(coord, blk, c, r),
+                                                           nullptr, RS2::ResolveNone,
+                                                           blockSolidDist);
+            if (curDist < RS_MAXDOUBLE) {
+                minDist = std::min(minDist, curDist * factor);
+            }
+        }
+    }
+    if (entity) {
+        *entity = const_cast<RS_Insert*>(this);
+    }
+    return minDist;
+}
+
+
+
+unsigned RS_Insert::count() const {
+    if (!entitiesPending) {
+        return RS_EntityContainer::count();
+    }
+    RS_Block* blk = getBlockForInsert();
+    return blk ? blk->count() * data.cols * data.rows : 0;
+}
+
+
+
+unsigned RS_Insert::countDeep() const {
+    if (!entitiesPending) {
+        return RS_EntityContainer::countDeep();
+    }
+    RS_Block* blk = getBlockForInsert();
+    return blk ? blk->countDeep() * data.cols * data.rows : 0;
+}
+
+
+
+/**
+ * The entities of an insert are selected along with the insert.
+ */
+unsigned RS_Insert::countSelected(bool deep, std::initializer_list<RS2::EntityType> const& types) {
+    if (entitiesPending && !isSelected()) {
+        return 0;
+    }
+    return RS_EntityContainer::countSelected(deep, types);
+}
+
+
+
+/**
+ * Recalculates the borders. Inserts with shared geometry use the
+ * transformed bounding box of the block instead of their entities.
+ */
+void RS_Insert::calculateBorders() {
+    if (!entitiesPending) {
+        RS_EntityContainer::calculateBorders();
+        return;
+    }
+
+    resetBorders();
+    RS_Block* blk = getBlockForInsert();
+    if (!blk || !isScaleValid()) {
+        return;
+    }
+    const RS_Vector bMin = blk->getMin();
+    const RS_Vector bMax = blk->getMax();
+    if (!(bMin.valid && bMax.valid) || bMin.x > bMax.x || bMin.y > bMax.y) {
+        return;
+    }
+    // the corners of the block borders for the outermost array cells
+    for (int c: {0, data.cols-1}) {
+        for (int r: {0, data.rows-1}) {
+            for (const RS_Vector& corner: {bMin, RS_Vector(bMin.x, bMax.y), bMax, RS_Vector(bMax.x, bMin.y)}) {
+                const RS_Vector v = transformed(corner, blk, c, r);
+                minV = RS_Vector::minimum(minV, v);
+                maxV = RS_Vector::maximum(maxV, v);
+            }
+        }
+    }
+}
+
+
+
+/**
+ * Draws the insert. Inserts with shared geometry draw the entities
+ * of the block under the transformation of the insert, without
+ * creating copies. Letters are drawn from the cached outline of the letter.
+ */
+void RS_Insert::draw(RS_Painter* painter, RS_GraphicView* view, double& patternOffset) {
+    if (!entitiesPending) {
+        RS_EntityContainer::draw(painter, view, patternOffset);
+        return;
+    }
+    if (!(painter && view)) {
+        return;
+    }
+    RS_Block* blk = getBlockForInsert();
+    if (!blk) {
+        return;
+    }
+
+    // letters with a line pattern are drawn entity by entity, to keep the
+    // pattern of each entity
+    const bool solid = painter->getPen().getLineType() == RS2::SolidLine
+            || view->getDrawingMode() == RS2::ModePreview;
+    if (blk->rtti() == RS2::EntityFontChar && data.cols == 1 && data.rows == 1 && solid) {
+        // the letter is drawn as a whole, the pen is already set for this insert
+        if (view->isDrawnSelected(this) != painter->shouldDrawSelected()) {
+            return;
+        }
+        const RS_Vector origin = view->toGui(transformed(RS_Vector(0., 0.), blk, 0, 0));
+        const RS_Vector ex = view->toGui(transformed(RS_Vector(1., 0.), blk, 0, 0)) - origin;
+        const RS_Vector ey = view->toGui(transformed(RS_Vector(0., 1.), blk, 0, 0)) - origin;
+        const QTransform toGui(ex.x, ex.y, ey.x, ey.y, origin.x, origin.y);
+
+        const QBrush brush = painter->brush();
+        painter->setBrush(QBrush());
+        painter->drawPath(toGui.map(static_cast<RS_FontChar*>(blk)->getPath()));
+        painter->setBrush(brush);
+        return;
+    }
+
+    // the block entities are drawn as they are, the painter maps them
+    // to each array cell of the insert
+    const RS_Vector origin = view->toGui(RS_Vector(0., 0.));
+    const RS_Vector ex = view->toGui(RS_Vector(1., 0.)) - origin;
+    const RS_Vector ey = view->toGui(RS_Vector(0., 1.)) - origin;
+    const QTransform fromGui = QTransform(ex.x, ex.y, ey.x, ey.y, origin.x, origin.y).inverted();
+    for (int c=0; c<data.cols; ++c) {
+        for (int r=0; r<data.rows; ++r) {
+            const RS_Vector o = view->toGui(transformed(RS_Vector(0., 0.), blk, c, r));
+            const RS_Vector tx = view->toGui(transformed(RS_Vector(1., 0.), blk, c, r)) - o;
+            const RS_Vector ty = view->toGui(transformed(RS_Vector(0., 1.), blk, c, r)) - o;
+            view->beginInsert(painter, this, blk,
+                              fromGui * QTransform(tx.x, tx.y, ty.x, ty.y, o.x, o.y));
+            for (auto e: *blk) {
+                view->drawEntity(painter, e);
+            }
+            view->endInsert(painter);
+        }
+    }
 }
 
 
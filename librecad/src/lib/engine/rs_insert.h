@@ -87,6 +87,12 @@ std::ostream& operator << (std::ostream& os, const RS_InsertData& d);
  * refer to a block. However, to the outside world they act exactly
  * like EntityContainer.
  *
+ * With shared geometry (the default) an insert of a drawing block only
+ * keeps its transformation and a bounding box. It draws the entities of
+ * the block transformed on the fly and creates its own transformed
+ * copies only when they are accessed otherwise, e.g. for snapping or
+ * exploding.
+ *
  * @author Andrew Mustun
  */
 class RS_Insert : public RS_EntityContainer {
@@ -116,8 +122,31 @@ public:
     }
 
 	RS_Block* getBlockForInsert() const;
+	/**
+	 * Sets the block of this insert if it is known already, e.g. a
+	 * letter found in its font, so it isn't looked up by name.
+	 */
+	void setBlockForInsert(RS_Block* blk) {
+		block = blk;
+	}
 
     virtual void update();
+	/**
+	 * Updates this insert like update(). The inserts of the block are
+	 * left alone if updateBlockInserts is false, because they are known
+	 * to be up to date already.
+	 */
+	void update(bool updateBlockInserts);
+	void calculateBorders() override;
+
+	void draw(RS_Painter* painter, RS_GraphicView* view, double& patternOffset) override;
+
+	/**
+	 * Enables / disables shared geometry for inserts updated afterwards.
+	 * By default this is turned on.
+	 */
+	static void setSharedGeometryEnabled(bool enable);
+	static bool isSharedGeometryEnabled();
 
     QString getName() const {
         return data.name;
@@ -180,6 +209,36 @@ public:
     virtual RS_Vector getNearestRef(const RS_Vector& coord,
 									 double* dist = nullptr) const;
 
+	/*
+	 * Inserts with shared geometry answer these queries from the block
+	 * as long as their entities weren't created yet.
+	 */
+	using RS_EntityContainer::getNearestEndpoint;
+	RS_Vector getNearestEndpoint(const RS_Vector& coord,
+								 double* dist = nullptr) const override;
+	RS_Vector getNearestPointOnEntity(const RS_Vector& coord,
+									  bool onEntity = true,
+									  double* dist = nullptr,
+									  RS_Entity** entity = nullptr) const override;
+	RS_Vector getNearestCenter(const RS_Vector& coord,
+							   double* dist = nullptr) const override;
+	RS_Vector getNearestMiddle(const RS_Vector& coord,
+							   double* dist = nullptr,
+							   int middlePoints = 1) const override;
+	RS_Vector getNearestDist(double distance,
+							 const RS_Vector& coord,
+							 double* dist = nullptr) const override;
+	RS_Vector getNearestSelectedRef(const RS_Vector& coord,
+									double* dist = nullptr) const override;
+	double getDistanceToPoint(const RS_Vector& coord,
+							  RS_Entity** entity,
+							  RS2::ResolveLevel level = RS2::ResolveNone,
+							  double solidDist = RS_MAXDOUBLE) const override;
+
+	unsigned count() const override;
+	unsigned countDeep() const override;
+	unsigned countSelected(bool deep = true, std::initializer_list<RS2::EntityType> const& types = {}) override;
+
     virtual void move(const RS_Vector& offset);
     virtual void rotate(const RS_Vector& center, const double& angle);
     virtual void rotate(const RS_Vector& center, const RS_Vector& angleVector);
@@ -189,8 +248,26 @@ public:
     friend std::ostream& operator << (std::ostream& os, const RS_Insert& i);
 
 protected:
+	void createEntities() const override;
+
     RS_InsertData data;
 	mutable RS_Block* block;
+
+private:
+	bool usesSharedGeometry() const;
+	/** @return transformed copy of the block entity e for array cell c, r */
+	RS_Entity* createEntity(RS_Entity* e, RS_Block* blk, int c, int r);
+	/** @return coord of the block transformed for array cell c, r */
+	RS_Vector transformed(const RS_Vector& coord, RS_Block* blk, int c, int r) const;
+	/** @return coord of the insert mapped back to the block for array cell c, r */
+	RS_Vector untransformed(const RS_Vector& coord, RS_Block* blk, int c, int r) const;
+	bool isQueriedInBlock() const;
+	/** @return nearest point found by query in the block for any array cell */
+	RS_Vector getNearestInBlock(const RS_Vector& coord, double* dist,
+								const std::function<RS_Vector(RS_Block*, const RS_Vector&)>& query) const;
+	bool isScaleValid() const;
+
+	static bool sharedGeometryEnabled;
 };
 
 
@@ -46,6 +46,7 @@ RS_LayerList::RS_LayerList() {
  */
 void RS_LayerList::clear() {
     layers.clear();
+    layerIndex.clear();
 	setModified(true);
 }
 
@@ -154,6 +155,7 @@ void RS_LayerList::add(RS_Layer* layer) {
     RS_Layer* l = find(layer->getName());
     if (l==NULL) {
         layers.append(layer);
+        layerIndex.insert(layer->getName(), layer);
         this->sort();
         // notify listeners
         for (int i=0; i<layerListListeners.size(); ++i) {
@@ -200,6 +202,12 @@ void RS_LayerList::remove(RS_Layer* layer) {
 
     // here the layer is removed from the list but not deleted
     layers.removeOne(layer);
+    auto it = layerIndex.find(layer->getName());
+    if (it != layerIndex.end() && it.value() == layer) {
+        layerIndex.erase(it);
+    } else {
+        reindex();
+    }
 
     for (int i=0; i<layerListListeners.size(); ++i) {
         RS_LayerListListener* l = layerListListeners.at(i);
@@ -229,7 +237,17 @@ void RS_LayerList::edit(RS_Layer* layer, const RS_Layer& source) {
         return;
     }
 
+    QString const oldName = layer->getName();
     *layer = source;
+    if (layer->getName() != oldName) {
+        auto it = layerIndex.find(oldName);
+        if (it != layerIndex.end() && it.value() == layer) {
+            layerIndex.erase(it);
+            layerIndex.insert(layer->getName(), layer);
+        } else {
+            reindex();
+        }
+    }
 
     for (int i=0; i<layerListListeners.size(); ++i) {
         RS_LayerListListener* l = layerListListeners.at(i);
@@ -249,15 +267,7 @@ void RS_LayerList::edit(RS_Layer* layer, const RS_Layer& source) {
 RS_Layer* RS_LayerList::find(const QString& name) {
     //RS_DEBUG->print("RS_LayerList::find begin");
 
-    RS_Layer* ret = NULL;
-
-    for (int i=0; i<layers.size(); ++i) {
-        RS_Layer* l = layers.at(i);
-        if (l->getName()==name) {
-            ret = l;
-            break;
-        }
-    }
+    RS_Layer* ret = layerIndex.value(name, NULL);
 
     //RS_DEBUG->print("RS_LayerList::find end");
 
@@ -267,26 +277,27 @@ RS_Layer* RS_LayerList::find(const QString& name) {
 
 
 /**
- * @return Index of the given layer in the layer list or -1 if the layer
- * was not found.
+ * Rebuilds the name index of the layers.
  */
-int RS_LayerList::getIndex(const QString& name) {
-    //RS_DEBUG->print("RS_LayerList::find begin");
-
-    int ret = -1;
-
-    for (int i=0; i<layers.size(); i++) {
-        RS_Layer* l = layers.at(i);
-
-        if (l->getName()==name) {
-            ret = i;
-            break;
+void RS_LayerList::reindex() {
+    layerIndex.clear();
+    layerIndex.reserve(layers.size());
+    for (RS_Layer* l: layers) {
+        if (!layerIndex.contains(l->getName())) {
+            layerIndex.insert(l->getName(), l);
         }
     }
+}
 
-    //RS_DEBUG->print("RS_LayerList::find end");
 
-    return ret;
+
+/**
+ * @return Index of the given layer in the layer list or -1 if the layer
+ * was not found.
+ */
+int RS_LayerList::getIndex(const QString& name) {
+    RS_Layer* l = find(name);
+    return l ? layers.indexOf(l) : -1;
 }
 
 
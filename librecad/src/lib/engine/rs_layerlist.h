@@ -30,6 +30,8 @@
 #define RS_LAYERLIST_H
 
 #include <QList>
+#include <QHash>
+#include <QString>
 #include "rs_layer.h"
 
 class RS_LayerListListener;
@@ -129,6 +131,8 @@ public:
 private:
     //! layers in the graphic
     QList<RS_Layer*> layers;
+    //! layers by name, maintained by add(), remove(), edit() and clear()
+    QHash<QString, RS_Layer*> layerIndex;
     //! List of registered LayerListListeners
     QList<RS_LayerListListener*> layerListListeners;
     QG_LayerWidget* layerWidget;
@@ -136,6 +140,8 @@ private:
     RS_Layer* activeLayer;
     /** Flag set if the layer list was modified and not yet saved. */
     bool modified;
+
+    void reindex();
 };
 
 #endif
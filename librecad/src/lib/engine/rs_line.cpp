@@ -692,12 +692,12 @@ void RS_Line::draw(RS_Painter* painter, RS_GraphicView* view, double& patternOff
 		direction=pEnd-pStart;
     }
 
-    bool drawAsSelected = isSelected() && !(view->isPrinting() || view->isPrintPreview());
+    bool drawAsSelected = view->isDrawnSelected(this) && !(view->isPrinting() || view->isPrintPreview());
 
     double  length=direction.magnitude();
     patternOffset -= length;
     if (( !drawAsSelected && (
-              getPen().getLineType()==RS2::SolidLine ||
+              view->getDrawnPen(this).getLineType()==RS2::SolidLine ||
               view->getDrawingMode()==RS2::ModePreview)) ) {
         //if length is too small, attempt to draw the line, could be a potential bug
         painter->drawLine(pStart,pEnd);
@@ -713,7 +713,7 @@ void RS_Line::draw(RS_Painter* painter, RS_GraphicView* view, double& patternOff
         pat = &RS_LineTypePattern::patternSelected;
 
     } else {
-        pat = view->getPattern(getPen().getLineType());
+        pat = view->getPattern(view->getDrawnPen(this).getLineType());
     }
 	if (!pat) {
 //        patternOffset -= length;
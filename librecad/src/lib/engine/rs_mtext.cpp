@@ -420,10 +420,12 @@ void RS_MText::update()
         default: {
             // One Letter:
             QString letterText {QString(data.text.at(i))};
-            if (nullptr == font->findLetter( letterText)) {
+            RS_Block* letterBlock {font->findLetter( letterText)};
+            if (nullptr == letterBlock) {
                 RS_DEBUG->print("RS_MText::update: missing font for letter( %s ), replaced it with QChar(0xfffd)",
                                 qPrintable( letterText));
                 letterText = QChar( 0xfffd);
+                letterBlock = font->findLetter( letterText);
             }
 
             RS_DEBUG->print("RS_MText::update: insert a letter at pos: %f/%f", letterPos.x, letterPos.y);
@@ -439,6 +441,7 @@ void RS_MText::update()
                              RS2::NoUpdate);
 
             RS_Insert* letter {new RS_Insert(this, d)};
+            letter->setBlockForInsert( letterBlock);
             RS_Vector letterWidth;
             letter->setPen( RS_Pen( RS2::FlagInvalid));
             letter->setLayer( nullptr);
@@ -26,6 +26,7 @@
 
 #include<iostream>
 #include<QString>
+#include<QMutex>
 #include "rs_patternlist.h"
 
 #include "rs_system.h"
@@ -69,18 +70,21 @@ void RS_PatternList::init() {
  * memory if it's not already.
  */
 RS_Pattern* RS_PatternList::requestPattern(const QString& name) {
-    RS_DEBUG->print("RS_PatternList::requestPattern %s", name.toLatin1().data());
+    RS_DEBUG_PRINT("RS_PatternList::requestPattern %s", name.toLatin1().data());
 
     QString name2 = name.toLower();
 
-	RS_DEBUG->print("name2: %s", name2.toLatin1().data());
+	RS_DEBUG_PRINT("name2: %s", name2.toLatin1().data());
 	if (patterns.count(name2)) {
+		// patterns are loaded on demand, also by the regeneration threads
+		static QMutex loadMutex;
+		QMutexLocker locker(&loadMutex);
 		if (!patterns[name2]) {
 			RS_Pattern* p = new RS_Pattern(name2);
 			p->loadPattern();
 			patterns[name2].reset(p);
 		}
-		RS_DEBUG->print("name2: %s, size= %d", name2.toLatin1().data(),
+		RS_DEBUG_PRINT("name2: %s, size= %d", name2.toLatin1().data(),
 						patterns[name2]->countDeep());
 		return patterns[name2].get();
 	}
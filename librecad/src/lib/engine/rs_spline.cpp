@@ -27,6 +27,8 @@
 #include<iostream>
 #include<cmath>
 #include<numeric>
+#include<algorithm>
+#include <QPainterPath>
 
 #include "rs_spline.h"
 
@@ -74,6 +76,7 @@ RS_Spline::RS_Spline(RS_EntityContainer* parent,
 
 RS_Entity* RS_Spline::clone() const{
     RS_Spline* l = new RS_Spline(*this);
+    l->segmentLines.clear();
     l->setOwner(isOwner());
     l->initId();
     l->detach();
@@ -83,17 +86,11 @@ RS_Entity* RS_Spline::clone() const{
 
 
 void RS_Spline::calculateBorders() {
-    /*minV = RS_Vector::minimum(data.startpoint, data.endpoint);
-    maxV = RS_Vector::maximum(data.startpoint, data.endpoint);
-
-    QList<RS_Vector>::iterator it;
-    for (it = data.controlPoints.begin();
-    it!=data.controlPoints.end(); ++it) {
-
-    minV = RS_Vector::minimum(*it, minV);
-    maxV = RS_Vector::maximum(*it, maxV);
-}
-    */
+    resetBorders();
+	for (auto const& vp: points) {
+		minV = RS_Vector::minimum(vp, minV);
+		maxV = RS_Vector::maximum(vp, maxV);
+	}
 }
 
 
@@ -152,12 +149,17 @@ RS_Vector RS_Spline::getNearestSelectedRef( const RS_Vector& coord,
 /**
  * Updates the internal polygon of this spline. Called when the
  * spline or it's data, position, .. changes.
+ * The lines of the polygon are created by createEntities() once they
+ * are accessed, drawing and distances use the polygon directly.
  */
 void RS_Spline::update() {
 
     RS_DEBUG->print("RS_Spline::update");
 
     clear();
+    points.clear();
+    drawPoints.clear();
+    segmentLines.clear();
 
     if (isUndone()) {
         return;
@@ -173,8 +175,54 @@ void RS_Spline::update() {
         return;
     }
 
-    resetBorders();
+	const size_t npts = data.controlPoints.size() + (data.closed ? data.degree : 0);
+    // resolution:
+	points = evaluate(getGraphicVariableInt("$SPLINESEGS", 8) * npts);
+	calculateBorders();
+	entitiesPending = points.size() > 1;
+}
+
+/**
+ * Creates the lines of the polygon for the container interface,
+ * e.g. for intersections and explode.
+ */
+void RS_Spline::createEntities() const {
+	RS_Spline* self = const_cast<RS_Spline*>(this);
+	for (size_t i = 1; i < points.size(); ++i) {
+		self->addEntity(createLine(i));
+	}
+	self->calculateBorders();
+}
+
+RS_Line* RS_Spline::createLine(size_t i) const {
+	RS_Line* line = new RS_Line{const_cast<RS_Spline*>(this), points[i - 1], points[i]};
+	line->setLayer(nullptr);
+	line->setPen(RS2::FlagInvalid);
+	if (isSelected()) {
+		line->setSelected(true);
+	}
+	return line;
+}
+
+/**
+ * Only the lines asked for are created while the lines of the polygon
+ * are pending. They are kept until the polygon is updated.
+ */
+RS_Line* RS_Spline::getSegmentLine(size_t i) const {
+	if (!entitiesPending) {
+		return static_cast<RS_Line*>(entities.at(i - 1));
+	}
+	std::shared_ptr<RS_Line>& line = segmentLines[i];
+	if (!line) {
+		line.reset(createLine(i));
+	}
+	return line.get();
+}
 
+/**
+ * @return count points of the spline, evenly distributed over the knots
+ */
+std::vector<RS_Vector> RS_Spline::evaluate(size_t count) const {
 	std::vector<RS_Vector> tControlPoints = data.controlPoints;
 
     if (data.closed) {
@@ -186,39 +234,87 @@ void RS_Spline::update() {
 	const size_t npts = tControlPoints.size();
     // order:
 	const size_t  k = data.degree+1;
-    // resolution:
-	const size_t  p1 = getGraphicVariableInt("$SPLINESEGS", 8) * npts;
 
 	std::vector<double> h(npts+1, 1.);
-	std::vector<RS_Vector> p(p1, {0., 0.});
+	std::vector<RS_Vector> p(count, {0., 0.});
     if (data.closed) {
-		rbsplinu(npts,k,p1,tControlPoints,h,p);
+		rbsplinu(npts,k,count,tControlPoints,h,p);
     } else {
-		rbspline(npts,k,p1,tControlPoints,h,p);
+		rbspline(npts,k,count,tControlPoints,h,p);
     }
+	return p;
+}
 
-	RS_Vector prev{};
-	for (auto const& vp: p) {
-		if (prev.valid) {
-			RS_Line* line = new RS_Line{this, prev, vp};
-			line->setLayer(nullptr);
-			line->setPen(RS2::FlagInvalid);
-			addEntity(line);
+/**
+ * @return the polygon for drawing in view. The deviation from the spline is
+ * kept below half a pixel by the number of segments per knot span, which is
+ * a power of two. So the polygon is only evaluated again on zoom changes
+ * by a factor of four.
+ */
+const std::vector<RS_Vector>& RS_Spline::getDrawPoints(RS_GraphicView* view) const {
+	if (points.size() < 2) {
+		return points;
+	}
+	const size_t npts = data.controlPoints.size() + (data.closed ? data.degree : 0);
+	const size_t k = data.degree + 1;
+	const std::vector<double> x = data.closed ? knotu(npts, k) : knot(npts, k);
+	const double t0 = data.closed ? double(k - 1) : x.front();
+	const double t1 = data.closed ? double(npts) : x.back();
+
+	// knot spans of the evaluated parameter range
+	size_t spans = 0;
+	double minSpan = RS_MAXDOUBLE;
+	for (size_t i = 1; i < x.size(); ++i) {
+		const double span = std::min(x[i], t1) - std::max(x[i - 1], t0);
+		if (span > RS_TOLERANCE) {
+			++spans;
+			minSpan = std::min(minSpan, span);
 		}
-		prev = vp;
-		minV = RS_Vector::minimum(prev, minV);
-		maxV = RS_Vector::maximum(prev, maxV);
 	}
+	if (spans == 0) {
+		return points;
+	}
+
+	// chord error of a segment of parameter length dt is at most |C''| dt^2/8,
+	// |C''| <= degree*(degree-1)*(largest second difference of control points)/minSpan^2
+	double secondDiff = 0.;
+	const std::vector<RS_Vector>& cp = data.controlPoints;
+	const size_t n = cp.size();
+	for (size_t i = data.closed ? 0 : 1; i < (data.closed ? n : n - 1); ++i) {
+		const RS_Vector d = cp[(i + n - 1) % n] - cp[i] * 2. + cp[(i + 1) % n];
+		secondDiff = std::max(secondDiff, d.magnitude());
+	}
+	const double tolerance = 0.5 / std::max(view->getFactor().x, RS_TOLERANCE);
+	const double degree = data.degree;
+	const double perSpan = std::sqrt(degree * (degree - 1.) * secondDiff / (8. * tolerance))
+			* (t1 - t0) / (spans * minSpan);
+
+	size_t segments = 1;
+	while (segments < perSpan && segments * spans < 0x40000) {
+		segments *= 2;
+	}
+	if (drawPoints.empty() || segments != drawSegments) {
+		drawPoints = evaluate(segments * spans + 1);
+		drawSegments = segments;
+	}
+	return drawPoints;
+}
+
+/**
+ * @return The polygon of the spline.
+ */
+const std::vector<RS_Vector>& RS_Spline::getPoints() const {
+	return points;
 }
 
 RS_Vector RS_Spline::getStartpoint() const {
-   if (data.closed) return RS_Vector(false);
-   return static_cast<RS_Line*>(const_cast<RS_Spline*>(this)->firstEntity())->getStartpoint();
+   if (data.closed || points.empty()) return RS_Vector(false);
+   return points.front();
 }
 
 RS_Vector RS_Spline::getEndpoint() const {
-   if (data.closed) return RS_Vector(false);
-   return static_cast<RS_Line*>(const_cast<RS_Spline*>(this)->lastEntity())->getEndpoint();
+   if (data.closed || points.empty()) return RS_Vector(false);
+   return points.back();
 }
 
 
@@ -255,13 +351,60 @@ RS_Vector RS_Spline::getNearestEndpoint(const RS_Vector& coord,
 
 
 
-/*
-// The default implementation of RS_EntityContainer is inaccurate but
-//   has to do for now..
+/**
+ * Splines are ignored for snapping on entities, see
+ * RS_EntityContainer::ignoredSnap(), only the distance is set.
+ */
 RS_Vector RS_Spline::getNearestPointOnEntity(const RS_Vector& coord,
-        bool onEntity, double* dist, RS_Entity** entity) {
+											 bool /*onEntity*/, double* dist, RS_Entity** /*entity*/) const{
+	if (dist) {
+		*dist = getDistanceToPoint(coord);
+	}
+	return RS_Vector(false);
+}
+
+double RS_Spline::getDistanceToPoint(const RS_Vector& coord,
+									 RS_Entity** entity,
+									 RS2::ResolveLevel level,
+									 double solidDist) const{
+	if (!entitiesPending && size_t(entities.size()) + 1 != points.size()) {
+		// the lines were changed
+		return RS_EntityContainer::getDistanceToPoint(coord, entity, level, solidDist);
+	}
+	double minDist = RS_MAXDOUBLE;
+	size_t nearestSegment = 0;
+	for (size_t i = 1; i < points.size(); ++i) {
+		const RS_Vector direction = points[i] - points[i - 1];
+		const double length2 = direction.squared();
+		RS_Vector nearest = points[i - 1];
+		if (length2 > RS_TOLERANCE2) {
+			const double t = RS_Vector::dotP(coord - points[i - 1], direction) / length2;
+			nearest += direction * std::min(1., std::max(0., t));
+		}
+		const double d = nearest.distanceTo(coord);
+		if (d < minDist) {
+			minDist = d;
+			nearestSegment = i;
+		}
+	}
+	if (entity) {
+		if (level == RS2::ResolveAll || level == RS2::ResolveAllButTextImage) {
+			// the nearest line is asked for
+			*entity = nearestSegment > 0 ? getSegmentLine(nearestSegment) : nullptr;
+		} else {
+			*entity = const_cast<RS_Spline*>(this);
+		}
+	}
+	return minDist;
+}
+
+double RS_Spline::getLength() const {
+	double length = 0.;
+	for (size_t i = 1; i < points.size(); ++i) {
+		length += points[i].distanceTo(points[i - 1]);
+	}
+	return length;
 }
-*/
 
 
 
@@ -302,7 +445,20 @@ RS_Vector RS_Spline::getNearestDist(double /*distance*/,
 
 
 void RS_Spline::move(const RS_Vector& offset) {
-    RS_EntityContainer::move(offset);
+	for (RS_Vector& vp: points) {
+		vp.move(offset);
+	}
+	for (RS_Vector& vp: drawPoints) {
+		vp.move(offset);
+	}
+	for (auto& line: segmentLines) {
+		line.second->move(offset);
+	}
+	if (entitiesPending) {
+		moveBorders(offset);
+	} else {
+		RS_EntityContainer::move(offset);
+	}
 	for (RS_Vector& vp: data.controlPoints) {
 		vp.move(offset);
     }
@@ -318,7 +474,20 @@ void RS_Spline::rotate(const RS_Vector& center, const double& angle) {
 
 
 void RS_Spline::rotate(const RS_Vector& center, const RS_Vector& angleVector) {
-	RS_EntityContainer::rotate(center, angleVector);
+	for (RS_Vector& vp: points) {
+		vp.rotate(center, angleVector);
+	}
+	for (RS_Vector& vp: drawPoints) {
+		vp.rotate(center, angleVector);
+	}
+	for (auto& line: segmentLines) {
+		line.second->rotate(center, angleVector);
+	}
+	if (entitiesPending) {
+		calculateBorders();
+	} else {
+		RS_EntityContainer::rotate(center, angleVector);
+	}
 	for (RS_Vector& vp: data.controlPoints) {
 		vp.rotate(center, angleVector);
 	}
@@ -357,33 +526,57 @@ void RS_Spline::moveRef(const RS_Vector& ref, const RS_Vector& offset) {
 
 void RS_Spline::revertDirection() {
 	std::reverse(data.controlPoints.begin(), data.controlPoints.end());
+	std::reverse(points.begin(), points.end());
+	std::reverse(drawPoints.begin(), drawPoints.end());
 }
 
 
 
 
+/**
+ * Draws the polygon of the spline for the zoom factor of the view, see
+ * getDrawPoints(). The pen is already set for this spline.
+ */
 void RS_Spline::draw(RS_Painter* painter, RS_GraphicView* view, double& /*patternOffset*/) {
 
 	if (!(painter && view)) {
         return;
     }
+	if (view->isDrawnSelected(this) != painter->shouldDrawSelected()) {
+		return;
+	}
 
+	const std::vector<RS_Vector>& p = getDrawPoints(view);
+	if (p.size() < 2) {
+		return;
+	}
 
-    RS_Entity* e=firstEntity(RS2::ResolveNone);
-	if (e) {
-        RS_Pen p=this->getPen(true);
-        e->setPen(p);
-        double patternOffset(0.0);
-        view->drawEntity(painter, e, patternOffset);
-        //RS_DEBUG->print("offset: %f\nlength was: %f", offset, e->getLength());
+	const bool drawAsSelected = view->isDrawnSelected(this) && !(view->isPrinting() || view->isPrintPreview());
+	if (!drawAsSelected && (view->getDrawnPen(this).getLineType() == RS2::SolidLine
+							|| view->getDrawingMode() == RS2::ModePreview)) {
+		RS_Vector const start = view->toGui(p.front());
+		QPainterPath path(QPointF(start.x, start.y));
+		for (size_t i = 1; i < p.size(); ++i) {
+			RS_Vector const vp = view->toGui(p[i]);
+			path.lineTo(vp.x, vp.y);
+		}
+		const QBrush brush = painter->brush();
+		painter->setBrush(QBrush());
+		painter->drawPath(path);
+		painter->setBrush(brush);
+		return;
+	}
 
-        e = nextEntity(RS2::ResolveNone);
-		while(e) {
-            view->drawEntityPlain(painter, e, patternOffset);
-            e = nextEntity(RS2::ResolveNone);
-            //RS_DEBUG->print("offset: %f\nlength was: %f", offset, e->getLength());
-        }
-    }
+	// the line pattern continues along the segments
+	RS_Line line{nullptr, p[0], p[1]};
+	line.setPen(getPen(true));
+	line.setSelected(isSelected());
+	double patternOffset(0.0);
+	for (size_t i = 1; i < p.size(); ++i) {
+		line.setStartpoint(p[i - 1]);
+		line.setEndpoint(p[i]);
+		line.draw(painter, view, patternOffset);
+	}
 }
 
 
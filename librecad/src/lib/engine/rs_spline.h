@@ -28,9 +28,13 @@
 #ifndef RS_SPLINE_H
 #define RS_SPLINE_H
 
+#include <map>
+#include <memory>
 #include <vector>
 #include "rs_entitycontainer.h"
 
+class RS_Line;
+
 /**
  * Holds the data that defines a line.
  */
@@ -120,8 +124,15 @@ public:
 
 	RS_Vector getNearestEndpoint(const RS_Vector& coord,
 										 double* dist = nullptr)const override;
-	//RS_Vector getNearestPointOnEntity(const RS_Vector& coord,
-	//        bool onEntity=true, double* dist = nullptr, RS_Entity** entity=nullptr);
+	RS_Vector getNearestPointOnEntity(const RS_Vector& coord,
+									  bool onEntity = true,
+									  double* dist = nullptr,
+									  RS_Entity** entity = nullptr) const override;
+	double getDistanceToPoint(const RS_Vector& coord,
+							  RS_Entity** entity = nullptr,
+							  RS2::ResolveLevel level = RS2::ResolveNone,
+							  double solidDist = RS_MAXDOUBLE) const override;
+	double getLength() const override;
 	RS_Vector getNearestCenter(const RS_Vector& coord,
 									   double* dist = nullptr)const override;
 	RS_Vector getNearestMiddle(const RS_Vector& coord,
@@ -145,12 +156,23 @@ public:
 
 		void draw(RS_Painter* painter, RS_GraphicView* view, double& patternOffset) override;
 		const std::vector<RS_Vector>& getControlPoints() const;
+		/**
+		 * @brief getPoints the polygon of the spline, evaluated with
+		 * $SPLINESEGS segments per control point
+		 */
+		const std::vector<RS_Vector>& getPoints() const;
 
         friend std::ostream& operator << (std::ostream& os, const RS_Spline& l);
 
 		void calculateBorders() override;
 
+protected:
+		void createEntities() const override;
+
 private:
+		std::vector<RS_Vector> evaluate(size_t count) const;
+		const std::vector<RS_Vector>& getDrawPoints(RS_GraphicView* view) const;
+
 		std::vector<double> knot(size_t num, size_t order) const;
 		void rbspline(size_t npts, size_t k, size_t p1,
 		              const std::vector<RS_Vector>& b,
@@ -165,6 +187,23 @@ private:
 
 protected:
 		RS_SplineData data;
+
+private:
+		/** polygon of the spline, the lines are created from it on demand */
+		std::vector<RS_Vector> points;
+		/** polygon for drawing, evaluated for the pixel tolerance of the view */
+		mutable std::vector<RS_Vector> drawPoints;
+		mutable size_t drawSegments = 0;
+		/**
+		 * lines of the polygon handed out by getDistanceToPoint() while
+		 * the lines are not created, by index of their endpoint
+		 */
+		mutable std::map<size_t, std::shared_ptr<RS_Line>> segmentLines;
+
+		/** @return new line of the polygon ending at points[i] */
+		RS_Line* createLine(size_t i) const;
+		/** @return the line of the polygon ending at points[i] */
+		RS_Line* getSegmentLine(size_t i) const;
 }
 ;
 
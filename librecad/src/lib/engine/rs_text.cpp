@@ -289,9 +289,11 @@ void RS_Text::update() {
         } else {
             // One Letter:
             QString letterText = QString(data.text.at(i));
-            if (font->findLetter(letterText) == NULL) {
+            RS_Block* letterBlock = font->findLetter(letterText);
+            if (letterBlock == NULL) {
                 RS_DEBUG->print("RS_Text::update: missing font for letter( %s ), replaced it with QChar(0xfffd)",qPrintable(letterText));
                 letterText = QChar(0xfffd);
+                letterBlock = font->findLetter(letterText);
             }
             RS_DEBUG->print("RS_Text::update: insert a "
                             "letter at pos: %f/%f", letterPos.x, letterPos.y);
@@ -304,6 +306,7 @@ void RS_Text::update() {
                             font->getLetterList(), RS2::NoUpdate);
 
             RS_Insert* letter = new RS_Insert(this, d);
+            letter->setBlockForInsert(letterBlock);
             RS_Vector letterWidth;
             letter->setPen(RS_Pen(RS2::FlagInvalid));
             letter->setLayer(NULL);
@@ -25,12 +25,15 @@
 **
 **********************************************************************/
 
+#include<algorithm>
 #include<iostream>
 #include "qc_applicationwindow.h"
 #include "rs_undocycle.h"
 #include "rs_undo.h"
 #include "rs_debug.h"
 
+int RS_Undo::undoLimit = 0;
+
 /**
  * @return Number of Cycles that can be undone.
  */
@@ -78,12 +81,41 @@ void RS_Undo::addUndoCycle(std::shared_ptr<RS_UndoCycle> const& i) {
 
 //    undoList.insert(++undoPointer, i);
 	undoList.insert(undoList.begin() + (++undoPointer), i);
+	for (RS_Undoable* u: i->getUndoables()) {
+		++references[u];
+	}
+
+	// drop the oldest cycles beyond the limit
+	if (undoLimit > 0 && undoPointer >= undoLimit) {
+		const size_t n = static_cast<size_t>(undoPointer + 1 - undoLimit);
+		removeUndoCycles(0, n);
+		undoPointer -= static_cast<int>(n);
+	}
 
     RS_DEBUG->print("RS_Undo::addUndoCycle: ok");
 }
 
 
 
+void RS_Undo::removeUndoCycles(size_t first, size_t last)
+{
+	for (size_t i = first; i < last; ++i) {
+		for (RS_Undoable* u: undoList[i]->getUndoables()) {
+			auto it = references.find(u);
+			if (it != references.end() && --it->second > 0) {
+				continue;
+			}
+			if (it != references.end()) {
+				references.erase(it);
+			}
+			removeUndoable(u);
+		}
+	}
+	undoList.erase(undoList.begin() + first, undoList.begin() + last);
+}
+
+
+
 /**
  * Starts a new cycle for one undo step. Every undoable that is
  * added after calling this method goes into this cycle.
@@ -99,37 +131,7 @@ void RS_Undo::startUndoCycle()
     // if there are undo cycles behind undoPointer
     // remove obsolete entities and undoCycles
     if (undoList.size() > removePointer) {
-        // collect remaining undoables
-        std::list<RS_Undoable*> keep;
-        for (auto it = undoList.begin(); it != undoList.begin() + removePointer; ++it) {
-            for (auto u: (*it)->getUndoables()){
-                keep.push_back( u);
-            }
-        }
-        keep.unique();
-
-        // collect obsolete undoables
-        std::list<RS_Undoable*> obsolete;
-        for (auto it = undoList.begin() + removePointer; it != undoList.end(); ++it) {
-            for (auto u: (*it)->getUndoables()){
-                obsolete.push_back( u);
-            }
-        }
-        // unique() only works correct on sorted list!
-        obsolete.sort();
-        obsolete.unique();
-
-        // delete obsolete undoables which are not in keep list
-        for (auto it = obsolete.begin(); it != obsolete.end(); ++it) {
-            if (keep.end() == std::find( keep.begin(), keep.end(), *it)) {
-                removeUndoable( *it);
-            }
-        }
-
-        // clean up obsolete undoCycles
-        while (undoList.size() > removePointer) {
-            undoList.pop_back();
-        }
+        removeUndoCycles(removePointer, undoList.size());
     }
 
     // alloc new undoCycle
@@ -141,7 +143,7 @@ void RS_Undo::startUndoCycle()
  * Adds an undoable to the current undo cycle.
  */
 void RS_Undo::addUndoable(RS_Undoable* u) {
-    RS_DEBUG->print("RS_Undo::%s(): begin", __func__);
+    RS_DEBUG_PRINT("RS_Undo::%s(): begin", __func__);
 
     if( nullptr == currentCycle) {
         RS_DEBUG->print( RS_Debug::D_CRITICAL, "RS_Undo::%s(): invalid currentCycle, possibly missing startUndoCycle()", __func__);
@@ -149,7 +151,7 @@ void RS_Undo::addUndoable(RS_Undoable* u) {
     }
 
     currentCycle->addUndoable(u);
-    RS_DEBUG->print("RS_Undo::%s(): end", __func__);
+    RS_DEBUG_PRINT("RS_Undo::%s(): end", __func__);
 }
 
 
@@ -253,6 +255,21 @@ std::shared_ptr<RS_UndoCycle> RS_Undo::getRedoCycle() {
 }
 */
 
+void RS_Undo::setUndoLimit(int cycles)
+{
+	undoLimit = std::max(0, cycles);
+}
+
+int RS_Undo::getUndoLimit()
+{
+	return undoLimit;
+}
+
+bool RS_Undo::isUndoCycleActive() const
+{
+	return refCount > 0;
+}
+
 /**
   * enable/disable redo/undo buttons in main application window
   * Author: Dongxu Li
@@ -30,6 +30,7 @@
 #define RS_UNDO_H
 
 #include <memory>
+#include <unordered_map>
 #include <vector>
 
 class RS_UndoCycle;
@@ -77,9 +78,29 @@ public:
 
     static bool test();
 
+    /**
+     * Sets the maximum number of undo cycles kept by each document, 0 for
+     * no limit. The oldest cycles are dropped when a new cycle exceeds the
+     * limit, undoables only they referenced are removed.
+     */
+    static void setUndoLimit(int cycles);
+    static int getUndoLimit();
+
+protected:
+    /**
+     * @return true between the outermost startUndoCycle() and
+     * endUndoCycle() calls
+     */
+    bool isUndoCycleActive() const;
+
 private:
 
 	void addUndoCycle(std::shared_ptr<RS_UndoCycle> const& i);
+	/**
+	 * Drops the undo cycles [first, last) of the undo list and removes the
+	 * undoables no other cycle refers to.
+	 */
+	void removeUndoCycles(size_t first, size_t last);
     //! List of undo list items. every item is something that can be undone.
 	std::vector<std::shared_ptr<RS_UndoCycle>> undoList;
 
@@ -97,6 +118,11 @@ private:
     std::shared_ptr<RS_UndoCycle> currentCycle {nullptr};
 
     int refCount {0}; ///< reference counter for nested start/end calls
+
+    /** number of cycles in the undo list referring to each undoable */
+    std::unordered_map<RS_Undoable*, int> references;
+
+    static int undoLimit;
 };
 
 
@@ -54,6 +54,7 @@
 #include "rs_graphicview.h"
 #include "rs_dialogfactory.h"
 #include "rs_math.h"
+#include "lc_trace.h"
 
 #ifdef DWGSUPPORT
 #include "libdwgr.h"
@@ -142,6 +143,7 @@ QString RS_FilterDXFRW::lastError() const
  * taken to be stored in a file.
  */
 bool RS_FilterDXFRW::fileImport(RS_Graphic& g, const QString& file, RS2::FormatType type) {
+    LC_TRACE_SCOPE("load", "RS_FilterDXFRW::fileImport");
     RS_DEBUG->print("RS_FilterDXFRW::fileImport");
 
     RS_DEBUG->print("DXFRW Filter: importing file '%s'...", (const char*)QFile::encodeName(file));
@@ -152,6 +154,10 @@ bool RS_FilterDXFRW::fileImport(RS_Graphic& g, const QString& file, RS2::FormatT
     graphic = &g;
     currentContainer = graphic;
 	dummyContainer = new RS_EntityContainer(nullptr, true);
+    layerCache.clear();
+    lineTypeCache.clear();
+    penCache.clear();
+    regeneration.clear();
 
     this->file = file;
     // add some variables that need to be there for DXF drawings:
@@ -169,6 +175,7 @@ bool RS_FilterDXFRW::fileImport(RS_Graphic& g, const QString& file, RS2::FormatT
         RS_DEBUG->print("RS_FilterDXFRW::fileImport: reading DWG file");
         if (RS_DEBUG->getLevel()== RS_Debug::D_DEBUGGING)
             dwgr.setDebug(DRW::DebugLevel::Debug);
+        dwgr.setDecodeThreads(0);
         bool success = dwgr.read(this, true);
         RS_DEBUG->print("RS_FilterDXFRW::fileImport: reading DWG file: OK");
         RS_DIALOGFACTORY->commandMessage(QObject::tr("Opened dwg file version %1.").arg(printDwgVersion(dwgr.getVersion())));
@@ -178,6 +185,7 @@ bool RS_FilterDXFRW::fileImport(RS_Graphic& g, const QString& file, RS2::FormatT
             RS_DEBUG->print(RS_Debug::D_WARNING,
                             "Cannot open DWG file '%s'.", (const char*)QFile::encodeName(file));
             errorCode = dwgr.getError();
+            regeneration.clear();
             return false;
         }
     } else {
@@ -193,12 +201,14 @@ bool RS_FilterDXFRW::fileImport(RS_Graphic& g, const QString& file, RS2::FormatT
             RS_DEBUG->print(RS_Debug::D_WARNING,
                             "Cannot open DXF file '%s'.", (const char*)QFile::encodeName(file));
             errorCode = dxfR.getError();
+            regeneration.clear();
             return false;
         }
 #ifdef DWGSUPPORT
     }
 #endif
 
+    regeneration.remove(dummyContainer);
     delete dummyContainer;
     /*set current layer */
     RS_Layer* cl = graphic->findLayer(graphic->getVariableString("$CLAYER", "0"));
@@ -206,8 +216,13 @@ bool RS_FilterDXFRW::fileImport(RS_Graphic& g, const QString& file, RS2::FormatT
         //require to notify
         graphic->getLayerList()->activate(cl, true);
     }
-    RS_DEBUG->print("RS_FilterDXFRW::fileImport: updating inserts");
-    graphic->updateInserts();
+    if (LC_Regeneration::isEnabled()) {
+        RS_DEBUG->print("RS_FilterDXFRW::fileImport: regenerating entities");
+        regeneration.run(graphic);
+    } else {
+        RS_DEBUG->print("RS_FilterDXFRW::fileImport: updating inserts");
+        graphic->updateInserts();
+    }
 
     RS_DEBUG->print("RS_FilterDXFRW::fileImport OK");
 
@@ -367,8 +382,10 @@ void RS_FilterDXFRW::endBlock() {
         RS_Block *bk = (RS_Block *)currentContainer;
         //remove unnamed blocks *D only if version != R12
         if (version!=1009) {
-            if (bk->getName().startsWith("*D") )
+            if (bk->getName().startsWith("*D") ) {
+                regeneration.remove(bk);
                 graphic->removeBlock(bk);
+            }
         }
     }
     currentContainer = graphic;
@@ -780,7 +797,7 @@ void RS_FilterDXFRW::addMText(const DRW_MText& data) {
     RS_MText* entity = new RS_MText(currentContainer, d);
 
     setEntityAttributes(entity, &data);
-    entity->update();
+    regenerate(entity);
     currentContainer->addEntity(entity);
 }
 
@@ -839,7 +856,7 @@ void RS_FilterDXFRW::addText(const DRW_Text& data) {
     RS_Text* entity = new RS_Text(currentContainer, d);
 
     setEntityAttributes(entity, &data);
-    entity->update();
+    regenerate(entity);
     currentContainer->addEntity(entity);
 }
 
@@ -928,7 +945,7 @@ void RS_FilterDXFRW::addDimAlign(const DRW_DimAligned *data) {
                             dimensionData, d);
     setEntityAttributes(entity, data);
     entity->updateDimPoint();
-    entity->update();
+    regenerate(entity);
     currentContainer->addEntity(entity);
 }
 
@@ -952,7 +969,7 @@ void RS_FilterDXFRW::addDimLinear(const DRW_DimLinear *data) {
     RS_DimLinear* entity = new RS_DimLinear(currentContainer,
                                             dimensionData, d);
     setEntityAttributes(entity, data);
-    entity->update();
+    regenerate(entity);
     currentContainer->addEntity(entity);
 }
 
@@ -974,7 +991,7 @@ void RS_FilterDXFRW::addDimRadial(const DRW_DimRadial* data) {
                                             dimensionData, d);
 
     setEntityAttributes(entity, data);
-    entity->update();
+    regenerate(entity);
     currentContainer->addEntity(entity);
 }
 
@@ -996,7 +1013,7 @@ void RS_FilterDXFRW::addDimDiametric(const DRW_DimDiametric* data) {
                               dimensionData, d);
 
     setEntityAttributes(entity, data);
-    entity->update();
+    regenerate(entity);
     currentContainer->addEntity(entity);
 }
 
@@ -1021,7 +1038,7 @@ void RS_FilterDXFRW::addDimAngular(const DRW_DimAngular* data) {
                             dimensionData, d);
 
     setEntityAttributes(entity, data);
-    entity->update();
+    regenerate(entity);
     currentContainer->addEntity(entity);
 }
 
@@ -1047,7 +1064,7 @@ void RS_FilterDXFRW::addDimAngular3P(const DRW_DimAngular3p* data) {
                             dimensionData, d);
 
     setEntityAttributes(entity, data);
-    entity->update();
+    regenerate(entity);
     currentContainer->addEntity(entity);
 }
 
@@ -1194,7 +1211,7 @@ void RS_FilterDXFRW::addHatch(const DRW_Hatch *data) {
 
     RS_DEBUG->print("hatch->update()");
     if (hatch->validate()) {
-        hatch->update();
+        regenerate(hatch);
     } else {
         graphic->removeEntity(hatch);
         RS_DEBUG->print(RS_Debug::D_ERROR,
@@ -1374,6 +1391,7 @@ void RS_FilterDXFRW::addHeader(const DRW_Header* data){
  * @param file Full path to the DXF file that will be written.
  */
 bool RS_FilterDXFRW::fileExport(RS_Graphic& g, const QString& file, RS2::FormatType type) {
+    LC_TRACE_SCOPE("save", "RS_FilterDXFRW::fileExport");
 
     RS_DEBUG->print("RS_FilterDXFDW::fileExport: exporting file '%s'...",
                     (const char*)QFile::encodeName(file));
@@ -2995,6 +3013,20 @@ void RS_FilterDXFRW::writeImage(RS_Image * i) {
 }*/
 
 
+/**
+ * Updates the imported entity, or queues it to be updated with the
+ * other entities once the file is read.
+ */
+void RS_FilterDXFRW::regenerate(RS_Entity* entity) {
+    if (LC_Regeneration::isEnabled()) {
+        regeneration.add(entity);
+    } else {
+        entity->update();
+    }
+}
+
+
+
 /**
  * Sets the entities attributes according to the attributes
  * that come from a DXF file.
@@ -3003,37 +3035,65 @@ void RS_FilterDXFRW::setEntityAttributes(RS_Entity* entity,
                                        const DRW_Entity* attrib) {
     RS_DEBUG->print("RS_FilterDXF::setEntityAttributes");
 
+    RS_Layer* layer;
     RS_Pen pen;
-    pen.setColor(Qt::black);
-    pen.setLineType(RS2::SolidLine);
-    QString layName = toNativeString(QString::fromUtf8(attrib->layer.c_str()));
+    if (attributeCacheEnabled) {
+        // layers, line types and pens are resolved once per import
+        const QByteArray layerName = QByteArray::fromRawData(attrib->layer.data(),
+                                                             int(attrib->layer.size()));
+        auto itLayer = layerCache.constFind(layerName);
+        if (itLayer == layerCache.constEnd()) {
+            itLayer = layerCache.insert(QByteArray(layerName.constData(), layerName.size()),
+                                        requestLayer(attrib->layer));
+        }
+        layer = *itLayer;
+
+        const QByteArray lineTypeName = QByteArray::fromRawData(attrib->lineType.data(),
+                                                                int(attrib->lineType.size()));
+        auto itLineType = lineTypeCache.constFind(lineTypeName);
+        if (itLineType == lineTypeCache.constEnd()) {
+            itLineType = lineTypeCache.insert(QByteArray(lineTypeName.constData(), lineTypeName.size()),
+                                              nameToLineType(QString::fromUtf8(attrib->lineType.c_str())));
+        }
 
-    // Layer: add layer in case it doesn't exist:
-	if (!graphic->findLayer(layName)) {
-        DRW_Layer lay;
-        lay.name = attrib->layer;
-        addLayer(lay);
+        const quint64 penKey = (quint64(quint32(attrib->color24 + 1)) << 32)
+                | (quint64(attrib->color & 0xFFFF) << 16)
+                | (quint64(attrib->lWeight & 0xFF) << 8)
+                | quint64(*itLineType & 0xFF);
+        auto itPen = penCache.constFind(penKey);
+        if (itPen == penCache.constEnd()) {
+            RS_Pen newPen = attributesToPen(attrib);
+            newPen.setLineType(*itLineType);
+            itPen = penCache.insert(penKey, newPen);
+        }
+        pen = *itPen;
+    } else {
+        layer = requestLayer(attrib->layer);
+        pen = attributesToPen(attrib);
     }
-    entity->setLayer(layName);
-
-    // Color:
-    if (attrib->color24 >= 0)
-        pen.setColor(RS_Color(attrib->color24 >> 16,
-                              attrib->color24 >> 8 & 0xFF,
-                              attrib->color24 & 0xFF));
-    else
-    pen.setColor(numberToColor(attrib->color));
-
-    // Linetype:
-    pen.setLineType(nameToLineType( QString::fromUtf8(attrib->lineType.c_str()) ));
-
-    // Width:
-    pen.setWidth(numberToWidth(attrib->lWeight));
 
+    entity->setLayer(entity->getGraphic() ? layer : nullptr);
     entity->setPen(pen);
     RS_DEBUG->print("RS_FilterDXF::setEntityAttributes: OK");
 }
 
+/**
+ * @return the layer of the given name, which is added if it doesn't exist.
+ */
+RS_Layer* RS_FilterDXFRW::requestLayer(const std::string& name) {
+    QString layName = toNativeString(QString::fromUtf8(name.c_str()));
+
+    // Layer: add layer in case it doesn't exist:
+    RS_Layer* layer = graphic->findLayer(layName);
+    if (!layer) {
+        DRW_Layer lay;
+        lay.name = name;
+        addLayer(lay);
+        layer = graphic->findLayer(layName);
+    }
+    return layer;
+}
+
 
 
 /**
@@ -3073,6 +3133,39 @@ void RS_FilterDXFRW::getEntityAttributes(DRW_Entity* ent, const RS_Entity* entit
 
 
 
+bool RS_FilterDXFRW::attributeCacheEnabled = true;
+
+void RS_FilterDXFRW::setAttributeCacheEnabled(bool enable) {
+    attributeCacheEnabled = enable;
+}
+
+bool RS_FilterDXFRW::isAttributeCacheEnabled() {
+    return attributeCacheEnabled;
+}
+
+/**
+ * Converts the color, line type and width of entity attributes into a pen.
+ */
+RS_Pen RS_FilterDXFRW::attributesToPen(const DRW_Entity* att) const {
+    RS_Pen pen;
+    // Color:
+    if (att->color24 >= 0)
+        pen.setColor(RS_Color(att->color24 >> 16,
+                              att->color24 >> 8 & 0xFF,
+                              att->color24 & 0xFF));
+    else
+        pen.setColor(numberToColor(att->color));
+
+    // Linetype:
+    pen.setLineType(nameToLineType( QString::fromUtf8(att->lineType.c_str()) ));
+
+    // Width:
+    pen.setWidth(numberToWidth(att->lWeight));
+    return pen;
+}
+
+
+
 /**
  * @return Pen with the same attributes as 'attrib'.
  */
@@ -31,6 +31,7 @@
 
 #include "rs_color.h"
 #include "rs_dimension.h"
+#include "lc_regeneration.h"
 #include "drw_interface.h"
 #include "libdxfrw.h"
 
@@ -168,13 +169,23 @@ public:
 	
 
     void setEntityAttributes(RS_Entity* entity, const DRW_Entity* attrib);
+    RS_Layer* requestLayer(const std::string& name);
+    void regenerate(RS_Entity* entity);
     void getEntityAttributes(DRW_Entity* ent, const RS_Entity* entity);
 
     static QString toDxfString(const QString& str);
     static QString toNativeString(const QString& data);
 
 public:
+    /**
+     * Enables / disables the cache of the layers and pens of the entity
+     * attributes during import. By default this is turned on.
+     */
+    static void setAttributeCacheEnabled(bool enable);
+    static bool isAttributeCacheEnabled();
+
     RS_Pen attributesToPen(const DRW_Layer* att) const;
+    RS_Pen attributesToPen(const DRW_Entity* att) const;
 
     static RS_Color numberToColor(int num);
     static int colorToNumber(const RS_Color& col, int *rgb);
@@ -235,6 +246,15 @@ private:
     QHash<int, RS_EntityContainer*> blockHash;
     /** Pointer to entity container to store possible orphan entities like paper space */
     RS_EntityContainer* dummyContainer;
+    /** layers of the imported entities by the layer names in the file */
+    QHash<QByteArray, RS_Layer*> layerCache;
+    /** line types of the imported entities by the names in the file */
+    QHash<QByteArray, RS2::LineType> lineTypeCache;
+    /** pens of the imported entities by line type, color and width */
+    QHash<quint64, RS_Pen> penCache;
+    static bool attributeCacheEnabled;
+    /** texts, dimensions and hatches to update once the file is read */
+    LC_Regeneration regeneration;
 };
 
 #endif
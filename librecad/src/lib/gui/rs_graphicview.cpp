@@ -47,6 +47,8 @@
 #include "rs_settings.h"
 #include "rs_dialogfactory.h"
 #include "rs_layer.h"
+#include "rs_block.h"
+#include "rs_insert.h"
 #include "rs_math.h"
 #include "rs_debug.h"
 #include "rs_color.h"
@@ -928,7 +930,17 @@ void RS_GraphicView::drawLayer1(RS_Painter *painter) {
 
 void RS_GraphicView::drawLayer2(RS_Painter *painter)
 {
-	drawEntity(painter, container);	//	Draw all entities.
+	if (painter->shouldDrawSelected() && container->isDocument()) {
+		//	Draw selected entities only, they are found in the selection
+		//	candidates of the document without traversing the entity tree.
+		//	They are drawn in the order of the document, so overlapping
+		//	entities do not swap places between redraws.
+		for (RS_Entity* e: container->getSelectionCandidatesInOrder()) {
+			drawEntity(painter, e);
+		}
+	} else {
+		drawEntity(painter, container);	//	Draw all entities.
+	}
 
 	//	If not in print preview, draw the absolute zero reference.
 	//	----------------------------------------------------------
@@ -967,55 +979,97 @@ void RS_GraphicView::drawLayer3(RS_Painter *painter) {
 
 void RS_GraphicView::setPenForEntity(RS_Painter *painter,RS_Entity *e)
 {
-	if (draftMode) {
-		painter->setPen(RS_Pen(foreground,
-							   RS2::Width00, RS2::SolidLine));
+	// pens set outside of drawEntity(), e.g. for overlays
+	if (drawingDepth == 0) {
+		updateRenderContext();
 	}
 
 	// Getting pen from entity (or layer)
-	RS_Pen pen = e->getPen(true);
+	const RS_Pen pen = getDrawnPen(e);
+	const bool selected = !renderContext.printing && isDrawnSelected(e);
+	const bool highlighted = !renderContext.printing && e->isHighlighted();
+
+	// drawings use few distinct pens, the pen to draw with is derived once
+	// per drawing for each of them
+	const RS_Color& color = pen.getColor();
+	const quint64 key = (static_cast<quint64>(color.rgb() & 0xffffff) << 32)
+			| (static_cast<quint64>(pen.getWidth() & 0xffff) << 16)
+			| (static_cast<quint64>(pen.getLineType() & 0xff) << 8)
+			| (color.isByLayer() ? 8u : 0u) | (color.isByBlock() ? 4u : 0u)
+			| (selected ? 2u : 0u) | (highlighted ? 1u : 0u);
+	auto it = renderContext.pens.constFind(key);
+	if (it == renderContext.pens.constEnd()) {
+		it = renderContext.pens.insert(key, getPenForDrawing(pen, selected, highlighted));
+	}
 
-	int w = pen.getWidth();
-	if (w<0) {
-		w = 0;
+	// deleting not drawing:
+	if (getDeleteMode()) {
+		RS_Pen deletePen = it.value();
+		deletePen.setColor(background);
+		painter->setPen(deletePen);
+	} else {
+		painter->setPen(it.value());
 	}
+}
+
+
+/**
+ * Updates the settings used by setPenForEntity() and forgets the pens
+ * derived from them.
+ */
+void RS_GraphicView::updateRenderContext()
+{
+	renderContext.pens.clear();
+	renderContext.printing = isPrinting() || isPrintPreview();
+	renderContext.draft = draftMode;
 
 	// - Scale pen width.
 	// - By default pen width is not scaled on print and print preview.
 	//   This is the standard (AutoCAD like) behaviour.
 	// bug# 3437941
 	// ------------------------------------------------------------
-	if (!draftMode)
-	{
-		double	uf = 1.0;	// Unit factor.
-		double	wf = 1.0;	// Width factor.
+	double	uf = 1.0;	// Unit factor.
+	double	wf = 1.0;	// Width factor.
 
-		RS_Graphic* graphic = container->getGraphic();
+	RS_Graphic* graphic = container ? container->getGraphic() : nullptr;
+	if (graphic)
+	{
+		uf = RS_Units::convert(1.0, RS2::Millimeter, graphic->getUnit());
 
-        if (graphic)
+		if (renderContext.printing &&
+				graphic->getPaperScale() > RS_TOLERANCE )
 		{
-			uf = RS_Units::convert(1.0, RS2::Millimeter, graphic->getUnit());
-
-			if ((isPrinting() || isPrintPreview()) &&
-					graphic->getPaperScale() > RS_TOLERANCE )
+			if (scaleLineWidth)
 			{
-				if (scaleLineWidth)
-				{
-					wf = graphic->getVariableDouble("$DIMSCALE", 1.0);
-				}
-				else
-				{
-					wf = 1.0 / graphic->getPaperScale();
-				}
-
+				wf = graphic->getVariableDouble("$DIMSCALE", 1.0);
+			}
+			else
+			{
+				wf = 1.0 / graphic->getPaperScale();
 			}
 		}
+	}
+	renderContext.widthFactor = uf * wf;
+}
 
-		pen.setScreenWidth(toGuiDX(w / 100.0 * uf * wf));
+
+/**
+ * @return the pen to draw an entity with the resolved pen with,
+ * i.e. with the width in pixels and the colors of the view
+ */
+RS_Pen RS_GraphicView::getPenForDrawing(RS_Pen pen, bool selected, bool highlighted) const
+{
+	int w = pen.getWidth();
+	if (w<0) {
+		w = 0;
+	}
+
+	if (!renderContext.draft)
+	{
+		pen.setScreenWidth(toGuiDX(w / 100.0 * renderContext.widthFactor));
 	}
 	else
 	{
-		//		pen.setWidth(RS2::Width00);
 		pen.setScreenWidth(0);
 	}
 
@@ -1033,26 +1087,18 @@ void RS_GraphicView::setPenForEntity(RS_Painter *painter,RS_Entity *e)
         pen.setColor( foreground);
     }
 
-	if (!isPrinting() && !isPrintPreview())
-	{
-		// this entity is selected:
-		if (e->isSelected()) {
-			pen.setLineType(RS2::DotLine);
-			pen.setColor(selectedColor);
-		}
-
-		// this entity is highlighted:
-		if (e->isHighlighted()) {
-			pen.setColor(highlightedColor);
-		}
+	// this entity is selected:
+	if (selected) {
+		pen.setLineType(RS2::DotLine);
+		pen.setColor(selectedColor);
 	}
 
-	// deleting not drawing:
-	if (getDeleteMode()) {
-		pen.setColor(background);
+	// this entity is highlighted:
+	if (highlighted) {
+		pen.setColor(highlightedColor);
 	}
 
-	painter->setPen(pen);
+	return pen;
 }
 
 
@@ -1083,6 +1129,165 @@ void RS_GraphicView::drawEntity(RS_Entity* /*e*/ /*patternOffset*/) {
 	// For now we just redraw the drawing until we are going to optimize drawing
 	redraw(RS2::RedrawDrawing);
 }
+void RS_GraphicView::redrawArea(const RS_Vector& /*v1*/, const RS_Vector& /*v2*/) {
+	redraw(RS2::RedrawDrawing);
+}
+
+void RS_GraphicView::redrawEntityArea(RS_Entity* e) {
+	if (!e) {
+		return;
+	}
+	switch (e->rtti()) {
+	case RS2::EntityPoint:
+	case RS2::EntityConstructionLine:
+		// points are drawn with a size on screen, construction lines
+		// have no finite bounding box
+		redraw(RS2::RedrawDrawing);
+		break;
+	default: {
+		// handles of selected entities are drawn at their reference
+		// points, which can lie outside of the bounding box, e.g. the
+		// center of an arc
+		RS_Vector vmin = e->getMin();
+		RS_Vector vmax = e->getMax();
+		for (const RS_Vector& v: e->getRefPoints()) {
+			if (v.valid) {
+				vmin = RS_Vector::minimum(vmin, v);
+				vmax = RS_Vector::maximum(vmax, v);
+			}
+		}
+		redrawArea(vmin, vmax);
+	}
+	}
+}
+
+LC_Rect RS_GraphicView::getDrawingArea() const {
+	if (!insertContexts.empty()) {
+		return insertContexts.back().drawingArea;
+	}
+	const QRect area = drawingRect.isNull() ? QRect(0, 0, getWidth(), getHeight()) : drawingRect;
+	return {toGraph(area.x(), area.y()),
+			toGraph(area.x() + area.width(), area.y() + area.height())};
+}
+
+LC_Rect RS_GraphicView::getViewArea() const {
+	if (!insertContexts.empty()) {
+		return insertContexts.back().viewArea;
+	}
+	return {toGraph(0, getHeight()), toGraph(getWidth(), 0)};
+}
+
+/**
+ * @return the graph coordinates of an area given in view coordinates
+ */
+LC_Rect RS_GraphicView::toGraphArea(const QRectF& area) const {
+	return {toGraph(RS_Vector(area.left(), area.bottom())),
+			toGraph(RS_Vector(area.right(), area.top()))};
+}
+
+void RS_GraphicView::beginInsert(RS_Painter* painter, const RS_Insert* insert,
+								 const RS_Block* blk, const QTransform& transform) {
+	InsertContext context;
+	context.block = blk;
+	context.pen = getDrawnPen(insert);
+	context.layer = getDrawnLayer(insert);
+	context.selected = isDrawnSelected(insert);
+	context.previousTransform = painter->getDrawingTransform();
+
+	const QTransform t = transform * context.previousTransform;
+	// the block entities are clipped against the view in their coordinates
+	const QTransform toBlock = t.inverted();
+	const QRectF view(0., 0., getWidth(), getHeight());
+	context.viewArea = toGraphArea(toBlock.mapRect(view));
+	context.drawingArea = toGraphArea(toBlock.mapRect(drawingRect.isNull() ? view : QRectF(drawingRect)));
+
+	painter->setDrawingTransform(t);
+	insertContexts.push_back(context);
+}
+
+void RS_GraphicView::endInsert(RS_Painter* painter) {
+	if (insertContexts.empty()) {
+		return;
+	}
+	painter->setDrawingTransform(insertContexts.back().previousTransform);
+	insertContexts.pop_back();
+}
+
+bool RS_GraphicView::isDrawnSelected(const RS_Entity* e) const {
+	return insertContexts.empty() ? e->isSelected() : insertContexts.back().selected;
+}
+
+/**
+ * @return layer of the entity as drawn, entities of a block on layer 0
+ * are drawn on the layer of the insert
+ */
+RS_Layer* RS_GraphicView::getDrawnLayer(const RS_Entity* e) const {
+	if (insertContexts.empty()) {
+		return e->getLayer(true);
+	}
+	const InsertContext& context = insertContexts.back();
+	RS_Layer* l = e->getLayer(false);
+	if (!l) {
+		const RS_EntityContainer* parent = e->getParent();
+		return (!parent || parent == context.block) ? context.layer : getDrawnLayer(parent);
+	}
+	return l->getName() == "0" ? context.layer : l;
+}
+
+RS_Pen RS_GraphicView::getDrawnPen(const RS_Entity* e) const {
+	if (insertContexts.empty()) {
+		return e->getPen(true);
+	}
+	const InsertContext& context = insertContexts.back();
+	const RS_EntityContainer* parent = e->getParent();
+	const RS_Pen parentPen = (!parent || parent == context.block) ? context.pen : getDrawnPen(parent);
+
+	RS_Pen p = e->getPen(false);
+	if (!p.isValid()) {
+		p = parentPen;
+	}
+	if (p.getColor().isByBlock()) {
+		p.setColor(parentPen.getColor());
+	}
+	if (p.getWidth() == RS2::WidthByBlock) {
+		p.setWidth(parentPen.getWidth());
+	}
+	if (p.getLineType() == RS2::LineByBlock) {
+		p.setLineType(parentPen.getLineType());
+	}
+
+	const RS_Layer* l = getDrawnLayer(e);
+	if (l) {
+		if (p.getColor().isByLayer()) {
+			p.setColor(l->getPen().getColor());
+		}
+		if (p.getWidth() == RS2::WidthByLayer) {
+			p.setWidth(l->getPen().getWidth());
+		}
+		if (p.getLineType() == RS2::LineByLayer) {
+			p.setLineType(l->getPen().getLineType());
+		}
+	}
+	return p;
+}
+
+bool RS_GraphicView::isDrawnVisible(const RS_Entity* e) const {
+	if (insertContexts.empty()) {
+		return e->isVisible();
+	}
+	if (e->isUndone()) {
+		return false;
+	}
+	if (e->rtti() == RS2::EntityInsert) {
+		const RS_Block* blk = static_cast<const RS_Insert*>(e)->getBlockForInsert();
+		if (blk && blk->isFrozen()) {
+			return false;
+		}
+	}
+	const RS_Layer* l = getDrawnLayer(e);
+	return !l || !l->isFrozen();
+}
+
 void RS_GraphicView::drawEntity(RS_Painter *painter, RS_Entity* e) {
 	double offset(0.);
 	drawEntity(painter,e,offset);
@@ -1096,24 +1301,43 @@ void RS_GraphicView::drawEntity(RS_Painter *painter, RS_Entity* e, double& patte
 	}
 
 	// entity is not visible:
-	if (!e->isVisible()) {
+	if (!isDrawnVisible(e)) {
 		return;
 	}
 	if( isPrintPreview() || isPrinting() ) {
 		// do not draw construction layer on print preview or print
-		if( ! e->isPrint()
-				||  e->isConstruction())
-        return;
+		if (insertContexts.empty()) {
+			if( ! e->isPrint()
+					||  e->isConstruction())
+				return;
+		} else {
+			const RS_Layer* l = getDrawnLayer(e);
+			if (l && (!l->isPrint() || l->isConstruction()))
+				return;
+		}
 	}
 
-    // test if the entity is in the viewport
+    // test if the entity is in the viewport, or in the part being redrawn
+    const QRect area = drawingRect.isNull() ? QRect(0, 0, getWidth(), getHeight()) : drawingRect;
     if (!isPrinting() &&
         e->rtti() != RS2::EntityGraphic &&
-        e->rtti() != RS2::EntityLine &&
-       (toGuiX(e->getMax().x)<0 || toGuiX(e->getMin().x)>getWidth() ||
-        toGuiY(e->getMin().y)<0 || toGuiY(e->getMax().y)>getHeight())) {
-        return;
+        e->rtti() != RS2::EntityLine) {
+        QRectF box(QPointF(toGuiX(e->getMin().x), toGuiY(e->getMax().y)),
+                   QPointF(toGuiX(e->getMax().x), toGuiY(e->getMin().y)));
+        if (!insertContexts.empty()) {
+            box = painter->getDrawingTransform().mapRect(box);
+        }
+        if (box.right()<area.x() || box.left()>area.x() + area.width() ||
+            box.bottom()<area.y() || box.top()>area.y() + area.height()) {
+            return;
+        }
     }
+    ++drawnEntities;
+
+	// the render context is fixed while the outermost entity is drawn
+	if (drawingDepth++ == 0) {
+		updateRenderContext();
+	}
 
 	// set pen (color):
 	setPenForEntity(painter, e );
@@ -1139,8 +1363,8 @@ void RS_GraphicView::drawEntity(RS_Painter *painter, RS_Entity* e, double& patte
 		drawEntityPlain(painter, e, patternOffset);
 	}
 
-	// draw reference points:
-	if (e->isSelected() && !(isPrinting() || isPrintPreview())) {
+	// draw reference points, the entities of a block have none:
+	if (insertContexts.empty() && e->isSelected() && !(isPrinting() || isPrintPreview())) {
 		if (!e->isParentSelected()) {
 			RS_VectorSolutions const& s = e->getRefPoints();
 
@@ -1162,6 +1386,8 @@ void RS_GraphicView::drawEntity(RS_Painter *painter, RS_Entity* e, double& patte
 		}
 	}
 
+	--drawingDepth;
+
 	//RS_DEBUG->print("draw plain OK");
 
 
@@ -1178,7 +1404,7 @@ void RS_GraphicView::drawEntityPlain(RS_Painter *painter, RS_Entity* e, double&
 		return;
 	}
 
-	if (!e->isContainer() && (e->isSelected()!=painter->shouldDrawSelected())) {
+	if (!e->isContainer() && (isDrawnSelected(e)!=painter->shouldDrawSelected())) {
 		return;
 	}
 
@@ -1190,7 +1416,7 @@ void RS_GraphicView::drawEntityPlain(RS_Painter *painter, RS_Entity* e) {
 		return;
 	}
 
-	if (!e->isContainer() && (e->isSelected()!=painter->shouldDrawSelected())) {
+	if (!e->isContainer() && (isDrawnSelected(e)!=painter->shouldDrawSelected())) {
 		return;
 	}
 	double patternOffset(0.);
@@ -33,7 +33,9 @@
 #include "lc_rect.h"
 
 #include <QDateTime>
+#include <QHash>
 #include <QMap>
+#include <QTransform>
 #include <tuple>
 #include <memory>
 #include <QAction>
@@ -45,6 +47,9 @@ class RS_ActionInterface;
 class RS_EventHandler;
 class RS_CommandEvent;
 class RS_Grid;
+class RS_Insert;
+class RS_Block;
+class RS_Layer;
 struct RS_LineTypePattern;
 
 
@@ -111,6 +116,18 @@ public:
 	/** This virtual method must be overwritten to redraw
 	  the widget. */
 	virtual void redraw(RS2::RedrawMethod method=RS2::RedrawAll) = 0;
+	/**
+	 * Redraws the drawing within the given area in graph coordinates,
+	 * e.g. after a modification. The default implementation redraws
+	 * the whole drawing.
+	 */
+	virtual void redrawArea(const RS_Vector& v1, const RS_Vector& v2);
+	/**
+	 * Redraws the area covered by the given entity and its reference
+	 * points. The whole drawing is redrawn for entities whose size on
+	 * screen does not follow their bounding box.
+	 */
+	void redrawEntityArea(RS_Entity* e);
 	/** This virtual method must be overwritten and is then
 	  called whenever the view changed */
     virtual void adjustOffsetControls() = 0;
@@ -273,6 +290,30 @@ public:
 	virtual void drawEntityPlain(RS_Painter *painter, RS_Entity* e);
 	virtual void drawEntityPlain(RS_Painter *painter, RS_Entity* e, double& patternOffset);
 	virtual void setPenForEntity(RS_Painter *painter, RS_Entity* e );
+	/**
+	 * Starts drawing the entities of the block of an insert. The entities
+	 * are drawn as they are, transformed by the painter. Their attributes
+	 * taken from the block, such as layer 0 and pens by block, are
+	 * resolved to the ones of the insert, and they are drawn as selected
+	 * if the insert is selected.
+	 *
+	 * @param transform maps the view coordinates of the block entities to
+	 *        the ones of the insert.
+	 */
+	void beginInsert(RS_Painter* painter, const RS_Insert* insert,
+					 const RS_Block* blk, const QTransform& transform);
+	/** Ends drawing the entities of the block started by beginInsert(). */
+	void endInsert(RS_Painter* painter);
+	/**
+	 * @return true if the entity is drawn as selected, i.e. it is selected
+	 * or it is drawn for a selected insert.
+	 */
+	bool isDrawnSelected(const RS_Entity* e) const;
+	/**
+	 * @return resolved pen of the entity as drawn, see RS_Entity::getPen().
+	 * Pens by block of the entities of a block are resolved to the insert.
+	 */
+	RS_Pen getDrawnPen(const RS_Entity* e) const;
     virtual RS_Vector getMousePosition() const = 0;
 
 	virtual const RS_LineTypePattern* getPattern(RS2::LineType t);
@@ -370,6 +411,14 @@ public:
         return view_rect;
     }
 
+	/**
+	 * @return area of the view currently drawn, in the coordinates of the
+	 * entities drawn
+	 */
+	LC_Rect getDrawingArea() const;
+	/** @return the whole view, in the coordinates of the entities drawn */
+	LC_Rect getViewArea() const;
+
     bool isPanning() const;
     void setPanning(bool state);
 
@@ -428,7 +477,47 @@ protected:
 
     LC_Rect view_rect;
 
+	/** number of entities drawn, for redraw statistics */
+	unsigned drawnEntities=0;
+	/** part of the view currently drawn in GUI coordinates, null for the whole view */
+	QRect drawingRect;
+
 private:
+	/**
+	 * Settings of the view used by setPenForEntity(), which do not change
+	 * while the entities are drawn. Updated once per drawing by the
+	 * outermost drawEntity().
+	 */
+	struct RenderContext {
+		/** factor from pen widths in mm to drawing units */
+		double widthFactor = 1.0;
+		bool printing = false;
+		bool draft = false;
+		/** pens to draw with by resolved entity pen and selection state */
+		QHash<quint64, RS_Pen> pens;
+	};
+
+	void updateRenderContext();
+	RS_Pen getPenForDrawing(RS_Pen pen, bool selected, bool highlighted) const;
+
+	/**
+	 * An insert whose block entities are drawn, see beginInsert().
+	 */
+	struct InsertContext {
+		const RS_Block* block = nullptr;
+		/** resolved pen and layer of the insert */
+		RS_Pen pen;
+		RS_Layer* layer = nullptr;
+		bool selected = false;
+		/** view areas in the coordinates of the block */
+		LC_Rect viewArea;
+		LC_Rect drawingArea;
+		QTransform previousTransform;
+	};
+
+	RS_Layer* getDrawnLayer(const RS_Entity* e) const;
+	bool isDrawnVisible(const RS_Entity* e) const;
+	LC_Rect toGraphArea(const QRectF& area) const;
 
 	bool zoomFrozen=false;
 	bool draftMode=false;
@@ -464,6 +553,12 @@ private:
 
 	bool scaleLineWidth;
 
+	RenderContext renderContext;
+	/** nesting depth of drawEntity() */
+	int drawingDepth=0;
+	/** inserts whose block entities are drawn, the innermost last */
+	std::vector<InsertContext> insertContexts;
+
 signals:
     void relative_zero_changed(const RS_Vector&);
     void previous_zoom_state(bool);
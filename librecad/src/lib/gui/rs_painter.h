@@ -38,6 +38,7 @@ class QPolygon;
 class QPolygonF;
 class QImage;
 class QBrush;
+class QTransform;
 
 /**
  * This class is a common interface for a painter class. Such
@@ -137,6 +138,13 @@ public:
     virtual const QBrush& brush() const = 0;
     virtual void setBrush(const RS_Color& color) = 0;
     virtual void setBrush(const QBrush& color) = 0;
+    /**
+     * Sets the transformation applied to everything drawn afterwards,
+     * e.g. to draw the entities of a block at an insert. Pen widths are
+     * not transformed.
+     */
+    virtual void setDrawingTransform(const QTransform& t) = 0;
+    virtual QTransform getDrawingTransform() const = 0;
     virtual void drawPolygon(const QPolygon& a, Qt::FillRule rule=Qt::WindingFill) = 0;
     virtual void erase() = 0;
     virtual int getWidth() const= 0;
@@ -418,7 +418,7 @@ void RS_PainterQt::drawImg(QImage& img, const RS_Vector& pos,
     wm.translate(pos.x, pos.y);
     wm.rotate(RS_Math::rad2deg(-angle));
     wm.scale(factor.x, factor.y);
-    setWorldMatrix(wm);
+    setWorldMatrix(wm, true);
 
 
     drawImage(0,-img.height(), img);
@@ -531,24 +531,33 @@ void RS_PainterQt::setPen(const RS_Pen& pen) {
 		   rsToQtLineType(lpen.getLineType()));
     p.setJoinStyle(Qt::RoundJoin);
     p.setCapStyle(Qt::RoundCap);
-    QPainter::setPen(p);
+    setQtPen(p);
+}
+
+/**
+ * Sets the pen, with the width in pixels while a drawing transformation
+ * is set.
+ */
+void RS_PainterQt::setQtPen(QPen pen) {
+    pen.setCosmetic(transformed);
+    QPainter::setPen(pen);
 }
 
 void RS_PainterQt::setPen(const RS_Color& color) {
     switch (drawingMode) {
     case RS2::ModeBW:
         lpen.setColor( RS_Color( Qt::black));
-        QPainter::setPen( RS_Color( Qt::black));
+        setQtPen(QPen(RS_Color( Qt::black)));
         break;
 
     case RS2::ModeWB:
         lpen.setColor( RS_Color( Qt::white));
-        QPainter::setPen( RS_Color( Qt::white));
+        setQtPen(QPen(RS_Color( Qt::white)));
         break;
 
     default:
         lpen.setColor( color);
-        QPainter::setPen( color);
+        setQtPen(QPen(color));
         break;
     }
 }
@@ -594,6 +603,16 @@ void RS_PainterQt::setBrush(const QBrush& color) {
     QPainter::setBrush(color);
 }
 
+void RS_PainterQt::setDrawingTransform(const QTransform& t) {
+    setWorldTransform(t);
+    transformed = !t.isIdentity();
+    setQtPen(QPainter::pen());
+}
+
+QTransform RS_PainterQt::getDrawingTransform() const {
+    return worldTransform();
+}
+
 void RS_PainterQt::drawPolygon(const QPolygon& a, Qt::FillRule rule) {
     QPainter::drawPolygon(a,rule);
 }
@@ -104,12 +104,18 @@ public:
     virtual const QBrush& brush() const;
     virtual void setBrush(const RS_Color& color);
     virtual void setBrush(const QBrush& color);
+    virtual void setDrawingTransform(const QTransform& t);
+    virtual QTransform getDrawingTransform() const;
 
     virtual void setClipRect(int x, int y, int w, int h);
     virtual void resetClipping();
 
 protected:
+    void setQtPen(QPen pen);
+
     RS_Pen lpen;
+    /** a drawing transformation is set */
+    bool transformed = false;
     long rememberX; // Used for the moment because QPainter doesn't support moveTo anymore, thus we need to remember ourselves the moveTo positions
     long rememberY;
 };
@@ -47,6 +47,7 @@
 #include "rs_debug.h"
 #include "rs_dialogfactory.h"
 #include "lc_undosection.h"
+#include "lc_trace.h"
 
 #ifdef EMU_C99
 #include "emu_c99.h"
@@ -91,6 +92,7 @@ RS_Modification::RS_Modification(RS_EntityContainer& container,
  * Deletes all selected entities.
  */
 void RS_Modification::remove() {
+    LC_TRACE_SCOPE("modify", "RS_Modification::remove");
 
     RS_DEBUG->print(RS_Debug::D_DEBUGGING, "RS_Modification::remove");
 
@@ -106,13 +108,14 @@ void RS_Modification::remove() {
             e->setSelected(false);
             e->changeUndoState();
             undo.addUndoable(e);
+            if (graphicView) {
+                graphicView->redrawEntityArea(e);
+            }
         } else {
             RS_DEBUG->print(RS_Debug::D_WARNING, "RS_Modification::remove: no valid container is selected");
         }
     }
 
-    graphicView->redraw(RS2::RedrawDrawing);
-
     RS_DEBUG->print(RS_Debug::D_DEBUGGING, "RS_Modification::remove: OK");
 }
 
@@ -253,6 +256,7 @@ bool RS_Modification::changeAttributes(
  * @param cut true: cut instead of copying, false: copy
  */
 void RS_Modification::copy(const RS_Vector& ref, const bool cut) {
+    LC_TRACE_SCOPE("modify", "RS_Modification::copy");
 
     RS_DEBUG->print(RS_Debug::D_DEBUGGING, "RS_Modification::copy");
 
@@ -445,6 +449,7 @@ void RS_Modification::copyBlocks(RS_Entity* e) {
  *      is the clipboard.
  */
 void RS_Modification::paste(const RS_PasteData& data, RS_Graphic* source) {
+    LC_TRACE_SCOPE("modify", "RS_Modification::paste");
 
     RS_DEBUG->print(RS_Debug::D_INFORMATIONAL, "RS_Modification::paste");
 
@@ -1580,6 +1585,7 @@ RS_Polyline* RS_Modification::polylineTrim(RS_Polyline& polyline,
  * modification.
  */
 bool RS_Modification::move(RS_MoveData& data) {
+    LC_TRACE_SCOPE("modify", "RS_Modification::move");
 	if (!container) {
         RS_DEBUG->print(RS_Debug::D_WARNING,
                         "RS_Modification::move: no valid container");
@@ -1630,6 +1636,7 @@ bool RS_Modification::move(RS_MoveData& data) {
  *@Author: Dongxu Li
  */
 bool RS_Modification::offset(const RS_OffsetData& data) {
+    LC_TRACE_SCOPE("modify", "RS_Modification::offset");
 	if (!container) {
         RS_DEBUG->print(RS_Debug::D_WARNING,
                         "RS_Modification::offset: no valid container");
@@ -1683,6 +1690,7 @@ bool RS_Modification::offset(const RS_OffsetData& data) {
  * Rotates all selected entities with the given data for the rotation.
  */
 bool RS_Modification::rotate(RS_RotateData& data) {
+    LC_TRACE_SCOPE("modify", "RS_Modification::rotate");
 	if (!container) {
         RS_DEBUG->print(RS_Debug::D_WARNING,
                         "RS_Modification::rotate: no valid container");
@@ -1732,6 +1740,7 @@ bool RS_Modification::rotate(RS_RotateData& data) {
  * modification.
  */
 bool RS_Modification::scale(RS_ScaleData& data) {
+    LC_TRACE_SCOPE("modify", "RS_Modification::scale");
 	if (!container) {
         RS_DEBUG->print(RS_Debug::D_WARNING,
                         "RS_Modification::scale: no valid container");
@@ -1811,6 +1820,7 @@ bool RS_Modification::scale(RS_ScaleData& data) {
  * modification.
  */
 bool RS_Modification::mirror(RS_MirrorData& data) {
+    LC_TRACE_SCOPE("modify", "RS_Modification::mirror");
 	if (!container) {
         RS_DEBUG->print(RS_Debug::D_WARNING,
                         "RS_Modification::mirror: no valid container");
@@ -1859,6 +1869,7 @@ bool RS_Modification::mirror(RS_MirrorData& data) {
  * Rotates entities around two centers with the given parameters.
  */
 bool RS_Modification::rotate2(RS_Rotate2Data& data) {
+    LC_TRACE_SCOPE("modify", "RS_Modification::rotate2");
 	if (!container) {
         RS_DEBUG->print(RS_Debug::D_WARNING,
                         "RS_Modification::rotate2: no valid container");
@@ -1912,6 +1923,7 @@ bool RS_Modification::rotate2(RS_Rotate2Data& data) {
  * Moves and rotates entities with the given parameters.
  */
 bool RS_Modification::moveRotate(RS_MoveRotateData& data) {
+    LC_TRACE_SCOPE("modify", "RS_Modification::moveRotate");
 	if (!container) {
         RS_DEBUG->print(RS_Debug::D_WARNING,
                         "RS_Modification::moveRotate: no valid container");
@@ -1992,6 +2004,9 @@ void RS_Modification::deselectOriginals(bool remove)
 
             if (selected) {
                 e->setSelected(false);
+                if (graphicView) {
+                    graphicView->redrawEntityArea(e);
+                }
                 if (remove
                    ) {
                     //if (graphicView) {
@@ -2013,7 +2028,8 @@ void RS_Modification::deselectOriginals(bool remove)
 
 /**
  * Adds the given entities to the container and draws the entities if
- * there's a graphic view available.
+ * there's a graphic view available. Only the areas covered by the new
+ * entities are redrawn.
  *
  * @param addList Entities to add.
  */
@@ -2025,14 +2041,13 @@ void RS_Modification::addNewEntities(std::vector<RS_Entity*>& addList)
         if (e) {
             container->addEntity(e);
             undo.addUndoable(e);
+            if (graphicView) {
+                graphicView->redrawEntityArea(e);
+            }
         }
     }
 
     container->calculateBorders();
-
-    if (graphicView) {
-        graphicView->redraw(RS2::RedrawDrawing);
-    }
 }
 
 
@@ -3036,6 +3051,7 @@ static void update_exploded_children_recursively(
  */
 bool RS_Modification::explode(const bool remove /*= true*/)
 {
+    LC_TRACE_SCOPE("modify", "RS_Modification::explode");
     if (!container) {
         RS_DEBUG->print(RS_Debug::D_WARNING,
                         "RS_Modification::explode: no valid container for addinge entities");
@@ -3294,6 +3310,7 @@ bool RS_Modification::explodeTextIntoLetters(RS_Text* text, std::vector<RS_Entit
  * Moves all reference points of selected entities with the given data.
  */
 bool RS_Modification::moveRef(RS_MoveRefData& data) {
+    LC_TRACE_SCOPE("modify", "RS_Modification::moveRef");
 	if (!container) {
         RS_DEBUG->print(RS_Debug::D_WARNING,
                         "RS_Modification::moveRef: no valid container");
@@ -26,12 +26,14 @@
 
 #include "rs_selection.h"
 
+#include "lc_connectivityindex.h"
 #include "rs_line.h"
 #include "rs_information.h"
 #include "rs_polyline.h"
 #include "rs_entity.h"
 #include "rs_graphic.h"
 #include "rs_layer.h"
+#include "rs_dialogfactory.h"
 
 
 
@@ -51,21 +53,75 @@ RS_Selection::RS_Selection(RS_EntityContainer& container,
 
 
 
+void RS_Selection::begin() {
+    if (transactions++ == 0) {
+        changed.clear();
+        changedMany = false;
+    }
+}
+
+
+
 /**
- * Selects or deselects the given entity.
+ * Ends a transaction started by begin(). Once the outermost one ends, the
+ * changed entities are redrawn and the selection widget updated if
+ * anything changed. Many changes redraw the whole view instead.
  */
-void RS_Selection::selectSingle(RS_Entity* e) {
-	if (e && (! (e->getLayer() && e->getLayer()->isLocked()))) {
+void RS_Selection::commit() {
+    if (transactions == 0 || --transactions > 0
+            || (changed.empty() && !changedMany)) {
+        return;
+    }
 
-        if (graphicView) {
-            graphicView->deleteEntity(e);
+    if (graphicView) {
+        if (changedMany) {
+            graphicView->redraw(RS2::RedrawDrawing);
+        } else {
+            for (RS_Entity* e: changed) {
+                graphicView->redrawEntityArea(e);
+            }
         }
+        RS_DIALOGFACTORY->updateSelectionWidget(container->countSelected(),
+                                                container->totalSelectedLength());
+    }
+    changed.clear();
+    changedMany = false;
+}
 
-       	e->toggleSelected();
 
-        if (graphicView) {
-            graphicView->drawEntity(e);
-        }
+
+void RS_Selection::setSelected(RS_Entity* e, bool select) {
+    if (e->setSelected(select)) {
+        addChanged(e);
+    }
+}
+
+
+
+void RS_Selection::addChanged(RS_Entity* e) {
+    // more areas than this are merged by the view anyway
+    const size_t maxChanged = 64;
+    if (changedMany) {
+        return;
+    }
+    if (changed.size() < maxChanged) {
+        changed.push_back(e);
+    } else {
+        changed.clear();
+        changedMany = true;
+    }
+}
+
+
+
+/**
+ * Selects or deselects the given entity.
+ */
+void RS_Selection::selectSingle(RS_Entity* e) {
+	if (e && (! (e->getLayer() && e->getLayer()->isLocked()))) {
+        begin();
+        setSelected(e, !e->isSelected());
+        commit();
     }
 }
 
@@ -75,9 +131,7 @@ void RS_Selection::selectSingle(RS_Entity* e) {
  * Selects all entities on visible layers.
  */
 void RS_Selection::selectAll(bool select) {
-    if (graphicView) {
-        //graphicView->deleteEntity(container);
-    }
+    begin();
 
 	//container->setSelected(select);
 	for(auto e: *container){
@@ -85,14 +139,11 @@ void RS_Selection::selectAll(bool select) {
         //RS_Entity* e = container->entityAt(i);
 
         if (e && e->isVisible()) {
-            e->setSelected(select);
+            setSelected(e, select);
         }
     }
 
-	if (graphicView) {
-        //graphicView->drawEntity(container);
-		graphicView->redraw();
-    }
+    commit();
 }
 
 
@@ -101,23 +152,18 @@ void RS_Selection::selectAll(bool select) {
  * Selects all entities on visible layers.
  */
 void RS_Selection::invertSelection() {
-    if (graphicView) {
-        //graphicView->deleteEntity(container);
-    }
+    begin();
 
 	for(auto e: *container){
     //for (unsigned i=0; i<container->count(); ++i) {
         //RS_Entity* e = container->entityAt(i);
 
         if (e && e->isVisible()) {
-            e->toggleSelected();
+            setSelected(e, !e->isSelected());
         }
     }
 
-    if (graphicView) {
-        //graphicView->drawEntity(container);
-		graphicView->redraw();
-    }
+    commit();
 }
 
 
@@ -131,12 +177,15 @@ void RS_Selection::invertSelection() {
  */
 void RS_Selection::selectWindow(const RS_Vector& v1, const RS_Vector& v2,
                                 bool select, bool cross) {
+    begin();
 
-    container->selectWindow(v1, v2, select, cross);
-
-    if (graphicView) {
-		graphicView->redraw();
+    std::vector<RS_Entity*> windowChanged;
+    container->selectWindow(v1, v2, select, cross, &windowChanged);
+    for (RS_Entity* e: windowChanged) {
+        addChanged(e);
     }
+
+    commit();
 }
 
 
@@ -154,6 +203,8 @@ void RS_Selection::selectIntersected(const RS_Vector& v1, const RS_Vector& v2,
 	RS_Line line{v1, v2};
     bool inters;
 
+    begin();
+
 	for(auto e: *container){
     //for (unsigned i=0; i<container->count(); ++i) {
         //RS_Entity* e = container->entityAt(i);
@@ -187,19 +238,12 @@ void RS_Selection::selectIntersected(const RS_Vector& v1, const RS_Vector& v2,
             }
 
             if (inters) {
-                if (graphicView) {
-                    graphicView->deleteEntity(e);
-                }
-
-                e->setSelected(select);
-
-                if (graphicView) {
-                    graphicView->drawEntity(e);
-                }
+                setSelected(e, select);
             }
         }
     }
 
+    commit();
 }
 
 
@@ -220,71 +264,46 @@ void RS_Selection::selectContour(RS_Entity* e) {
     }
 
     bool select = !e->isSelected();
-    RS_AtomicEntity* ae = (RS_AtomicEntity*)e;
-    RS_Vector p1 = ae->getStartpoint();
-    RS_Vector p2 = ae->getEndpoint();
-    bool found = false;
-
-    // (de)select 1st entity:
-    if (graphicView) {
-        graphicView->deleteEntity(e);
-    }
-    e->setSelected(select);
-    if (graphicView) {
-        graphicView->drawEntity(e);
-    }
-
-    do {
-        found = false;
-
-		for(auto en: *container){
-        //for (unsigned i=0; i<container->count(); ++i) {
-            //RS_Entity* en = container->entityAt(i);
-
-            if (en && en->isVisible() && 
-				en->isAtomic() && en->isSelected()!=select && 
-				(!(en->getLayer() && en->getLayer()->isLocked()))) {
 
-                ae = (RS_AtomicEntity*)en;
-                bool doit = false;
+    begin();
 
-                // startpoint connects to 1st point
-                if (ae->getStartpoint().distanceTo(p1)<1.0e-4) {
-                    doit = true;
-                    p1 = ae->getEndpoint();
-                }
-
-                // endpoint connects to 1st point
-                else if (ae->getEndpoint().distanceTo(p1)<1.0e-4) {
-                    doit = true;
-                    p1 = ae->getStartpoint();
-                }
+    // (de)select 1st entity:
+    setSelected(e, select);
 
-                // startpoint connects to 2nd point
-                else if (ae->getStartpoint().distanceTo(p2)<1.0e-4) {
-                    doit = true;
-                    p2 = ae->getEndpoint();
-                }
+    // entities which can be part of the contour by their endpoints:
+    LC_ConnectivityIndex index;
+	for(auto en: *container){
+        if (en && en != e && en->isVisible() && en->isAtomic() &&
+                (!(en->getLayer() && en->getLayer()->isLocked()))) {
+            index.insert(en);
+        }
+    }
 
-                // endpoint connects to 1st point
-                else if (ae->getEndpoint().distanceTo(p2)<1.0e-4) {
-                    doit = true;
-                    p2 = ae->getStartpoint();
+    // follow the contour from both endpoints of the 1st entity:
+    for (RS_Vector p: {e->getStartpoint(), e->getEndpoint()}) {
+        for (;;) {
+            RS_Entity* next = NULL;
+            for (RS_Entity* en: index.getConnected(p)) {
+                if (en->isSelected()!=select) {
+                    next = en;
+                    break;
                 }
+            }
+            if (next==NULL) {
+                break;
+            }
 
-                if (doit) {
-                    if (graphicView) {
-                        graphicView->deleteEntity(ae);
-                    }
-                    ae->setSelected(select);
-                    if (graphicView) {
-                        graphicView->drawEntity(ae);
-                    }
-                    found = true;
-                }
+            setSelected(next, select);
+            // continue at the other endpoint
+            if (next->getStartpoint().distanceTo(p)<index.getTolerance()) {
+                p = next->getEndpoint();
+            } else {
+                p = next->getStartpoint();
             }
         }
-    } while(found);
+    }
+
+    commit();
 }
 
 
@@ -315,6 +334,7 @@ void RS_Selection::selectLayer(RS_Entity* e) {
  * Selects all entities on the given layer.
  */
 void RS_Selection::selectLayer(const QString& layerName, bool select) {
+    begin();
 
 	for(auto en: *container){
 
@@ -325,16 +345,12 @@ void RS_Selection::selectLayer(const QString& layerName, bool select) {
             RS_Layer* l = en->getLayer(true);
 
             if (l && l->getName()==layerName) {
-                if (graphicView) {
-                    graphicView->deleteEntity(en);
-                }
-                en->setSelected(select);
-                if (graphicView) {
-                    graphicView->drawEntity(en);
-                }
+                setSelected(en, select);
             }
         }
     }
+
+    commit();
 }
 
 // EOF
@@ -30,6 +30,8 @@
 #include "rs_entitycontainer.h"
 #include "rs_graphicview.h"
 
+#include <vector>
+
 
 
 /**
@@ -69,10 +71,35 @@ public:
 		selectLayer(layerName, false);
 	}
 
+    /**
+     * Starts a selection transaction. The select methods only change the
+     * selection of the entities until the outermost commit(), which redraws
+     * the graphic view and updates the selection widget once. Each select
+     * method is a transaction of its own if none was started.
+     */
+    void begin();
+    void commit();
+
 protected:
+    /** (de)selects e, a changed selection is redrawn by commit() */
+    void setSelected(RS_Entity* e, bool select);
+    /** remembers e to be redrawn by commit() */
+    void addChanged(RS_Entity* e);
+
     RS_EntityContainer* container;
     RS_Graphic* graphic;
     RS_GraphicView* graphicView;
+
+private:
+    /** nesting depth of begin() */
+    int transactions = 0;
+    /**
+     * entities whose selection changed since the outermost begin(), as
+     * long as there are few enough to redraw their areas one by one
+     */
+    std::vector<RS_Entity*> changed;
+    /** more entities changed than are kept in changed */
+    bool changedMany = false;
 };
 
 #endif
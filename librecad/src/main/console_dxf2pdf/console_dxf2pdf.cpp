@@ -76,6 +76,9 @@ int console_dxf2pdf(int argc, char* argv[])
     appDesc << "";
     appDesc << "  " + librecad + QObject::tr( " -o some.pdf *.dxf");
     appDesc << "    " + QObject::tr( "-- print all dxf files to 'some.pdf' file.");
+    appDesc << "";
+    appDesc << "  " + librecad + QObject::tr( " -j 8 *.dxf");
+    appDesc << "    " + QObject::tr( "-- print all dxf files to pdf files by 8 worker processes.");
     parser.setApplicationDescription( appDesc.join( "\n"));
 
     parser.addHelpOption();
@@ -125,6 +128,10 @@ int console_dxf2pdf(int argc, char* argv[])
         QObject::tr( "Target output directory."), "path");
     parser.addOption(outDirOpt);
 
+    QCommandLineOption jobsOpt(QStringList() << "j" << "jobs",
+        QObject::tr( "Number of worker processes printing to separate PDF files."), "N");
+    parser.addOption(jobsOpt);
+
     parser.addPositionalArgument(QObject::tr( "<dxf_files>"), QObject::tr( "Input DXF file(s)"));
 
     parser.process(app);
@@ -158,6 +165,30 @@ int console_dxf2pdf(int argc, char* argv[])
     params.outFile = parser.value(outFileOpt);
     params.outDir = parser.value(outDirOpt);
 
+    bool jobsOk;
+    int jobs = parser.value(jobsOpt).toInt(&jobsOk);
+    if (jobsOk && jobs > 0)
+        params.jobs = jobs;
+    else if (parser.isSet(jobsOpt))
+        qDebug() << "WARNING: Ignoring bad number of jobs:" << parser.value(jobsOpt);
+
+    if (params.jobs > 1 && !params.outFile.isEmpty()) {
+        qDebug() << "WARNING: Printing to one PDF file, ignoring jobs";
+        params.jobs = 1;
+    }
+
+    // The worker processes are started with the same print options.
+    const QList<QCommandLineOption> jobOpts = QList<QCommandLineOption>()
+        << fitOpt << centerOpt << grayOpt << monoOpt << pageSizeOpt << resOpt
+        << scaleOpt << marginsOpt << pagesNumOpt << outDirOpt;
+    for (auto opt : jobOpts) {
+        if (!parser.isSet(opt))
+            continue;
+        params.jobArgs << "--" + opt.names().last();
+        if (!opt.valueName().isEmpty())
+            params.jobArgs << parser.value(opt);
+    }
+
     for (auto arg : args) {
         QFileInfo dxfFileInfo(arg);
         if (dxfFileInfo.suffix().toLower() != "dxf")
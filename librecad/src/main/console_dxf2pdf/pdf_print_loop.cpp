@@ -22,6 +22,8 @@
 **
 ******************************************************************************/
 
+#include <memory>
+
 #include <QtCore>
 
 #include "rs.h"
@@ -42,6 +44,10 @@ static void drawPage(RS_Graphic*, QPrinter&, RS_PainterQt&);
 void PdfPrintLoop::run()
 {
     if (params.outFile.isEmpty()) {
+        if (params.jobs > 1 && params.dxfFiles.size() > 1) {
+            runJobs();
+            return;
+        }
         for (auto f : params.dxfFiles) {
             printOneDxfToOnePdf(f);
         }
@@ -53,6 +59,76 @@ void PdfPrintLoop::run()
 }
 
 
+void PdfPrintLoop::runJobs() {
+
+    // The graphic view used for printing is a widget, which can only be
+    // used by the main thread. Therefore the files are printed by worker
+    // processes running dxf2pdf, each of them is given small batches of
+    // files until all files are printed.
+
+    nextFile = 0;
+    batchSize = qBound(1, params.dxfFiles.size() / (params.jobs * 4), 32);
+
+    startJobs();
+
+    if (jobFiles.isEmpty())
+        emit finished();
+}
+
+
+void PdfPrintLoop::startJobs() {
+
+    QString program = QCoreApplication::applicationFilePath();
+    QStringList arguments;
+    if (QFileInfo(program).baseName() != "dxf2pdf")
+        arguments << "dxf2pdf";
+    arguments << params.jobArgs << "--";
+
+    while (jobFiles.size() < params.jobs && nextFile < params.dxfFiles.size()) {
+
+        QStringList files = params.dxfFiles.mid(nextFile, batchSize);
+        nextFile += files.size();
+
+        QProcess* job = new QProcess(this);
+        job->setProcessChannelMode(QProcess::ForwardedChannels);
+        connect(job, SIGNAL(finished(int,QProcess::ExitStatus)),
+                this, SLOT(jobFinished(int,QProcess::ExitStatus)));
+        job->start(program, arguments + files);
+
+        if (job->waitForStarted()) {
+            jobFiles.insert(job, files);
+            continue;
+        }
+
+        qDebug() << "WARNING: Failed to start a worker process:"
+                 << job->errorString();
+        delete job;
+
+        for (auto f : files) {
+            printOneDxfToOnePdf(f);
+        }
+    }
+}
+
+
+void PdfPrintLoop::jobFinished(int exitCode, QProcess::ExitStatus exitStatus)
+{
+    QProcess* job = qobject_cast<QProcess*>(sender());
+
+    if (exitStatus != QProcess::NormalExit || exitCode != 0)
+        qDebug() << "ERROR: Worker process failed to print"
+                 << jobFiles.value(job);
+
+    jobFiles.remove(job);
+    job->deleteLater();
+
+    startJobs();
+
+    if (jobFiles.isEmpty())
+        emit finished();
+}
+
+
 void PdfPrintLoop::printOneDxfToOnePdf(QString& dxfFile) {
 
     // Main code logic and flow for this method is originally stolen from
@@ -95,77 +171,55 @@ void PdfPrintLoop::printOneDxfToOnePdf(QString& dxfFile) {
 
 void PdfPrintLoop::printManyDxfToOnePdf() {
 
-    struct DxfPage {
-        RS_Document* doc;
-        RS_Graphic* graphic;
-        QString dxfFile;
-        QPrinter::PageSize paperSize;
-    };
-
     if (!params.outDir.isEmpty()) {
         QFileInfo outFileInfo(params.outFile);
         params.outFile = params.outDir + "/" + outFileInfo.fileName();
     }
 
-    QVector<DxfPage> pages;
+    // The printer and paper are set up with the data of the first opened
+    // dxf file for all pages, the printer must be set up before the
+    // painter is created. Every other dxf file is opened, printed and
+    // freed in turn, so only one of them is kept in memory.
+    QPrinter printer(QPrinter::HighResolution);
+    std::unique_ptr<RS_PainterQt> painter;
     int nrPages = 0;
 
-    // FIXME: Should probably open and print all dxf files in one 'for' loop.
-    // Tried but failed to do this. It looks like some 'chicken and egg'
-    // situation for the QPrinter and RS_PainterQt. Therefore, first open
-    // all dxf files and apply required actions. Then run another 'for'
-    // loop for actual printing.
     for (auto dxfFile : params.dxfFiles) {
 
-        DxfPage page;
-
-        page.dxfFile = dxfFile;
+        RS_Document* doc;
+        RS_Graphic* graphic;
 
-        if (!openDocAndSetGraphic(&page.doc, &page.graphic, dxfFile))
+        if (!openDocAndSetGraphic(&doc, &graphic, dxfFile))
             continue;
 
         qDebug() << "Opened" << dxfFile;
 
-        touchGraphic(page.graphic, params);
+        touchGraphic(graphic, params);
 
-        pages.append(page);
+        if (!painter) {
+            setupPrinterAndPaper(graphic, printer, params);
+            painter.reset(new RS_PainterQt(&printer));
+            if (params.monochrome)
+                painter->setDrawingMode(RS2::ModeBW);
+        }
 
+        if (nrPages > 0)
+            printer.newPage();
         nrPages++;
-    }
 
-    QPrinter printer(QPrinter::HighResolution);
-
-    if (nrPages > 0) {
-        // FIXME: Is it possible to set up printer and paper for every
-        // opened dxf file and tie them with painter? For now just using
-        // data extracted from the first opened dxf file for all pages.
-        setupPrinterAndPaper(pages.at(0).graphic, printer, params);
-    }
-
-    RS_PainterQt painter(&printer);
-
-    if (params.monochrome)
-        painter.setDrawingMode(RS2::ModeBW);
-
-    // And now it's time to actually print all previously opened dxf files.
-    for (auto page : pages) {
-        nrPages--;
-
-        qDebug() << "Printing" << page.dxfFile
+        qDebug() << "Printing" << dxfFile
                  << "to" << params.outFile << ">>>>";
 
-        drawPage(page.graphic, printer, painter);
+        drawPage(graphic, printer, *painter);
 
-        qDebug() << "Printing" << page.dxfFile
+        qDebug() << "Printing" << dxfFile
                  << "to" << params.outFile << "DONE";
 
-        delete page.doc;
-
-        if (nrPages > 0)
-            printer.newPage();
+        delete doc;
     }
 
-    painter.end();
+    if (painter)
+        painter->end();
 }
 
 
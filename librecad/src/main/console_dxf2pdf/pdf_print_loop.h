@@ -26,6 +26,7 @@
 
 #include <QtCore>
 #include <QPrinter>
+#include <QProcess>
 
 #include "rs_vector.h"
 
@@ -49,6 +50,8 @@ struct PdfPrintParams {
         } margins;           // If margin < 0.0, use value from dxf file.
         int pagesH = 0;      // If number of pages < 1,
         int pagesV = 0;      // use value from dxf file.
+        int jobs = 1;        // Number of worker processes.
+        QStringList jobArgs; // Options passed to the worker processes.
 };
 
 
@@ -71,12 +74,24 @@ signals:
 
     void finished();
 
+private slots:
+
+    void jobFinished(int exitCode, QProcess::ExitStatus exitStatus);
+
 private:
 
     PdfPrintParams params;
 
+    // Files not yet given to a worker process and the files of the
+    // running worker processes.
+    int nextFile = 0;
+    int batchSize = 1;
+    QHash<QProcess*, QStringList> jobFiles;
+
     void printOneDxfToOnePdf(QString&);
     void printManyDxfToOnePdf();
+    void runJobs();
+    void startJobs();
 };
 
 #endif
@@ -959,6 +959,66 @@ void Doc_plugin_interface::addSplinePoints(std::vector<QPointF> const& points, b
 		RS_DEBUG->print("%s: currentContainer is nullptr", __func__);
 }
 
+void Doc_plugin_interface::addPoints(const double* xy, size_t count)
+{
+    if (doc) {
+        LC_UndoSection undo(doc);
+        for (size_t i = 0; i < count; ++i, xy += 2) {
+            RS_Point* entity = new RS_Point(doc, RS_PointData(RS_Vector(xy[0], xy[1])));
+            doc->addEntity(entity);
+            undo.addUndoable(entity);
+        }
+    } else
+        RS_DEBUG->print("%s: currentContainer is nullptr", __func__);
+}
+
+void Doc_plugin_interface::addLineSegments(const double* xy, size_t count)
+{
+    if (doc) {
+        LC_UndoSection undo(doc);
+        for (size_t i = 0; i < count; ++i, xy += 4) {
+            RS_Line* entity = new RS_Line{doc, RS_Vector(xy[0], xy[1]), RS_Vector(xy[2], xy[3])};
+            doc->addEntity(entity);
+            undo.addUndoable(entity);
+        }
+    } else
+        RS_DEBUG->print("%s: currentContainer is nullptr", __func__);
+}
+
+void Doc_plugin_interface::addCircles(const double* xy, const double* radii, size_t count)
+{
+    if (doc) {
+        LC_UndoSection undo(doc);
+        for (size_t i = 0; i < count; ++i, xy += 2) {
+            RS_Circle* entity = new RS_Circle(doc, RS_CircleData(RS_Vector(xy[0], xy[1]), radii[i]));
+            doc->addEntity(entity);
+            undo.addUndoable(entity);
+        }
+    } else
+        RS_DEBUG->print("%s: currentContainer is nullptr", __func__);
+}
+
+void Doc_plugin_interface::addPolylines(const double* xy, const double* bulges,
+                                        const size_t* offsets, size_t count, bool closed)
+{
+    if (doc) {
+        RS_PolylineData data;
+        if(closed)
+            data.setFlag(RS2::FlagClosed);
+        LC_UndoSection undo(doc);
+        for (size_t i = 0; i < count; ++i) {
+            RS_Polyline* entity = new RS_Polyline(doc, data);
+            for (size_t j = offsets[i]; j < offsets[i + 1]; ++j) {
+                entity->addVertex(RS_Vector(xy[2 * j], xy[2 * j + 1]),
+                                  bulges ? bulges[j] : 0.0);
+            }
+            doc->addEntity(entity);
+            undo.addUndoable(entity);
+        }
+    } else
+        RS_DEBUG->print("%s: currentContainer is nullptr", __func__);
+}
+
 void Doc_plugin_interface::addImage(int handle, QPointF *start, QPointF *uvr, QPointF *vvr,
                                     int w, int h, QString name, int br, int con, int fade){
     if (doc) {
@@ -1266,6 +1326,174 @@ bool Doc_plugin_interface::getAllEntities(QList<Plug_Entity *> *sel, bool visibl
     return status;
 }
 
+namespace {
+//! entity type as used by plugins
+DPI::ETYPE pluginType(RS2::EntityType type)
+{
+    switch (type) {
+    case RS2::EntityLine: return DPI::LINE;
+    case RS2::EntityPoint: return DPI::POINT;
+    case RS2::EntityArc: return DPI::ARC;
+    case RS2::EntityCircle: return DPI::CIRCLE;
+    case RS2::EntityEllipse: return DPI::ELLIPSE;
+    case RS2::EntitySolid: return DPI::SOLID;
+    case RS2::EntityConstructionLine: return DPI::CONSTRUCTIONLINE;
+    case RS2::EntityImage: return DPI::IMAGE;
+    case RS2::EntityOverlayBox: return DPI::OVERLAYBOX;
+    case RS2::EntityInsert: return DPI::INSERT;
+    case RS2::EntityMText: return DPI::MTEXT;
+    case RS2::EntityText: return DPI::TEXT;
+    case RS2::EntityHatch: return DPI::HATCH;
+    case RS2::EntitySpline: return DPI::SPLINE;
+    case RS2::EntitySplinePoints: return DPI::SPLINEPOINTS;
+    case RS2::EntityPolyline: return DPI::POLYLINE;
+    case RS2::EntityDimAligned: return DPI::DIMALIGNED;
+    case RS2::EntityDimLinear: return DPI::DIMLINEAR;
+    case RS2::EntityDimRadial: return DPI::DIMRADIAL;
+    case RS2::EntityDimDiametric: return DPI::DIMDIAMETRIC;
+    case RS2::EntityDimAngular: return DPI::DIMANGULAR;
+    case RS2::EntityDimLeader: return DPI::DIMLEADER;
+    default: return DPI::UNKNOWN;
+    }
+}
+
+//! appends the vertices of Plugin_Entity::getPolylineData() to geometry
+void appendVertices(RS_Polyline* polyline, Plug_Geometry* geometry)
+{
+    RS_Entity* v = polyline->firstEntity(RS2::ResolveNone);
+    if (!v)
+        return;
+
+    double bulge = (v->rtti() == RS2::EntityArc) ? static_cast<RS_Arc*>(v)->getBulge() : 0.0;
+    RS_Vector start = static_cast<RS_AtomicEntity*>(v)->getStartpoint();
+    geometry->vertexX.push_back(start.x);
+    geometry->vertexY.push_back(start.y);
+    geometry->bulge.push_back(bulge);
+
+    RS_Entity* nextEntity = nullptr;
+    for (v = polyline->firstEntity(RS2::ResolveNone); v; v = nextEntity) {
+        nextEntity = polyline->nextEntity(RS2::ResolveNone);
+        if (!v->isAtomic())
+            continue;
+        bulge = (nextEntity && nextEntity->rtti() == RS2::EntityArc)
+                ? static_cast<RS_Arc*>(nextEntity)->getBulge() : 0.0;
+        if (!polyline->isClosed() || nextEntity) {
+            RS_Vector end = static_cast<RS_AtomicEntity*>(v)->getEndpoint();
+            geometry->vertexX.push_back(end.x);
+            geometry->vertexY.push_back(end.y);
+            geometry->bulge.push_back(bulge);
+        }
+    }
+}
+}
+
+bool Doc_plugin_interface::getAllGeometry(Plug_Geometry* geometry, bool visible){
+    if (!geometry)
+        return false;
+
+    const size_t size = geometry->type.size() + doc->count();
+    geometry->type.reserve(size);
+    geometry->id.reserve(size);
+    geometry->startX.reserve(size);
+    geometry->startY.reserve(size);
+    geometry->endX.reserve(size);
+    geometry->endY.reserve(size);
+    geometry->radius.reserve(size);
+    geometry->height.reserve(size);
+    geometry->startAngle.reserve(size);
+    geometry->endAngle.reserve(size);
+    geometry->closed.reserve(size);
+    geometry->vertexOffset.reserve(size);
+    geometry->vertexCount.reserve(size);
+
+    for(auto e: *doc){
+        if (!e->isVisible() && visible)
+            continue;
+
+        // same values as Plugin_Entity::getData()
+        RS_Vector start(0.0, 0.0);
+        RS_Vector end(0.0, 0.0);
+        double radius = 0.0;
+        double height = 0.0;
+        double startAngle = 0.0;
+        double endAngle = 0.0;
+        bool closed = false;
+        const size_t vertexOffset = geometry->vertexX.size();
+        switch (e->rtti()) {
+        case RS2::EntityLine:
+            start = e->getStartpoint();
+            end = e->getEndpoint();
+            break;
+        case RS2::EntityPoint:
+            start = static_cast<RS_Point*>(e)->getPos();
+            break;
+        case RS2::EntityArc: {
+            RS_Arc* arc = static_cast<RS_Arc*>(e);
+            start = arc->getCenter();
+            radius = arc->getRadius();
+            startAngle = arc->getAngle1();
+            endAngle = arc->getAngle2();
+            break;}
+        case RS2::EntityCircle:
+            start = e->getCenter();
+            radius = e->getRadius();
+            break;
+        case RS2::EntityEllipse: {
+            RS_Ellipse* ellipse = static_cast<RS_Ellipse*>(e);
+            start = ellipse->getCenter();
+            end = ellipse->getMajorP();
+            height = ellipse->getRatio();
+            startAngle = ellipse->getAngle1();
+            endAngle = ellipse->getAngle2();
+            break;}
+        case RS2::EntityImage: {
+            RS_Image* image = static_cast<RS_Image*>(e);
+            start = image->getInsertionPoint();
+            end = image->getUVector();
+            break;}
+        case RS2::EntityInsert: {
+            RS_Insert* insert = static_cast<RS_Insert*>(e);
+            start = insert->getInsertionPoint();
+            startAngle = insert->getAngle();
+            break;}
+        case RS2::EntityMText: {
+            RS_MText* text = static_cast<RS_MText*>(e);
+            start = text->getInsertionPoint();
+            startAngle = text->getAngle();
+            height = text->getHeight();
+            break;}
+        case RS2::EntityText: {
+            RS_Text* text = static_cast<RS_Text*>(e);
+            start = text->getInsertionPoint();
+            startAngle = text->getAngle();
+            height = text->getHeight();
+            break;}
+        case RS2::EntityPolyline: {
+            RS_Polyline* polyline = static_cast<RS_Polyline*>(e);
+            closed = polyline->isClosed();
+            appendVertices(polyline, geometry);
+            break;}
+        default:
+            break;
+        }
+
+        geometry->type.push_back(pluginType(e->rtti()));
+        geometry->id.push_back(e->getId());
+        geometry->startX.push_back(start.x);
+        geometry->startY.push_back(start.y);
+        geometry->endX.push_back(end.x);
+        geometry->endY.push_back(end.y);
+        geometry->radius.push_back(radius);
+        geometry->height.push_back(height);
+        geometry->startAngle.push_back(startAngle);
+        geometry->endAngle.push_back(endAngle);
+        geometry->closed.push_back(closed);
+        geometry->vertexOffset.push_back(vertexOffset);
+        geometry->vertexCount.push_back(geometry->vertexX.size() - vertexOffset);
+    }
+    return true;
+}
+
 bool Doc_plugin_interface::getVariableInt(const QString& key, int *num){
     if( (*num = docGr->getVariableInt(key, 0)) )
         return true;
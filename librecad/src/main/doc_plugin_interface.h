@@ -89,6 +89,11 @@ public:
     virtual void addLines(std::vector<QPointF> const& points, bool closed=false);
     virtual void addPolyline(std::vector<Plug_VertexData> const& points, bool closed=false);
     virtual void addSplinePoints(std::vector<QPointF> const& points, bool closed=false);
+    void addPoints(const double* xy, size_t count);
+    void addLineSegments(const double* xy, size_t count);
+    void addCircles(const double* xy, const double* radii, size_t count);
+    void addPolylines(const double* xy, const double* bulges,
+                      const size_t* offsets, size_t count, bool closed=false);
     void addImage(int handle, QPointF *start, QPointF *uvr, QPointF *vvr,
                   int w, int h, QString name, int br, int con, int fade);
     void addInsert(QString name, QPointF ins, QPointF scale, qreal rot);
@@ -113,6 +118,7 @@ public:
     Plug_Entity *getEnt(const QString& message);
     bool getSelect(QList<Plug_Entity *> *sel, const QString& message);
     bool getAllEntities(QList<Plug_Entity *> *sel, bool visible = false);
+    bool getAllGeometry(Plug_Geometry* geometry, bool visible = false);
 
     bool getVariableInt(const QString& key, int *num);
     bool getVariableDouble(const QString& key, double *num);
@@ -44,6 +44,7 @@
 #include "lc_application.h"
 #include "qc_applicationwindow.h"
 #include "rs_debug.h"
+#include "lc_trace.h"
 
 #include "console_dxf2pdf.h"
 
@@ -89,6 +90,7 @@ int main(int argc, char** argv)
 
     const QString lpDebugSwitch0("-d"),lpDebugSwitch1("--debug") ;
     const QString help0("-h"), help1("--help");
+    const QString traceSwitch("--trace");
     bool allowOptions=true;
     QList<int> argClean;
     for (int i=0; i<argc; i++)
@@ -112,6 +114,8 @@ int main(int argc, char** argv)
             qDebug()<<"";
             qDebug()<<"  -h, --help\tdisplay this message";
             qDebug()<<"  -d, --debug <level>";
+            qDebug()<<"  --trace <file>\twrite a trace of loading, drawing and editing in the";
+            qDebug()<<"  \t\tChrome trace event format to file on exit";
             qDebug()<<"";
             RS_DEBUG->print( RS_Debug::D_NOTHING, "possible debug levels:");
             RS_DEBUG->print( RS_Debug::D_NOTHING, "    %d Nothing", RS_Debug::D_NOTHING);
@@ -123,6 +127,24 @@ int main(int argc, char** argv)
             RS_DEBUG->print( RS_Debug::D_NOTHING, "    %d Debugging", RS_Debug::D_DEBUGGING);
             exit(0);
         }
+        if (allowOptions && traceSwitch.compare(argstr, Qt::CaseInsensitive)==0)
+        {
+            argClean<<i;
+            if (i+1 < argc)
+            {
+                ++i;
+                argClean<<i;
+#ifdef LC_NO_TRACE
+                qDebug()<<"tracing is not available in this build";
+#else
+                if (!LC_Trace::start(QString::fromLocal8Bit(argv[i])))
+                    qDebug()<<"cannot trace into"<<argv[i];
+#endif
+            }
+            else
+                qDebug()<<"--trace needs the name of the trace file";
+            continue;
+        }
         if ( allowOptions&& (argstr.startsWith(lpDebugSwitch0, Qt::CaseInsensitive) ||
                              argstr.startsWith(lpDebugSwitch1, Qt::CaseInsensitive) ))
         {
@@ -359,6 +381,8 @@ int main(int argc, char** argv)
 
     RS_DEBUG->print("main: exited Qt event loop");
 
+    LC_Trace::stop();
+
     return return_code;
 }
 
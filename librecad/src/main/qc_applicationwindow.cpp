@@ -356,6 +356,8 @@ QC_ApplicationWindow::QC_ApplicationWindow()
     if (!command_file.isEmpty())
         commandWidget->leCommand->readCommandFile(command_file);
 
+    RS_Undo::setUndoLimit(settings.value("Defaults/UndoLimit", 0).toInt());
+
     // Activate autosave timer
     if (settings.value("Defaults/AutoBackupDocument", 1).toBool())
     {
@@ -2791,6 +2793,10 @@ void QC_ApplicationWindow::slotOptionsGeneral() {
     int antialiasing = RS_SETTINGS->readNumEntry("/Antialiasing");
     RS_SETTINGS->endGroup();
 
+    RS_SETTINGS->beginGroup("/Defaults");
+    RS_Undo::setUndoLimit(RS_SETTINGS->readNumEntry("/UndoLimit", 0));
+    RS_SETTINGS->endGroup();
+
     QList<QMdiSubWindow*> windows = mdiAreaCAD->subWindowList();
     for (int i = 0; i < windows.size(); ++i) {
         QC_MDIWindow* m = qobject_cast<QC_MDIWindow*>(windows.at(i));
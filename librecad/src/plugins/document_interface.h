@@ -192,6 +192,43 @@ public:
     double bulge;
 };
 
+//! Geometry of many entities, one array per value.
+ /*!
+ *  The i-th value of the per entity arrays belongs to the i-th entity. The
+ *  values are the geometric ones of Plug_Entity::getData() for the type of
+ *  the entity, values not used by a type are 0:
+ *  startX, startY = DPI::STARTX, DPI::STARTY
+ *  endX, endY = DPI::ENDX, DPI::ENDY
+ *  radius = DPI::RADIUS
+ *  height = DPI::HEIGHT, the axis ratio of ellipses, the height of texts
+ *  startAngle, endAngle = DPI::STARTANGLE, DPI::ENDANGLE
+ *  closed = DPI::CLOSEPOLY
+ *  Attributes, texts and the other values of Plug_Entity::getData() are not
+ *  included.
+ *  The vertices of the i-th entity are the vertexCount[i] values of the
+ *  vertex arrays starting at vertexOffset[i], they are the ones of
+ *  Plug_Entity::getPolylineData(). Only polylines have vertices.
+ */
+struct Plug_Geometry
+{
+    std::vector<DPI::ETYPE> type;
+    std::vector<qulonglong> id;
+    std::vector<double> startX;
+    std::vector<double> startY;
+    std::vector<double> endX;
+    std::vector<double> endY;
+    std::vector<double> radius;
+    std::vector<double> height;
+    std::vector<double> startAngle;
+    std::vector<double> endAngle;
+    std::vector<bool> closed;
+    std::vector<size_t> vertexOffset;
+    std::vector<size_t> vertexCount;
+    std::vector<double> vertexX;
+    std::vector<double> vertexY;
+    std::vector<double> bulge;
+};
+
 //! Wrapper for access entities from plugins.
  /*!
  *  Wrapper class for create, access and modify entities from plugins.
@@ -495,6 +532,54 @@ public:
     * \return a string with the converted number.
     */
     virtual QString realToStr(const qreal num, const int units = 0, const int prec = 0) = 0;
+
+    //! Add many point entities to current document.
+    /*! Add a point entity for each coordinate pair with current attributes,
+    * all of them in one undo cycle.
+    *  \param xy x and y coordinate of each point, 2 * count values.
+    *  \param count number of points.
+    */
+    virtual void addPoints(const double* xy, size_t count) = 0;
+
+    //! Add many line entities to current document.
+    /*! Add a line entity for each pair of points with current attributes,
+    * all of them in one undo cycle.
+    *  \param xy start x, start y, end x and end y of each line, 4 * count values.
+    *  \param count number of lines.
+    */
+    virtual void addLineSegments(const double* xy, size_t count) = 0;
+
+    //! Add many circle entities to current document.
+    /*! Add a circle entity for each center with current attributes,
+    * all of them in one undo cycle.
+    *  \param xy x and y coordinate of each center, 2 * count values.
+    *  \param radii radius of each circle, count values.
+    *  \param count number of circles.
+    */
+    virtual void addCircles(const double* xy, const double* radii, size_t count) = 0;
+
+    //! Add many polyline entities to current document.
+    /*! Add a polyline entity for each vertex range with current attributes,
+    * all of them in one undo cycle.
+    *  \param xy x and y coordinate of each vertex, 2 * offsets[count] values.
+    *  \param bulges bulge of each vertex, offsets[count] values, nullptr for
+    *  straight segments only.
+    *  \param offsets index of the first vertex of each polyline, count + 1
+    *  values, the last one is the number of vertices.
+    *  \param count number of polylines.
+    *  \param closed whether the polylines are closed
+    */
+    virtual void addPolylines(const double* xy, const double* bulges,
+                              const size_t* offsets, size_t count, bool closed=false) = 0;
+
+    //! Gets the geometry of all entities in document.
+    /*! Reads the geometry without creating a Plug_Entity for each entity,
+    * the entities are appended to the arrays of geometry.
+    * \param geometry arrays to append the geometry of the entities to.
+    * \param visible default for false, do not get entities in hidden layers.
+    * \return true if success.
+    */
+    virtual bool getAllGeometry(Plug_Geometry* geometry, bool visible = false) = 0;
 };
 
 
@@ -71,7 +71,7 @@ public:
 
 };
 
-#define LC_DocumentInterface_iid "org.librecad.PluginInterface/1.0"
+#define LC_DocumentInterface_iid "org.librecad.PluginInterface/1.1"
 Q_DECLARE_INTERFACE(QC_PluginInterface, LC_DocumentInterface_iid)
 
 
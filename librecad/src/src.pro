@@ -7,6 +7,12 @@ DISABLE_POSTSCRIPT = false
 #uncomment to enable a Debugging menu entry for basic unit testing
 #DEFINES += LC_DEBUGGING
 
+# qmake CONFIG+=no_trace leaves out the trace scopes of --trace and the
+# debugging messages of hot paths
+no_trace {
+    DEFINES += LC_NO_TRACE
+}
+
 DEFINES += DWGSUPPORT
 DEFINES -= JWW_WRITE_SUPPORT
 
@@ -126,6 +132,7 @@ HEADERS += \
     lib/actions/rs_snapper.h \
     lib/creation/rs_creation.h \
     lib/debug/rs_debug.h \
+    lib/debug/lc_trace.h \
     lib/engine/rs.h \
     lib/engine/rs_arc.h \
     lib/engine/rs_atomicentity.h \
@@ -217,6 +224,11 @@ HEADERS += \
     actions/lc_actionfileexportmakercam.h \
     lib/engine/lc_rect.h \
     lib/engine/lc_undosection.h \
+    lib/engine/lc_entityindex.h \
+    lib/engine/lc_regeneration.h \
+    lib/engine/lc_connectivityindex.h \
+    lib/engine/lc_fontcache.h \
+    lib/engine/lc_hatchscanline.h \
     lib/printing/lc_printing.h \
     actions/lc_actiondrawlinepolygon3.h \
     main/lc_application.h
@@ -228,6 +240,7 @@ SOURCES += \
     lib/actions/rs_snapper.cpp \
     lib/creation/rs_creation.cpp \
     lib/debug/rs_debug.cpp \
+    lib/debug/lc_trace.cpp \
     lib/engine/rs_arc.cpp \
     lib/engine/rs_block.cpp \
     lib/engine/rs_blocklist.cpp \
@@ -245,6 +258,7 @@ SOURCES += \
     lib/engine/rs_entity.cpp \
     lib/engine/rs_entitycontainer.cpp \
     lib/engine/rs_font.cpp \
+    lib/engine/rs_fontchar.cpp \
     lib/engine/rs_fontlist.cpp \
     lib/engine/rs_graphic.cpp \
     lib/engine/rs_hatch.cpp \
@@ -307,6 +321,11 @@ SOURCES += \
     lib/engine/rs_flags.cpp \
     lib/engine/lc_rect.cpp \
     lib/engine/lc_undosection.cpp \
+    lib/engine/lc_entityindex.cpp \
+    lib/engine/lc_regeneration.cpp \
+    lib/engine/lc_connectivityindex.cpp \
+    lib/engine/lc_fontcache.cpp \
+    lib/engine/lc_hatchscanline.cpp \
     lib/engine/rs.cpp \
     lib/printing/lc_printing.cpp \
     actions/lc_actiondrawlinepolygon3.cpp \
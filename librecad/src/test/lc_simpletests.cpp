@@ -1,6 +1,13 @@
+#include <algorithm>
 #include <iostream>
 #include <cmath>
 #include <fstream>
+#include <random>
+#include <utility>
+#include <vector>
+#include <QDir>
+#include <QElapsedTimer>
+#include <QFile>
 #include <QMenuBar>
 #include "lc_simpletests.h"
 #include "qc_applicationwindow.h"
@@ -17,6 +24,8 @@
 #include "rs_dimlinear.h"
 #include "rs_dimradial.h"
 #include "rs_hatch.h"
+#include "rs_pattern.h"
+#include "rs_patternlist.h"
 #include "rs_image.h"
 #include "rs_insert.h"
 #include "rs_mtext.h"
@@ -24,6 +33,10 @@
 #include "rs_text.h"
 #include "rs_entitycontainer.h"
 #include "rs_layer.h"
+#include "rs_filterdxfrw.h"
+#include "lc_regeneration.h"
+#include "lc_fontcache.h"
+#include "rs_font.h"
 #include "rs_graphicview.h"
 #include "rs_debug.h"
 
@@ -109,6 +122,33 @@ LC_SimpleTests::LC_SimpleTests(QWidget *parent):
 		connect(action, SIGNAL(triggered()),
 				this, SLOT(slotTestResize1024()));
 		testMenu->addAction(action);
+
+		testMenu->addSeparator();
+
+		action = new QAction("Benchmark Snap", this);
+		connect(action, SIGNAL(triggered()),
+				this, SLOT(slotBenchmarkSnap()));
+		testMenu->addAction(action);
+
+		action = new QAction("Benchmark Hatch", this);
+		connect(action, SIGNAL(triggered()),
+				this, SLOT(slotBenchmarkHatch()));
+		testMenu->addAction(action);
+
+		action = new QAction("Benchmark Import", this);
+		connect(action, SIGNAL(triggered()),
+				this, SLOT(slotBenchmarkImport()));
+		testMenu->addAction(action);
+
+		action = new QAction("Benchmark Regeneration", this);
+		connect(action, SIGNAL(triggered()),
+				this, SLOT(slotBenchmarkRegeneration()));
+		testMenu->addAction(action);
+
+		action = new QAction("Benchmark Fonts", this);
+		connect(action, SIGNAL(triggered()),
+				this, SLOT(slotBenchmarkFonts()));
+		testMenu->addAction(action);
 }
 
 /**
@@ -1103,3 +1143,323 @@ void LC_SimpleTests::slotTestResize1024() {
 	QC_ApplicationWindow::getAppWindow()->update();
 	RS_DEBUG->print("%s\n: end\n", __func__);
 }
+
+/**
+ * Benchmark: snapping queries on a synthetic drawing of 1M short lines,
+ * the same queries RS_Snapper::snapPoint() runs on the document, timed
+ * with linear search and with the spatial index.
+ */
+void LC_SimpleTests::slotBenchmarkSnap() {
+	RS_DEBUG->print("%s\n: begin\n", __func__);
+	const int nLines = 1000000;
+	const int nQueries = 20;
+	const double size = 10000.;
+
+	std::mt19937 gen(1);
+	std::uniform_real_distribution<double> pos(0., size);
+	std::uniform_real_distribution<double> len(-5., 5.);
+
+	RS_EntityContainer container;
+	container.setAutoUpdateBorders(false);
+	for (int i=0; i<nLines; ++i) {
+		RS_Vector start{pos(gen), pos(gen)};
+		container.addEntity(new RS_Line{&container, start, start + RS_Vector{len(gen), len(gen)}});
+	}
+	container.setAutoUpdateBorders(true);
+	container.calculateBorders();
+
+	std::vector<RS_Vector> queries;
+	for (int i=0; i<nQueries; ++i) {
+		queries.emplace_back(pos(gen), pos(gen));
+	}
+
+	const bool enabled = RS_EntityContainer::isSpatialIndexEnabled();
+	for (bool indexed: {false, true}) {
+		RS_EntityContainer::setSpatialIndexEnabled(indexed);
+		QElapsedTimer timer;
+		timer.start();
+		double dist = 0.;
+		for (const RS_Vector& v: queries) {
+			container.getNearestEndpoint(v, &dist);
+			container.getNearestPointOnEntity(v, true, &dist);
+			container.getNearestMiddle(v, &dist);
+			container.getNearestIntersection(v, &dist);
+			container.getNearestEntity(v, &dist, RS2::ResolveAll);
+		}
+		std::cout << "Benchmark Snap: " << nLines << " lines, " << nQueries
+				  << " queries, " << (indexed ? "indexed: " : "linear: ")
+				  << timer.elapsed() << " ms" << std::endl;
+	}
+	RS_EntityContainer::setSpatialIndexEnabled(enabled);
+	RS_DEBUG->print("%s\n: end\n", __func__);
+}
+
+/**
+ * Benchmark for hatch pattern trimming: a wavy contour of 10000 edges
+ * filled with ANSI31 at the smallest scale RS_Hatch accepts for it,
+ * trimmed by cutting the pattern carpet and by the scanline engine.
+ * Reports if both give different pattern lines.
+ */
+void LC_SimpleTests::slotBenchmarkHatch() {
+	RS_DEBUG->print("%s\n: begin\n", __func__);
+	const int nEdges = 10000;
+	const double radius = 100.;
+
+	RS_Pattern* pattern = RS_PATTERNLIST->requestPattern("ANSI31");
+	if (!pattern) {
+		std::cout << "Benchmark Hatch: pattern ANSI31 not found" << std::endl;
+		return;
+	}
+	pattern->calculateBorders();
+	// about 70x70 pattern cells, RS_Hatch refuses more than 10000
+	const RS_Vector pSize = pattern->getSize();
+	const double scale = 2.*radius/70./std::max(pSize.x, pSize.y);
+
+	RS_Hatch hatch(nullptr, RS_HatchData(false, scale, 0., "ANSI31"));
+	RS_EntityContainer* loop = new RS_EntityContainer(&hatch);
+	loop->setPen(RS_Pen(RS2::FlagInvalid));
+	const RS_Vector first = RS_Vector::polar(radius, 0.);
+	RS_Vector previous = first;
+	for (int i=1; i<=nEdges; ++i) {
+		const double a = 2.*M_PI*i/nEdges;
+		const RS_Vector v = (i == nEdges) ? first
+							: RS_Vector::polar(radius*(1. + 0.05*std::sin(50.*a)), a);
+		loop->addEntity(new RS_Line{loop, previous, v});
+		previous = v;
+	}
+	hatch.addEntity(loop);
+
+	// the trimmed pattern lines, each from its left end and sorted by it
+	using Segment = std::pair<RS_Vector, RS_Vector>;
+	auto patternLines = [&hatch]() {
+		std::vector<Segment> lines;
+		for (RS_Entity* e: hatch) {
+			if (!e->isContainer() || !e->getFlag(RS2::FlagTemp)) {
+				continue;
+			}
+			for (RS_Entity* l: *static_cast<RS_EntityContainer*>(e)) {
+				if (l->rtti() != RS2::EntityLine) {
+					continue;
+				}
+				RS_Vector v1 = l->getStartpoint();
+				RS_Vector v2 = l->getEndpoint();
+				if (v2.x < v1.x || (v2.x == v1.x && v2.y < v1.y)) {
+					std::swap(v1, v2);
+				}
+				lines.emplace_back(v1, v2);
+			}
+		}
+		std::sort(lines.begin(), lines.end(), [](const Segment& a, const Segment& b) {
+			return a.first.x < b.first.x;
+		});
+		return lines;
+	};
+
+	std::vector<Segment> results[2];
+	const bool enabled = RS_Hatch::isScanlineEnabled();
+	for (bool scanline: {false, true}) {
+		RS_Hatch::setScanlineEnabled(scanline);
+		QElapsedTimer timer;
+		timer.start();
+		hatch.update();
+		const qint64 elapsed = timer.elapsed();
+		results[scanline] = patternLines();
+		std::cout << "Benchmark Hatch: " << nEdges << " edges, "
+				  << results[scanline].size() << " pattern lines, "
+				  << (scanline ? "scanline: " : "carpet: ")
+				  << elapsed << " ms" << std::endl;
+	}
+	RS_Hatch::setScanlineEnabled(enabled);
+
+	// both ways of trimming must give the same lines
+	const double tolerance = 1e-8*radius;
+	auto unmatched = [tolerance](const std::vector<Segment>& lines,
+			const std::vector<Segment>& others) {
+		size_t count = 0;
+		for (const Segment& l: lines) {
+			auto it = std::lower_bound(others.begin(), others.end(), l.first.x - tolerance,
+									   [](const Segment& o, double x) {
+				return o.first.x < x;
+			});
+			bool found = false;
+			for (; it != others.end() && it->first.x <= l.first.x + tolerance; ++it) {
+				if (it->first.distanceTo(l.first) <= tolerance
+						&& it->second.distanceTo(l.second) <= tolerance) {
+					found = true;
+					break;
+				}
+			}
+			if (!found) {
+				++count;
+			}
+		}
+		return count;
+	};
+	const size_t onlyCarpet = unmatched(results[0], results[1]);
+	const size_t onlyScanline = unmatched(results[1], results[0]);
+	if (onlyCarpet == 0 && onlyScanline == 0) {
+		std::cout << "Benchmark Hatch: pattern lines match within "
+				  << tolerance << std::endl;
+	} else {
+		std::cout << "Benchmark Hatch: MISMATCH, " << onlyCarpet
+				  << " carpet lines and " << onlyScanline
+				  << " scanline lines without a match within "
+				  << tolerance << std::endl;
+	}
+	RS_DEBUG->print("%s\n: end\n", __func__);
+}
+
+void LC_SimpleTests::slotBenchmarkImport() {
+	RS_DEBUG->print("%s\n: begin\n", __func__);
+	const int nLayers = 300;
+	const int nEntities = 200000;
+	const QString file = QDir::temp().filePath("lc_benchmark_import.dxf");
+
+	{
+		RS_Graphic graphic;
+		std::vector<RS_Layer*> layers;
+		for (int i=0; i<nLayers; ++i) {
+			layers.push_back(new RS_Layer(QString("layer %1").arg(i)));
+			graphic.addLayer(layers.back());
+		}
+		const RS2::LineType lineTypes[] = {RS2::LineByLayer, RS2::SolidLine,
+										   RS2::DashLine, RS2::DotLine};
+		std::mt19937 gen(1);
+		std::uniform_real_distribution<double> coord(0., 1000.);
+		for (int i=0; i<nEntities; ++i) {
+			const RS_Vector p(coord(gen), coord(gen));
+			RS_Line* line = new RS_Line{&graphic, p, p + RS_Vector(coord(gen), coord(gen))*0.01};
+			line->setLayer(layers[i % nLayers]);
+			line->setPen(RS_Pen(RS_Color(RS2::FlagByLayer), RS2::WidthByLayer,
+								lineTypes[i % 4]));
+			graphic.addEntity(line);
+		}
+		RS_FilterDXFRW filter;
+		if (!filter.fileExport(graphic, file, RS2::FormatDXFRW)) {
+			std::cout << "Benchmark Import: cannot write " << file.toStdString() << std::endl;
+			return;
+		}
+	}
+
+	const bool enabled = RS_FilterDXFRW::isAttributeCacheEnabled();
+	for (bool cache: {false, true}) {
+		RS_FilterDXFRW::setAttributeCacheEnabled(cache);
+		RS_Graphic graphic;
+		RS_FilterDXFRW filter;
+		QElapsedTimer timer;
+		timer.start();
+		filter.fileImport(graphic, file, RS2::FormatDXFRW);
+		const qint64 elapsed = timer.elapsed();
+		std::cout << "Benchmark Import: " << graphic.count() << " entities, "
+				  << graphic.getLayerList()->count() << " layers, "
+				  << (cache ? "attribute cache: " : "no cache: ")
+				  << elapsed << " ms" << std::endl;
+	}
+	RS_FilterDXFRW::setAttributeCacheEnabled(enabled);
+	QFile::remove(file);
+	RS_DEBUG->print("%s\n: end\n", __func__);
+}
+
+/**
+ * Benchmark for loading a drawing: 100 blocks, each inserting the one
+ * before and holding a text, and 50000 texts and 50000 inserts in the
+ * drawing.
+ */
+void LC_SimpleTests::slotBenchmarkRegeneration() {
+	RS_DEBUG->print("%s\n: begin\n", __func__);
+	const int nBlocks = 100;
+	const int nEntities = 50000;
+	const QString file = QDir::temp().filePath("lc_benchmark_regeneration.dxf");
+
+	{
+		RS_Graphic graphic;
+		std::mt19937 gen(1);
+		std::uniform_real_distribution<double> coord(0., 1000.);
+		auto text = [&gen, &coord](RS_EntityContainer* parent, const QString& s) {
+			return new RS_Text(parent, RS_TextData(RS_Vector(coord(gen), coord(gen)),
+												   RS_Vector(false), 2.5, 1.,
+												   RS_TextData::VABaseline, RS_TextData::HALeft,
+												   RS_TextData::None, s, "standard", 0.,
+												   RS2::Update));
+		};
+		auto insert = [&gen, &coord](RS_EntityContainer* parent, int block) {
+			return new RS_Insert(parent, RS_InsertData(QString("block %1").arg(block),
+													   RS_Vector(coord(gen), coord(gen)),
+													   RS_Vector(1., 1.), 0., 1, 1,
+													   RS_Vector(0., 0.), nullptr,
+													   RS2::Update));
+		};
+		for (int i=0; i<nBlocks; ++i) {
+			RS_Block* block = new RS_Block(&graphic, RS_BlockData(QString("block %1").arg(i),
+																  RS_Vector(0., 0.), false));
+			graphic.addBlock(block);
+			for (int j=0; j<10; ++j) {
+				const RS_Vector p(coord(gen), coord(gen));
+				block->addEntity(new RS_Line{block, p, p + RS_Vector(coord(gen), coord(gen))*0.01});
+			}
+			block->addEntity(text(block, QString("Block %1").arg(i)));
+			if (i > 0) {
+				block->addEntity(insert(block, i - 1));
+			}
+		}
+		for (int i=0; i<nEntities; ++i) {
+			graphic.addEntity(text(&graphic, QString("Text %1").arg(i)));
+			graphic.addEntity(insert(&graphic, i % nBlocks));
+		}
+		RS_FilterDXFRW filter;
+		if (!filter.fileExport(graphic, file, RS2::FormatDXFRW)) {
+			std::cout << "Benchmark Regeneration: cannot write " << file.toStdString() << std::endl;
+			return;
+		}
+	}
+
+	const bool enabled = LC_Regeneration::isEnabled();
+	for (bool regeneration: {false, true}) {
+		LC_Regeneration::setEnabled(regeneration);
+		RS_Graphic graphic;
+		RS_FilterDXFRW filter;
+		QElapsedTimer timer;
+		timer.start();
+		filter.fileImport(graphic, file, RS2::FormatDXFRW);
+		const qint64 elapsed = timer.elapsed();
+		std::cout << "Benchmark Regeneration: " << graphic.count() << " entities, "
+				  << graphic.getBlockList()->count() << " blocks, "
+				  << (regeneration ? "regeneration threads: " : "serial: ")
+				  << elapsed << " ms" << std::endl;
+	}
+	LC_Regeneration::setEnabled(enabled);
+	QFile::remove(file);
+	RS_DEBUG->print("%s\n: end\n", __func__);
+}
+
+/**
+ * Benchmark for loading the unicode font and generating 2000 CJK letters,
+ * parsed from the font file and twice with the glyph cache. The first run
+ * with the cache writes it, unless it is up to date already.
+ */
+void LC_SimpleTests::slotBenchmarkFonts() {
+	RS_DEBUG->print("%s\n: begin\n", __func__);
+	const int nLetters = 2000;
+
+	const bool enabled = LC_FontCache::isEnabled();
+	const char* const runs[] = {"parsed: ", "cache 1st: ", "cache 2nd: "};
+	for (int run = 0; run < 3; ++run) {
+		LC_FontCache::setEnabled(run > 0);
+		QElapsedTimer timer;
+		timer.start();
+		RS_Font font("unicode");
+		if (!font.loadFont()) {
+			std::cout << "Benchmark Fonts: font unicode not found" << std::endl;
+			break;
+		}
+		const qint64 loaded = timer.elapsed();
+		for (int i = 0; i < nLetters; ++i) {
+			font.findLetter(QChar(0x4e00 + i));
+		}
+		std::cout << "Benchmark Fonts: " << font.countLetters() << " letters, "
+				  << runs[run] << loaded << " ms load, "
+				  << timer.elapsed() << " ms total" << std::endl;
+	}
+	LC_FontCache::setEnabled(enabled);
+	RS_DEBUG->print("%s\n: end\n", __func__);
+}
@@ -42,5 +42,15 @@ public slots:
 	void slotTestResize800();
 	/** resizes window to 640x480 for screen shots */
 	void slotTestResize1024();
+	/** times snapping queries on a synthetic drawing with and without index */
+	void slotBenchmarkSnap();
+	/** times hatching a large contour with and without the scanline engine */
+	void slotBenchmarkHatch();
+	/** times importing a large DXF file with and without the attribute cache */
+	void slotBenchmarkImport();
+	/** times loading texts and nested inserts with and without the regeneration threads */
+	void slotBenchmarkRegeneration();
+	/** times loading a large font from its file and from the glyph cache */
+	void slotBenchmarkFonts();
 };
 #endif // LC_SIMPLETESTS_H
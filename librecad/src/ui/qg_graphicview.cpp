@@ -24,8 +24,11 @@
 **
 **********************************************************************/
 
+#include <cmath>
+
 #include "qg_graphicview.h"
 
+#include <QElapsedTimer>
 #include <QGridLayout>
 #include <QLabel>
 #include <QMenu>
@@ -50,6 +53,8 @@
 #include "rs_modification.h"
 #include "rs_debug.h"
 #include "rs_graphic.h"
+#include "rs_units.h"
+#include "lc_trace.h"
 
 #ifdef Q_OS_WIN32
 #define CURSOR_SIZE 16
@@ -243,6 +248,42 @@ void QG_GraphicView::redraw(RS2::RedrawMethod method) {
 }
 
 
+/**
+ * Invalidates the given area of the cached drawing. Only the invalidated
+ * areas are cleared and drawn again on the next paint event, unless
+ * the whole drawing is redrawn anyway.
+ */
+void QG_GraphicView::redrawArea(const RS_Vector& v1, const RS_Vector& v2) {
+    if ((redrawMethod & RS2::RedrawDrawing) || isPrintPreview()
+            || !(v1.valid && v2.valid)) {
+        redraw(RS2::RedrawDrawing);
+        return;
+    }
+
+    // the widest line exceeds the bounding box by half its width
+    double unitFactor = 1.;
+    RS_Graphic* graphic = container->getGraphic();
+    if (graphic) {
+        unitFactor = RS_Units::convert(1.0, RS2::Millimeter, graphic->getUnit());
+    }
+    const double margin = std::ceil(toGuiDX(RS2::Width23 / 100. * unitFactor) / 2.) + 2.;
+
+    const QRectF view(rect());
+    QRectF area = QRectF(QPointF(toGuiX(v1.x), toGuiY(v1.y)),
+                         QPointF(toGuiX(v2.x), toGuiY(v2.y))).normalized();
+    area.adjust(-margin, -margin, margin, margin);
+    if (!area.intersects(view)) {
+        return;
+    }
+    dirtyDrawing += area.intersected(view).toAlignedRect();
+    // many small areas are merged, keeping the region cheap to update
+    if (dirtyDrawing.rectCount() > 64) {
+        dirtyDrawing = dirtyDrawing.boundingRect();
+    }
+    update();
+}
+
+
 void QG_GraphicView::resizeEvent(QResizeEvent* /*e*/) {
     RS_DEBUG->print("QG_GraphicView::resizeEvent begin");
     adjustOffsetControls();
@@ -949,6 +990,7 @@ void QG_GraphicView::layerActivated(RS_Layer *layer) {
  */
 void QG_GraphicView::paintEvent(QPaintEvent *)
 {
+    LC_TRACE_SCOPE("redraw", "QG_GraphicView::paintEvent");
 
     // Re-Create or get the layering pixmaps
     getPixmapForView(PixmapLayer1);
@@ -964,13 +1006,31 @@ void QG_GraphicView::paintEvent(QPaintEvent *)
         painter1.end();
     }
 
-    if (redrawMethod & RS2::RedrawDrawing)
+    if ((redrawMethod & RS2::RedrawDrawing) || !dirtyDrawing.isEmpty())
     {
+        QElapsedTimer timer;
+        timer.start();
+        drawnEntities = 0;
+        // the whole drawing is redrawn on view changes, otherwise only
+        // the invalidated areas
+        const bool partial = !(redrawMethod & RS2::RedrawDrawing);
+
         view_rect = LC_Rect(toGraph(0, 0),
                             toGraph(getWidth(), getHeight()));
         // DRaw layer 2
-        PixmapLayer2->fill(Qt::transparent);
+        if (!partial)
+        {
+            PixmapLayer2->fill(Qt::transparent);
+        }
         RS_PainterQt painter2(PixmapLayer2.get());
+        if (partial)
+        {
+            drawingRect = dirtyDrawing.boundingRect();
+            painter2.setClipRegion(dirtyDrawing);
+            painter2.setCompositionMode(QPainter::CompositionMode_Source);
+            painter2.fillRect(drawingRect, Qt::transparent);
+            painter2.setCompositionMode(QPainter::CompositionMode_SourceOver);
+        }
         if (antialiasing)
         {
             painter2.setRenderHint(QPainter::Antialiasing);
@@ -981,6 +1041,13 @@ void QG_GraphicView::paintEvent(QPaintEvent *)
         painter2.setDrawSelectedOnly(true);
         drawLayer2((RS_Painter*)&painter2);
         painter2.end();
+        drawingRect = QRect();
+        dirtyDrawing = QRegion();
+
+        RS_DEBUG->print(RS_Debug::D_INFORMATIONAL,
+                        "QG_GraphicView::paintEvent: %u entities drawn in %lld ms%s",
+                        drawnEntities, static_cast<long long>(timer.elapsed()),
+                        partial ? " (partial)" : "");
     }
 
     if (redrawMethod & RS2::RedrawOverlay)
@@ -27,6 +27,7 @@
 #ifndef QG_GRAPHICVIEW_H
 #define QG_GRAPHICVIEW_H
 
+#include <QRegion>
 #include <QWidget>
 
 #include "rs_graphicview.h"
@@ -59,6 +60,7 @@ public:
 	int getWidth() const override;
 	int getHeight() const override;
 	void redraw(RS2::RedrawMethod method=RS2::RedrawAll) override;
+	void redrawArea(const RS_Vector& v1, const RS_Vector& v2) override;
 	void adjustOffsetControls() override;
 	void adjustZoomControls() override;
 	void setBackground(const RS_Color& bg) override;
@@ -152,6 +154,8 @@ protected:
     std::unique_ptr<QPixmap> PixmapLayer3;  // Used for crosshair and actionitems
 	
 	RS2::RedrawMethod redrawMethod;
+	//! parts of PixmapLayer2 to redraw when the whole drawing is not redrawn
+	QRegion dirtyDrawing;
 		
     //! Keep tracks of if we are currently doing a high-resolution scrolling
     bool isSmoothScrolling;
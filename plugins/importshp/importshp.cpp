@@ -16,6 +16,9 @@
 #include <QFileDialog>
 #include <QSettings>
 #include <QMessageBox>
+#include <QProgressDialog>
+#include <QDoubleValidator>
+#include <QLocale>
 
 #include "importshp.h"
 
@@ -137,6 +140,18 @@ dibSHP::dibSHP(QWidget *parent) :  QDialog(parent)
     pointbox->setLayout(pointlayout);
     mainLayout->addWidget(pointbox);
 
+    QGroupBox *simplifybox = new QGroupBox(tr("Simplify"));
+    QLabel *tolerancelabel = new QLabel(tr("Tolerance:"));
+    toleranceedit = new QLineEdit();
+    toleranceedit->setValidator(new QDoubleValidator(0.0, 1.0e10, 10, toleranceedit));
+    toleranceedit->setToolTip(tr("Vertices of lines and polygons closer than the tolerance to the simplified shape are removed, 0 keeps all vertices."));
+    QHBoxLayout *simplifylayout = new QHBoxLayout;
+    simplifylayout->addWidget(tolerancelabel);
+    simplifylayout->addWidget(toleranceedit);
+    simplifylayout->addStretch(1);
+    simplifybox->setLayout(simplifylayout);
+    mainLayout->addWidget(simplifybox);
+
     QHBoxLayout *loaccept = new QHBoxLayout;
     QPushButton *acceptbut = new QPushButton(tr("Accept"));
     QPushButton *cancelbut = new QPushButton(tr("Cancel"));
@@ -269,6 +284,73 @@ void dibSHP::updateFile()
     }
 }
 
+namespace {
+//! records read between updates of the progress and between added batches
+const int chunkSize = 4096;
+
+/*! Simplifies a line of count vertices by the Douglas-Peucker algorithm,
+ * the vertices farther than tolerance from the simplified line are kept.
+ * \param xy gets the x and y coordinates of the kept vertices appended.
+ * \return number of kept vertices.
+ */
+size_t simplify(const double* x, const double* y, int count, double tolerance,
+                std::vector<double>& xy)
+{
+    if (count <= 0)
+        return 0;
+    const bool keepAll = tolerance <= 0.0 || count <= 2;
+    std::vector<char> keep(count, keepAll);
+    keep.front() = keep.back() = 1;
+
+    const double tolerance2 = tolerance * tolerance;
+    std::vector<std::pair<int, int>> ranges;
+    if (!keepAll)
+        ranges.emplace_back(0, count - 1);
+    while (!ranges.empty()) {
+        const int first = ranges.back().first;
+        const int last = ranges.back().second;
+        ranges.pop_back();
+
+        const double dx = x[last] - x[first];
+        const double dy = y[last] - y[first];
+        const double length2 = dx * dx + dy * dy;
+        int farthest = -1;
+        double farthest2 = tolerance2;
+        for (int i = first + 1; i < last; ++i) {
+            const double px = x[i] - x[first];
+            const double py = y[i] - y[first];
+            double distance2;
+            if (length2 > 0.0) {
+                const double cross = px * dy - py * dx;
+                distance2 = cross * cross / length2;
+            } else {
+                // closed rings start and end at the same vertex
+                distance2 = px * px + py * py;
+            }
+            if (distance2 > farthest2) {
+                farthest2 = distance2;
+                farthest = i;
+            }
+        }
+        if (farthest >= 0) {
+            keep[farthest] = 1;
+            ranges.emplace_back(first, farthest);
+            ranges.emplace_back(farthest, last);
+        }
+    }
+
+    size_t kept = 0;
+    for (int i = 0; i < count; ++i) {
+        if (keep[i]) {
+            xy.push_back(x[i]);
+            xy.push_back(y[i]);
+            ++kept;
+        }
+    }
+    return kept;
+}
+}
+
 void dibSHP::procesFile(Document_Interface *doc)
 {
     int num_ent, st;
@@ -290,6 +372,10 @@ void dibSHP::procesFile(Document_Interface *doc)
     QString file = fi.canonicalFilePath ();
 
     SHPHandle sh = SHPOpen( file.toLocal8Bit(), "rb" );
+    if (!sh) {
+        QMessageBox::critical ( this, "Shapefile", QString(tr("The file %1 can not be read")).arg(fileedit->text()) );
+        return;
+    }
     SHPGetInfo( sh, &num_ent, &st, min_bound, max_bound );
     DBFHandle dh = DBFOpen( file.toLocal8Bit(), "rb" );
 
@@ -325,8 +411,28 @@ void dibSHP::procesFile(Document_Interface *doc)
         pointT = DBFGetFieldInfo( dh, pointF, NULL, NULL, NULL );
     }
 
+    tolerance = qMax(0.0, QLocale().toDouble(toleranceedit->text()));
+    points.clear();
+    polylineXY.clear();
+    polylineOffsets.assign(1, 0);
+
+    // records are read one at a time, the entities are added in one batch
+    // per chunk of records or per run of records on the same layer, and the
+    // progress is updated once per chunk
+    QProgressDialog progress(tr("Importing %1").arg(fi.fileName()), tr("Cancel"),
+                             0, num_ent, parentWidget());
+    progress.setWindowModality(Qt::WindowModal);
+    progress.setMinimumDuration(500);
+
     currlayer =currDoc->getCurrentLayer();
     for( int i = 0; i < num_ent; i++ ) {
+        if (i % chunkSize == 0) {
+            flushPoints();
+            flushPolylines();
+            progress.setValue(i);
+            if (progress.wasCanceled())
+                break;
+        }
         sobject= NULL;
         sobject = SHPReadObject( sh, i );
         if (sobject) {
@@ -360,6 +466,9 @@ void dibSHP::procesFile(Document_Interface *doc)
             SHPDestroyObject(sobject);
         }
     }
+    flushPoints();
+    flushPolylines();
+    progress.setValue(num_ent);
 
     SHPClose( sh );
     DBFClose( dh );
@@ -367,16 +476,21 @@ void dibSHP::procesFile(Document_Interface *doc)
 }
 
 void dibSHP::readPoint(DBFHandle dh, int i){
-    Plug_Entity *ent =NULL;
-    QHash<int, QVariant> data;
     if (pointF < 0) {
-        ent = currDoc->newEntity(DPI::POINT);
-        ent->getData(&data);
-    } else {
-        ent = currDoc->newEntity(DPI::MTEXT);
-        ent->getData(&data);
-        data.insert(DPI::TEXTCONTENT, DBFReadStringAttribute( dh, i, pointF ) );
+        readBatchLayer(dh, i);
+        flushPolylines();
+        points.push_back(*(sobject->padfX));
+        points.push_back(*(sobject->padfY));
+        return;
     }
+
+    flushPoints();
+    flushPolylines();
+
+    Plug_Entity *ent = currDoc->newEntity(DPI::MTEXT);
+    QHash<int, QVariant> data;
+    ent->getData(&data);
+    data.insert(DPI::TEXTCONTENT, DBFReadStringAttribute( dh, i, pointF ) );
     data.insert(DPI::STARTX, *(sobject->padfX));
     data.insert(DPI::STARTY, *(sobject->padfY));
     readAttributes(dh, i);
@@ -385,26 +499,50 @@ void dibSHP::readPoint(DBFHandle dh, int i){
     currDoc->addEntity(ent);
 }
 
+void dibSHP::flushPoints(){
+    if (!points.empty()) {
+        currDoc->addPoints(points.data(), points.size() / 2);
+        points.clear();
+    }
+}
+
+void dibSHP::flushPolylines(){
+    if (polylineOffsets.size() > 1) {
+        currDoc->addPolylines(polylineXY.data(), nullptr, polylineOffsets.data(),
+                              polylineOffsets.size() - 1);
+        polylineXY.clear();
+        polylineOffsets.assign(1, 0);
+    }
+}
+
+void dibSHP::readBatchLayer(DBFHandle dh, int i){
+    if (layerF < 0)
+        return;
+    // a batch is added to the layer of its entities
+    QString layer = DBFReadStringAttribute( dh, i, layerF );
+    if (layer != attdata.layer || (points.empty() && polylineOffsets.size() == 1)) {
+        flushPoints();
+        flushPolylines();
+        attdata.layer = layer;
+        currDoc->setLayer(layer);
+    }
+}
+
 void dibSHP::readPolyline(DBFHandle dh, int i){
     int maxPoints;
-    Plug_Entity *ent =NULL;
-    QHash<int, QVariant> data;
-    QList<Plug_VertexData> vl;
 
-    readAttributes(dh, i);
-    data.insert(DPI::LAYER, attdata.layer);
+    readBatchLayer(dh, i);
+    flushPoints();
     for( int i = 0; i < sobject->nParts; i++ ) {
         if ( (i+1) < sobject->nParts) maxPoints = sobject->panPartStart[i+1];
         else maxPoints = sobject->nVertices;
-        vl.clear();
-        for( int j = sobject->panPartStart[i]; j < maxPoints; j++ ) {
-            vl.append( Plug_VertexData( QPointF(sobject->padfX[j],sobject->padfY[j]), 0.0) );
-        }
-        if (vl.size() > 2 ) {
-            ent = currDoc->newEntity(DPI::POLYLINE);
-            ent->updateData(&data);
-            currDoc->addEntity(ent);
-            ent->updatePolylineData(&vl);
+        const int first = sobject->panPartStart[i];
+        const size_t kept = simplify(sobject->padfX + first, sobject->padfY + first,
+                                     maxPoints - first, tolerance, polylineXY);
+        if (kept > 2) {
+            polylineOffsets.push_back(polylineXY.size() / 2);
+        } else {
+            polylineXY.resize(2 * polylineOffsets.back());
         }
     }
 }
@@ -442,6 +580,7 @@ void dibSHP::readSettings()
     QSize size = settings.value("size", QSize(325,425)).toSize();
     str = settings.value("lastfile").toString();
     fileedit->setText(str);
+    toleranceedit->setText(settings.value("tolerance", "0").toString());
     resize(size);
     move(pos);
  }
@@ -452,4 +591,5 @@ void dibSHP::writeSettings()
     settings.setValue("pos", pos());
     settings.setValue("size", size());
     settings.setValue("lastfile", fileedit->text());
+    settings.setValue("tolerance", toleranceedit->text());
  }
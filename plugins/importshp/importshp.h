@@ -19,6 +19,7 @@
 #include <QComboBox>
 #include <QDialog>
 #include <QRadioButton>
+#include <vector>
 #include "qc_plugininterface.h"
 #include "document_interface.h"
 #include "shapefil.h"
@@ -84,6 +85,9 @@ private:
     void readMultiPolyline(DBFHandle dh, int i);
 //    void readText(SHPHandle sh, DBFHandle dh, int i, Plug_Entity *ent);
     void readAttributes(DBFHandle dh, int i);
+    void readBatchLayer(DBFHandle dh, int i);
+    void flushPoints();
+    void flushPolylines();
 
 private:
     QLineEdit *fileedit;
@@ -99,12 +103,20 @@ private:
     QRadioButton *radiolwidth1;
     QRadioButton *radiopoint1;
     QLabel *formattype;
+    QLineEdit *toleranceedit;
 
     int layerF, colorF, ltypeF, lwidthF, pointF;
     int layerT, colorT, ltypeT, lwidthT, pointT;
     AttribData attdata;
     SHPObject *sobject;
     QString currlayer;
+    double tolerance;
+    //! coordinates of points not yet added, all in the layer attdata.layer
+    std::vector<double> points;
+    //! coordinates of the vertices of polylines not yet added, all in the layer attdata.layer
+    std::vector<double> polylineXY;
+    //! index of the first vertex of each polyline not yet added, and the number of vertices
+    std::vector<size_t> polylineOffsets;
 
     Document_Interface *currDoc;
 
@@ -1,6 +1,11 @@
 //This plugin allows the user to plot mathematical equations.
 //It uses muParser for parsing the mathematical equations.
 //
+//The equations are evaluated in bulk on worker threads, either at every
+//step or adaptively where the curve bends or jumps, with as many points.
+//Only adaptive sampling splits the curve at jumps and poles, both split it
+//at non-finite values.
+//
 //ToDo: *set max and min value for step size?
 
 
@@ -10,6 +15,13 @@
 #include "plotdialog.h"
 #include <muParser.h>
 #include <QDebug>
+#include <algorithm>
+#include <cmath>
+#include <exception>
+#include <limits>
+#include <thread>
+#include <utility>
+#include <vector>
 
 mu::string_type toMUPString(const QString &str)
 {
@@ -38,6 +50,280 @@ PluginCapabilities plot::getCapabilities() const
     return pluginCapabilities;
 }
 
+namespace {
+//! values evaluated by a worker thread at least
+const size_t minValuesPerThread = 4096;
+//! smallest interval between samples relative to the range of the parameter
+const double minRelativeStep = 1.0e-9;
+
+void setupParser(mu::Parser& p, double* variable)
+{
+    p.DefineConst(_T("pi"),M_PI);
+    p.DefineConst(_T("e"),M_E);
+    p.DefineVar(_T("x"), variable);
+    p.DefineVar(_T("t"), variable);
+}
+
+/*! Evaluates equation for all parameters with the bulk mode of muParser,
+ * large arrays are split between worker threads with a parser each.
+ */
+void evaluateBulk(const mu::string_type& equation, std::vector<double>& parameters,
+                  std::vector<double>& values)
+{
+    values.resize(parameters.size());
+    if (parameters.empty())
+        return;
+
+    const size_t threads = std::max<size_t>(1, std::min<size_t>(
+        std::thread::hardware_concurrency(), parameters.size() / minValuesPerThread));
+    const size_t chunk = (parameters.size() + threads - 1) / threads;
+    std::vector<std::exception_ptr> errors(threads);
+    auto worker = [&](size_t thread) {
+        try {
+            const size_t first = thread * chunk;
+            const size_t count = std::min(chunk, parameters.size() - first);
+            mu::Parser p;
+            setupParser(p, &parameters[first]);
+            p.SetExpr(equation);
+            p.Eval(&values[first], static_cast<int>(count));
+        } catch (...) {
+            errors[thread] = std::current_exception();
+        }
+    };
+
+    std::vector<std::thread> pool;
+    for (size_t thread = 1; thread < threads; ++thread)
+        pool.emplace_back(worker, thread);
+    worker(0);
+    for (auto& t: pool)
+        t.join();
+    for (auto const& error: errors) {
+        if (error)
+            std::rethrow_exception(error);
+    }
+}
+
+//! Points of a curve, given by y(x) or by the parametric form x(t), y(t)
+struct Curve {
+    mu::string_type equation1;
+    mu::string_type equation2;
+    std::vector<double> t;
+    std::vector<double> x;
+    std::vector<double> y;
+    //! true, if the curve is discontinuous between sample i and i + 1
+    std::vector<char> breaks;
+
+    void evaluate(std::vector<double>& parameters,
+                  std::vector<double>& px, std::vector<double>& py) const
+    {
+        if (equation2.empty()) {
+            px = parameters;
+            evaluateBulk(equation1, parameters, py);
+        } else {
+            evaluateBulk(equation1, parameters, px);
+            evaluateBulk(equation2, parameters, py);
+        }
+    }
+
+    /*! Samples the curve at count evenly spaced parameters. Without
+     * midpoints jumps and poles are not detected, the curve is only split
+     * at non-finite values.
+     */
+    void sampleUniform(double start, double end, size_t count)
+    {
+        t.resize(count);
+        for (size_t i = 0; i < count; ++i)
+            t[i] = (count > 1) ? start + (end - start) * i / (count - 1) : start;
+        evaluate(t, x, y);
+        breaks.assign(count, 0);
+    }
+
+    /*! Samples the curve with at most budget points. Starting with evenly
+     * spaced samples, the intervals whose midpoint deviates most from the
+     * chord are bisected in rounds until the budget is used or the curve is
+     * approximated closely. Each round bisects the worst intervals for a
+     * quarter of the remaining budget and evaluates the midpoints of the new
+     * intervals in bulk. Intervals which do not converge down to the
+     * smallest step are discontinuities, as are the intervals left when
+     * the budget runs out whose midpoint shows a jump or a pole.
+     */
+    void sampleAdaptive(double start, double end, size_t budget)
+    {
+        sampleUniform(start, end, std::max<size_t>(2, std::min<size_t>(budget, budget / 4 + 1)));
+        if (t.size() >= budget)
+            return;
+
+        // deviations below this are invisible on any reasonable zoom
+        double minX = 0.0, maxX = 0.0, minY = 0.0, maxY = 0.0;
+        bool first = true;
+        for (size_t i = 0; i < t.size(); ++i) {
+            if (!std::isfinite(x[i]) || !std::isfinite(y[i]))
+                continue;
+            minX = first ? x[i] : std::min(minX, x[i]);
+            maxX = first ? x[i] : std::max(maxX, x[i]);
+            minY = first ? y[i] : std::min(minY, y[i]);
+            maxY = first ? y[i] : std::max(maxY, y[i]);
+            first = false;
+        }
+        const double tolerance = 1.0e-9 * std::max(std::max(maxX - minX, maxY - minY), 1.0);
+        const double minStep = std::fabs(end - start) * minRelativeStep;
+
+        // intervals starting at sample index, waiting to be bisected
+        struct Interval {
+            size_t index;
+            double t, x, y;
+            double deviation;
+            bool discontinuous;
+        };
+        std::vector<Interval> pending;
+        // intervals without evaluated midpoint
+        std::vector<size_t> fresh(t.size() - 1);
+        for (size_t i = 0; i < fresh.size(); ++i)
+            fresh[i] = i;
+
+        std::vector<double> mt, mx, my;
+        while (!fresh.empty() || !pending.empty()) {
+            mt.resize(fresh.size());
+            for (size_t i = 0; i < fresh.size(); ++i)
+                mt[i] = 0.5 * (t[fresh[i]] + t[fresh[i] + 1]);
+            evaluate(mt, mx, my);
+            for (size_t i = 0; i < fresh.size(); ++i) {
+                const size_t a = fresh[i];
+                const double d = deviation(x[a], y[a], mx[i], my[i], x[a + 1], y[a + 1]);
+                if (d <= tolerance)
+                    continue;
+                if (std::fabs(t[a + 1] - t[a]) <= minStep)
+                    breaks[a] = 1;
+                else
+                    pending.push_back({a, mt[i], mx[i], my[i], d,
+                                       isDiscontinuous(x[a], y[a], mx[i], my[i], x[a + 1], y[a + 1])});
+            }
+            fresh.clear();
+            if (pending.empty() || t.size() >= budget)
+                break;
+
+            const size_t count = std::min(pending.size(),
+                                          std::max<size_t>(1, (budget - t.size()) / 4));
+            std::partial_sort(pending.begin(), pending.begin() + count, pending.end(),
+                              [](const Interval& l, const Interval& r) {
+                return l.deviation > r.deviation;
+            });
+            std::sort(pending.begin(), pending.begin() + count,
+                      [](const Interval& l, const Interval& r) {
+                return l.index < r.index;
+            });
+
+            // insert the midpoints of the bisected intervals
+            std::vector<double> nt, nx, ny;
+            std::vector<char> nbreaks;
+            std::vector<size_t> moved(t.size());
+            const size_t size = t.size() + count;
+            nt.reserve(size);
+            nx.reserve(size);
+            ny.reserve(size);
+            nbreaks.reserve(size);
+            for (size_t i = 0, j = 0; i < t.size(); ++i) {
+                moved[i] = nt.size();
+                nt.push_back(t[i]);
+                nx.push_back(x[i]);
+                ny.push_back(y[i]);
+                nbreaks.push_back(breaks[i]);
+                if (j < count && pending[j].index == i) {
+                    fresh.push_back(nt.size() - 1);
+                    fresh.push_back(nt.size());
+                    nt.push_back(pending[j].t);
+                    nx.push_back(pending[j].x);
+                    ny.push_back(pending[j].y);
+                    nbreaks.push_back(0);
+                    ++j;
+                }
+            }
+            t.swap(nt);
+            x.swap(nx);
+            y.swap(ny);
+            breaks.swap(nbreaks);
+            pending.erase(pending.begin(), pending.begin() + count);
+            for (auto& interval: pending)
+                interval.index = moved[interval.index];
+        }
+
+        // the budget ran out before these converged
+        for (auto const& interval: pending) {
+            if (interval.discontinuous)
+                breaks[interval.index] = 1;
+        }
+    }
+
+    /*! Distance of the midpoint m from the chord between a and b. On short
+     * chords of a continuous curve m is about halfway between a and b, it
+     * stays at one end at jumps and lies beyond the chord at poles. Such
+     * chords deviate by their length, to be bisected down to the smallest
+     * step.
+     */
+    static double deviation(double ax, double ay, double mx, double my,
+                            double bx, double by)
+    {
+        const bool finiteA = std::isfinite(ax) && std::isfinite(ay);
+        const bool finiteM = std::isfinite(mx) && std::isfinite(my);
+        const bool finiteB = std::isfinite(bx) && std::isfinite(by);
+        if (!finiteA && !finiteM && !finiteB)
+            return 0.0;
+        if (!finiteA || !finiteM || !finiteB)
+            return std::numeric_limits<double>::infinity();
+        const double dx = bx - ax;
+        const double dy = by - ay;
+        const double length = std::hypot(dx, dy);
+        const double toA = std::hypot(mx - ax, my - ay);
+        const double toB = std::hypot(bx - mx, by - my);
+        if (length <= 0.0)
+            return toA;
+        if (std::max(toA, toB) > 0.75 * length)
+            return std::max(toA, toB);
+        return std::fabs((mx - ax) * dy - (my - ay) * dx) / length;
+    }
+
+    /*! true, if the midpoint m shows a jump or a pole between a and b: it is
+     * not finite while one end is, or it lies beyond the chord, see
+     * deviation().
+     */
+    static bool isDiscontinuous(double ax, double ay, double mx, double my,
+                                double bx, double by)
+    {
+        const bool finiteA = std::isfinite(ax) && std::isfinite(ay);
+        const bool finiteM = std::isfinite(mx) && std::isfinite(my);
+        const bool finiteB = std::isfinite(bx) && std::isfinite(by);
+        if (!finiteA || !finiteM || !finiteB)
+            return finiteA || finiteM || finiteB;
+        const double length = std::hypot(bx - ax, by - ay);
+        if (length <= 0.0)
+            return false;
+        return std::max(std::hypot(mx - ax, my - ay), std::hypot(bx - mx, by - my))
+                > 0.75 * length;
+    }
+
+    /*! Calls add for each continuous part of the curve, with the index of
+     * its first sample and the number of samples.
+     */
+    template<class Add>
+    void forEachPart(Add add) const
+    {
+        size_t first = 0;
+        for (size_t i = 0; i <= t.size(); ++i) {
+            const bool end = i == t.size() || !std::isfinite(x[i]) || !std::isfinite(y[i]);
+            if (end) {
+                if (i > first + 1)
+                    add(first, i - first);
+                first = i + 1;
+            } else if (breaks[i]) {
+                if (i > first)
+                    add(first, i + 1 - first);
+                first = i + 1;
+            }
+        }
+    }
+};
+}
+
 void plot::execComm(Document_Interface *doc, QWidget *parent, QString cmd)
 {
     Q_UNUSED(doc);
@@ -49,9 +335,7 @@ void plot::execComm(Document_Interface *doc, QWidget *parent, QString cmd)
     QString endValue;
     double stepSize;
 
-    QList<double> xValues;
-    QList<double> yValues1;
-    QList<double> yValues2;
+    Curve curve;
     plotDialog::EntityType lineType=plotDialog::Polyline;
 
     plotDialog plotDlg(parent);
@@ -66,60 +350,66 @@ void plot::execComm(Document_Interface *doc, QWidget *parent, QString cmd)
 
         try{
             mu::Parser p;
-            p.DefineConst(_T("pi"),M_PI);
-            p.DefineConst(_T("e"),M_E);
-            p.DefineVar(_T("x"), &equationVariable);
-            p.DefineVar(_T("t"), &equationVariable);
+            setupParser(p, &equationVariable);
             p.SetExpr(toMUPString(startValue));
             startVal = p.Eval();
 
             p.SetExpr(toMUPString(endValue));
             endVal = p.Eval();
 
-            p.SetExpr(toMUPString(equation1));
-
-            for(equationVariable = startVal; equationVariable <= endVal; equationVariable += stepSize)
-            {//calculate the values of the first equation
-                xValues.append(equationVariable);
-                yValues1.append(p.Eval());
+            // syntax errors are reported before sampling
+            curve.equation1 = toMUPString(equation1);
+            p.SetExpr(curve.equation1);
+            p.Eval();
+            if(!equation2.isEmpty())
+            {
+                curve.equation2 = toMUPString(equation2);
+                p.SetExpr(curve.equation2);
+                p.Eval();
             }
 
-            if(!equation2.isEmpty())
-            {//calculate the values of the second equation
-                p.SetExpr(toMUPString(equation2));
-                for(int i = 0; i < xValues.size(); ++i)
-                {
-                    equationVariable = xValues.at(i);
-                    yValues2.append(p.Eval());
-                }
+            if(stepSize <= 0.0 || endVal < startVal)
+            {
+                qDebug() << "no values to plot";
+                return;
             }
+
+            // the number of points of the step size, the adaptive sampling
+            // places them where the curve needs them
+            const size_t count = static_cast<size_t>(std::floor((endVal - startVal) / stepSize)) + 1;
+            const double lastVal = startVal + stepSize * (count - 1);
+            if (plotDlg.isAdaptive())
+                curve.sampleAdaptive(startVal, lastVal, count);
+            else
+                curve.sampleUniform(startVal, lastVal, count);
         }
         catch (mu::Parser::exception_type &e)
         {
             mu::console() << e.GetMsg() << std::endl;
         }
 
-        QList<double> const& xpoints=(equation2.isEmpty())?xValues:yValues1;
-        QList<double> const& ypoints=(equation2.isEmpty())?yValues1:yValues2;
-
-        if (lineType == plotDialog::LineSegments || lineType == plotDialog::SplinePoints){
-            std::vector<QPointF> points;
-            for(int i=0; i< xpoints.size(); ++i){
-                points.emplace_back(QPointF(xpoints[i], ypoints[i]));
-            }
-            if (lineType == plotDialog::SplinePoints){
-                //TODO add option for splinepoints: closed
-                //hardcoded to false now
-                doc->addSplinePoints(points, false);
-            } else
-                doc->addLines(points, false);
-        } else { //default plotDialog::Polyline
-            std::vector<Plug_VertexData> points;
-            for(int i=0; i< xpoints.size(); ++i){
-                points.emplace_back(Plug_VertexData(QPointF(xpoints[i], ypoints[i]), 0.0));
+        curve.forEachPart([&](size_t first, size_t size) {
+            if (lineType == plotDialog::LineSegments || lineType == plotDialog::SplinePoints){
+                std::vector<QPointF> points;
+                points.reserve(size);
+                for(size_t i = first; i < first + size; ++i){
+                    points.emplace_back(QPointF(curve.x[i], curve.y[i]));
+                }
+                if (lineType == plotDialog::SplinePoints){
+                    //TODO add option for splinepoints: closed
+                    //hardcoded to false now
+                    doc->addSplinePoints(points, false);
+                } else
+                    doc->addLines(points, false);
+            } else { //default plotDialog::Polyline
+                std::vector<Plug_VertexData> points;
+                points.reserve(size);
+                for(size_t i = first; i < first + size; ++i){
+                    points.emplace_back(Plug_VertexData(QPointF(curve.x[i], curve.y[i]), 0.0));
+                }
+                doc->addPolyline(points, false);
             }
-            doc->addPolyline(points, false);
-        }
+        });
 
     }
 
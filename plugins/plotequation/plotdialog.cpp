@@ -5,6 +5,7 @@
 #include <QLineEdit>
 #include <QPushButton>
 #include <QComboBox>
+#include <QCheckBox>
 #include <QDebug>
 
 Q_DECLARE_METATYPE(plotDialog::EntityType)
@@ -63,6 +64,10 @@ plotDialog::plotDialog(QWidget *parent) :
 
     mainLayout->addWidget(m_pTypeSelection, 7, 0);
 
+    chkAdaptive = new QCheckBox(tr("adaptive sampling"), this);
+    chkAdaptive->setToolTip(tr("Places the points of the step size where the curve bends or jumps"));
+    mainLayout->addWidget(chkAdaptive, 7, 1);
+
     buttonLayout->addWidget(btnAccept);
     buttonLayout->addWidget(btnCancel);
 
@@ -81,6 +86,11 @@ plotDialog::EntityType plotDialog::getEntityType() const
     return m_pTypeSelection->itemData(m_pTypeSelection->currentIndex()).value<plotDialog::EntityType>();
 }
 
+bool plotDialog::isAdaptive() const
+{
+    return chkAdaptive->isChecked();
+}
+
 //get the valuew that the user entered
 void plotDialog::getValues(QString& eq1, QString& eq2, QString& start, QString& end, double& step) const
 {
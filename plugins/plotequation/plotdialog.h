@@ -11,6 +11,7 @@ class QPushButton;
 class QHBoxLayout;
 class QSpacerItem;
 class QComboBox;
+class QCheckBox;
 
 
 class plotDialog : public QDialog
@@ -27,6 +28,8 @@ public:
     ~plotDialog()=default;
     void getValues(QString& eq1, QString& eq2, QString &start, QString &end, double& step) const;
     EntityType getEntityType() const;
+    //! sample where the curve bends or jumps instead of at every step
+    bool isAdaptive() const;
 
 public slots:
     void slotDrawButtonClicked();
@@ -54,6 +57,7 @@ private:
     QPushButton* btnCancel;
     QSpacerItem* space;
     QComboBox* m_pTypeSelection;
+    QCheckBox* chkAdaptive;
 
     bool readInput();
 